@@ -0,0 +1,304 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        elf_batch.c            *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "elf_batch.h"
+#include "../elf_reader/elf_reader.h"
+#include "../../../Task3/thread_pool/thread_pool.h"      /* Shared with the shell's scp -r */
+#include "../../../Task3/exit_status.h"
+
+/*****************************            Types                  ********************************/
+
+/* Text of one record, cut when it would not fit in size bytes */
+typedef struct {
+    char *data;
+    size_t size;
+    size_t len;
+    int truncated;
+} Record;
+
+/*****************************        Global Variables           ********************************/
+
+/* nftw() has no user pointer, so the state of the running batch lives here (one batch at a time) */
+static ThreadPool batch_pool;
+static ElfRecordFormat batch_format;
+static pthread_mutex_t output_lock = PTHREAD_MUTEX_INITIALIZER;
+static int batch_errors;            /* Updated atomically by the workers */
+
+/*****************************        Static Functions           ********************************/
+
+static void record_append(Record *record, const char *format, ...)
+{
+    va_list args;
+    size_t space = record->size - record->len;
+
+    va_start(args, format);
+    int len = vsnprintf(record->data + record->len, space, format, args);
+    va_end(args);
+
+    if (len < 0 || (size_t)len >= space) {
+        record->truncated = 1;
+        record->len = record->size - 1;
+    } else {
+        record->len += len;
+    }
+}
+
+/* Appends a string quoted for the output format (JSON string or CSV field) */
+static void record_append_string(Record *record, const char *text)
+{
+    if (batch_format == ELF_RECORD_CSV) {
+        if (strpbrk(text, ",\"\r\n") == NULL) {
+            record_append(record, "%s", text);
+            return;
+        }
+        record_append(record, "\"");
+        for (const char *p = text; *p != '\0'; p++) {
+            record_append(record, (*p == '"') ? "\"\"" : "%c", *p);
+        }
+        record_append(record, "\"");
+        return;
+    }
+
+    record_append(record, "\"");
+    for (const unsigned char *p = (const unsigned char *)text; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') {
+            record_append(record, "\\%c", *p);
+        } else if (*p < 0x20) {
+            record_append(record, "\\u%04x", *p);
+        } else {
+            record_append(record, "%c", *p);
+        }
+    }
+    record_append(record, "\"");
+}
+
+/* Appends "name": for JSON, or the separator before the field for CSV */
+static void record_field(Record *record, const char *name)
+{
+    int first = (record->len == 0);
+
+    if (batch_format == ELF_RECORD_CSV) {
+        if (!first) {
+            record_append(record, ",");
+        }
+    } else {
+        record_append(record, first ? "{\"%s\":" : ",\"%s\":", name);
+    }
+}
+
+static const char *type_name(uint16_t type)
+{
+    switch (type) {
+    case ET_REL:    return "REL";
+    case ET_EXEC:   return "EXEC";
+    case ET_DYN:    return "DYN";
+    case ET_CORE:   return "CORE";
+    default:        return "UNKNOWN";
+    }
+}
+
+/* A file is stripped when it has no .symtab (.dynsym is kept by strip) */
+static int is_stripped(const ElfFile *elf)
+{
+    ElfSection section;
+
+    for (size_t i = 0; i < elf->sections.count; i++) {
+        elf_section(elf, i, &section);
+        if (section.type == SHT_SYMTAB) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Builds the record of a file; elf is NULL when it could not be opened and error says why */
+static void build_record(Record *record, const char *path, const ElfFile *elf, const char *error)
+{
+    record->len = 0;
+    record->truncated = 0;
+
+    record_field(record, "path");
+    record_append_string(record, path);
+
+    if (elf != NULL) {
+        const ElfHeader *header = &elf->header;
+
+        record_field(record, "class");
+        record_append_string(record, header->ident[EI_CLASS] == ELFCLASS32 ? "ELF32" : "ELF64");
+        record_field(record, "data");
+        record_append_string(record, header->ident[EI_DATA] == ELFDATA2MSB ? "BE" : "LE");
+        record_field(record, "type");
+        record_append_string(record, type_name(header->type));
+        record_field(record, "machine");
+        record_append(record, "%u", header->machine);
+        record_field(record, "entry");
+        record_append(record, batch_format == ELF_RECORD_CSV ? "0x%" PRIx64 : "\"0x%" PRIx64 "\"", header->entry);
+        record_field(record, "sections");
+        record_append(record, "%zu", elf->sections.count);
+        record_field(record, "stripped");
+        record_append(record, "%s", is_stripped(elf) ? "true" : "false");
+        record_field(record, "error");
+        record_append(record, "%s", batch_format == ELF_RECORD_CSV ? "" : "null");
+    } else {
+        static const char *fields[] = { "class", "data", "type", "machine", "entry", "sections", "stripped" };
+        for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+            record_field(record, fields[i]);
+            record_append(record, "%s", batch_format == ELF_RECORD_CSV ? "" : "null");
+        }
+        record_field(record, "error");
+        record_append_string(record, error);
+    }
+
+    record_append(record, batch_format == ELF_RECORD_CSV ? "\n" : "}\n");
+}
+
+static void write_record(const char *path, const ElfFile *elf, const char *error)
+{
+    char buffer[ELF_BATCH_RECORD_SIZE];
+    Record record = { .data = buffer, .size = sizeof(buffer) };
+    char *grown = NULL;
+
+    /* A long path (or one with many escaped characters) is rebuilt in a larger buffer */
+    build_record(&record, path, elf, error);
+    while (record.truncated) {
+        char *data = realloc(grown, record.size * 2);
+        if (data == NULL) {
+            perror("Failed to allocate memory");
+            free(grown);
+            __atomic_add_fetch(&batch_errors, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        grown = data;
+        record.data = data;
+        record.size *= 2;
+        build_record(&record, path, elf, error);
+    }
+
+    /* Whole records only, the workers finish in any order */
+    pthread_mutex_lock(&output_lock);
+    fwrite(record.data, 1, record.len, stdout);
+    pthread_mutex_unlock(&output_lock);
+    free(grown);
+}
+
+static void parse_file_task(void *arg)
+{
+    char *path = arg;
+    ElfFile elf;
+
+    ElfStatus status = elf_open(&elf, path);
+    if (status == ELF_OK) {
+        write_record(path, &elf, NULL);
+        elf_close(&elf);
+    } else {
+        write_record(path, NULL, status == ELF_ERROR_OPEN ? strerror(errno) : elf_status_string(status));
+        __atomic_add_fetch(&batch_errors, 1, __ATOMIC_RELAXED);
+    }
+
+    free(path);
+}
+
+/* Reads the first 4 bytes, most files of a root filesystem are rejected here */
+static int has_elf_magic(const char *path)
+{
+    unsigned char magic[SELFMAG];
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t bytes_read = pread(fd, magic, sizeof(magic), 0);
+    close(fd);
+
+    if (bytes_read < 0) {
+        return -1;
+    }
+    return bytes_read == sizeof(magic) && memcmp(magic, ELFMAG, SELFMAG) == 0;
+}
+
+static int visit(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf)
+{
+    (void)ftwbuf;
+
+    switch (typeflag) {
+    case FTW_F: {
+        if (!S_ISREG(sb->st_mode) || sb->st_size < SELFMAG) {
+            return FTW_CONTINUE;
+        }
+
+        int elf = has_elf_magic(fpath);
+        if (elf < 0) {
+            write_record(fpath, NULL, strerror(errno));
+            __atomic_add_fetch(&batch_errors, 1, __ATOMIC_RELAXED);
+        } else if (elf) {
+            char *path = strdup(fpath);
+            if (path == NULL) {
+                perror("Failed to allocate memory");
+                return FTW_STOP;
+            }
+            thread_pool_submit(&batch_pool, parse_file_task, path);
+        }
+        return FTW_CONTINUE;
+    }
+
+    case FTW_DNR:
+    case FTW_NS:
+        write_record(fpath, NULL, strerror(errno));
+        __atomic_add_fetch(&batch_errors, 1, __ATOMIC_RELAXED);
+        return FTW_CONTINUE;
+
+    default:
+        return FTW_CONTINUE;        /* Directories and symbolic links */
+    }
+}
+
+/*****************************        Public Functions           ********************************/
+
+int elf_batch_run(const char *root, int num_threads, ElfRecordFormat format)
+{
+    batch_format = format;
+    batch_errors = 0;
+
+    if (thread_pool_init(&batch_pool, num_threads) != S_EXIT_SUCCESS) {
+        perror("Failed to start the workers");
+        return 1;
+    }
+
+    if (format == ELF_RECORD_CSV) {
+        printf("path,class,data,type,machine,entry,sections,stripped,error\n");
+    }
+
+    int ret = nftw(root, visit, ELF_BATCH_OPEN_FDS, FTW_PHYS | FTW_ACTIONRETVAL);
+    if (ret < 0) {
+        perror(root);
+    }
+
+    thread_pool_wait(&batch_pool);
+    thread_pool_destroy(&batch_pool);
+    fflush(stdout);
+
+    return (ret != 0 || batch_errors != 0) ? 1 : 0;
+}
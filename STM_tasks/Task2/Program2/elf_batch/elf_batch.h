@@ -0,0 +1,41 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        elf_batch.h            *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef ELF_BATCH_H
+#define ELF_BATCH_H
+
+/* Maximum number of directories nftw keeps open while walking the tree */
+#define ELF_BATCH_OPEN_FDS          64
+
+/* Size of the record buffer of a file, longer records are rebuilt in a larger heap buffer */
+#define ELF_BATCH_RECORD_SIZE       8192
+
+typedef enum {
+    ELF_RECORD_JSON,                /* One JSON object per line */
+    ELF_RECORD_CSV                  /* A header line, then one line per file */
+} ElfRecordFormat;
+
+/**
+ * @brief Prints one record for every ELF file under a directory.
+ *
+ * The tree is walked without following symbolic links. Regular files are rejected by a
+ * 4-byte pread of their magic number when they are not ELF, the ELF ones are parsed by a
+ * pool of workers. Records are written to stdout in completion order: path, class, data,
+ * type, machine, entry, number of sections, stripped (no .symtab) and error.
+ *
+ * @param root The directory to walk.
+ * @param num_threads Number of workers.
+ * @param format Format of the records.
+ * @return int 0, or 1 if a directory or a file could not be read (it still gets a record).
+ */
+int elf_batch_run(const char *root, int num_threads, ElfRecordFormat format);
+
+#endif
@@ -0,0 +1,500 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        elf_lookup.c           *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "elf_lookup.h"
+
+/*****************************        Static Functions           ********************************/
+
+/* The hash function of .gnu.hash, also used for the table built over .symtab */
+static uint32_t gnu_hash(const char *name)
+{
+    uint32_t hash = 5381;
+
+    for (const unsigned char *p = (const unsigned char *)name; *p != '\0'; p++) {
+        hash = hash * 33 + *p;
+    }
+    return hash;
+}
+
+/* The hash function of the System V .hash section */
+static uint32_t sysv_hash(const char *name)
+{
+    uint32_t hash = 0;
+
+    for (const unsigned char *p = (const unsigned char *)name; *p != '\0'; p++) {
+        hash = (hash << 4) + *p;
+        uint32_t high = hash & 0xf0000000;
+        if (high != 0) {
+            hash ^= high >> 24;
+        }
+        hash &= ~high;
+    }
+    return hash;
+}
+
+/* Decodes a symbol of a table and tells if it is defined with this name */
+static int symbol_matches(const ElfFile *elf, const ElfSymbolTable *table, size_t index,
+                          const char *name, ElfLookupMatch *match)
+{
+    elf_symbol(elf, table, index, &match->symbol);
+    if (match->symbol.shndx == SHN_UNDEF) {
+        return 0;
+    }
+
+    const char *symbol_name = elf_string(table->strings, table->strings_size, match->symbol.name);
+    if (symbol_name == NULL || strcmp(symbol_name, name) != 0) {
+        return 0;
+    }
+    match->name = symbol_name;
+    return 1;
+}
+
+/* Tells if a symbol of the hash section is a hidden (non-default) version */
+static int is_hidden_version(const ElfLookup *lookup, size_t index)
+{
+    const ElfHashSection *hash = &lookup->hash;
+
+    if (index >= hash->version_count) {
+        return 0;
+    }
+    return (lookup->elf->decoder->half(hash->versions + index * sizeof(uint16_t)) & ELF_VERSYM_HIDDEN) != 0;
+}
+
+/* Checks a symbol of a hash chain: a default version ends the search, the first hidden one is
+ * kept in case the chain has no default one */
+static int hash_candidate(const ElfLookup *lookup, size_t index, const char *name, ElfLookupMatch *match,
+                          ElfLookupMatch *hidden, int *hidden_found)
+{
+    if (!symbol_matches(lookup->elf, &lookup->hash.table, index, name, match)) {
+        return 0;
+    }
+    if (!is_hidden_version(lookup, index)) {
+        return 1;
+    }
+    if (!*hidden_found) {
+        *hidden = *match;
+        *hidden_found = 1;
+    }
+    return 0;
+}
+
+/* Reads .gnu.version when it belongs to the symbol table of the hash section */
+static void open_versions(ElfLookup *lookup, uint32_t symbols_index)
+{
+    const ElfFile *elf = lookup->elf;
+    ElfSection section;
+    const void *data;
+    size_t size;
+
+    if (elf_find_section(elf, ".gnu.version", &section) < 0 || section.type != SHT_GNU_versym ||
+        section.link != symbols_index || elf_section_data(elf, &section, &data, &size) != ELF_OK) {
+        return;
+    }
+    lookup->hash.versions = data;
+    lookup->hash.version_count = size / sizeof(uint16_t);
+}
+
+/* Reads the header of a .gnu.hash section and checks its tables are inside of it */
+static ElfStatus open_gnu_hash(const ElfFile *elf, const unsigned char *data, size_t size, ElfHashSection *hash)
+{
+    const ElfDecoder *decoder = elf->decoder;
+
+    if (size < 4 * sizeof(uint32_t)) {
+        return ELF_ERROR_BAD_TABLE;
+    }
+    hash->bucket_count = decoder->word(data);
+    hash->symbol_offset = decoder->word(data + 4);
+    hash->bloom_size = decoder->word(data + 8);
+    hash->bloom_shift = decoder->word(data + 12);
+
+    uint64_t bloom_bytes = (uint64_t)hash->bloom_size * decoder->address_size;
+    uint64_t bucket_bytes = (uint64_t)hash->bucket_count * sizeof(uint32_t);
+    if (hash->bucket_count == 0 || hash->bloom_size == 0 || hash->bloom_shift >= 32 ||
+        16 + bloom_bytes + bucket_bytes > size) {
+        return ELF_ERROR_BAD_TABLE;
+    }
+
+    hash->bloom = data + 16;
+    hash->buckets = hash->bloom + bloom_bytes;
+    hash->chains = hash->buckets + bucket_bytes;
+    hash->chain_count = (size - 16 - bloom_bytes - bucket_bytes) / sizeof(uint32_t);
+    return ELF_OK;
+}
+
+/* Reads the header of a .hash section and checks its tables are inside of it */
+static ElfStatus open_sysv_hash(const ElfFile *elf, const unsigned char *data, size_t size, ElfHashSection *hash)
+{
+    if (size < 2 * sizeof(uint32_t)) {
+        return ELF_ERROR_BAD_TABLE;
+    }
+    hash->bucket_count = elf->decoder->word(data);
+    hash->chain_count = elf->decoder->word(data + 4);
+
+    if (hash->bucket_count == 0 || 2 + (uint64_t)hash->bucket_count + hash->chain_count > size / sizeof(uint32_t)) {
+        return ELF_ERROR_BAD_TABLE;
+    }
+
+    hash->buckets = data + 8;
+    hash->chains = hash->buckets + (size_t)hash->bucket_count * sizeof(uint32_t);
+    return ELF_OK;
+}
+
+/* Uses .gnu.hash, or .hash, and the symbol table it is linked to */
+static ElfStatus open_hash_section(ElfLookup *lookup)
+{
+    const ElfFile *elf = lookup->elf;
+    ElfSection section, symbols;
+    const void *data;
+    size_t size;
+    ElfStatus status;
+
+    if (elf_find_section(elf, ".gnu.hash", &section) >= 0 && section.type == SHT_GNU_HASH) {
+        lookup->hash_name = ".gnu.hash";
+    } else if (elf_find_section(elf, ".hash", &section) >= 0 && section.type == SHT_HASH) {
+        lookup->hash_name = ".hash";
+    } else {
+        return ELF_OK;
+    }
+
+    if (section.link >= elf->sections.count) {
+        return ELF_ERROR_BAD_TABLE;
+    }
+    elf_section(elf, section.link, &symbols);
+    status = elf_symbol_table(elf, &symbols, &lookup->hash.table);
+    if (status == ELF_OK) {
+        status = elf_section_data(elf, &section, &data, &size);
+    }
+    if (status != ELF_OK) {
+        return status;
+    }
+    open_versions(lookup, section.link);
+
+    if (section.type == SHT_GNU_HASH) {
+        return open_gnu_hash(elf, data, size, &lookup->hash);
+    }
+    return open_sysv_hash(elf, data, size, &lookup->hash);
+}
+
+static int lookup_gnu_hash(const ElfLookup *lookup, const char *name, ElfLookupMatch *match)
+{
+    const ElfHashSection *hash = &lookup->hash;
+    const ElfDecoder *decoder = lookup->elf->decoder;
+    uint32_t hash_value = gnu_hash(name);
+    uint32_t word_bits = decoder->address_size * 8;
+    ElfLookupMatch hidden;
+    int hidden_found = 0;
+
+    /* Two bits of the bloom filter reject most of the missing names without touching the buckets */
+    uint64_t word = decoder->address(hash->bloom + ((hash_value / word_bits) % hash->bloom_size) * decoder->address_size);
+    uint64_t mask = (1ULL << (hash_value % word_bits)) | (1ULL << ((hash_value >> hash->bloom_shift) % word_bits));
+    if ((word & mask) != mask) {
+        return 0;
+    }
+
+    uint32_t index = decoder->word(hash->buckets + (hash_value % hash->bucket_count) * sizeof(uint32_t));
+    if (index < hash->symbol_offset) {
+        return 0;
+    }
+
+    /* The chain holds the hashes of the bucket's symbols, the last one has its low bit set */
+    for (; index - hash->symbol_offset < hash->chain_count && index < hash->table.symbols.count; index++) {
+        uint32_t chain_value = decoder->word(hash->chains + (index - hash->symbol_offset) * sizeof(uint32_t));
+        if ((chain_value | 1) == (hash_value | 1) && hash_candidate(lookup, index, name, match, &hidden, &hidden_found)) {
+            return 1;
+        }
+        if (chain_value & 1) {
+            break;
+        }
+    }
+
+    if (hidden_found) {
+        *match = hidden;
+    }
+    return hidden_found;
+}
+
+static int lookup_sysv_hash(const ElfLookup *lookup, const char *name, ElfLookupMatch *match)
+{
+    const ElfHashSection *hash = &lookup->hash;
+    const ElfDecoder *decoder = lookup->elf->decoder;
+    size_t limit = hash->chain_count < hash->table.symbols.count ? hash->chain_count : hash->table.symbols.count;
+
+    ElfLookupMatch hidden;
+    int hidden_found = 0;
+
+    uint32_t index = decoder->word(hash->buckets + (sysv_hash(name) % hash->bucket_count) * sizeof(uint32_t));
+
+    /* A corrupted chain could loop, it can not be longer than the table */
+    for (size_t steps = 0; index != STN_UNDEF && index < limit && steps < limit; steps++) {
+        if (hash_candidate(lookup, index, name, match, &hidden, &hidden_found)) {
+            return 1;
+        }
+        index = decoder->word(hash->chains + (size_t)index * sizeof(uint32_t));
+    }
+
+    if (hidden_found) {
+        *match = hidden;
+    }
+    return hidden_found;
+}
+
+/* Builds an open addressing hash table over the defined symbols of a table */
+static ElfStatus build_names(ElfLookup *lookup, const ElfSection *section)
+{
+    const ElfFile *elf = lookup->elf;
+    ElfSymbolTable *table = &lookup->names_table;
+    ElfSymbol symbol;
+
+    ElfStatus status = elf_symbol_table(elf, section, table);
+    if (status != ELF_OK || table->symbols.count <= 1) {
+        return status;
+    }
+
+    /* At most half full, so the probes stay short */
+    size_t slot_count = 2;
+    while (slot_count < 2 * table->symbols.count) {
+        slot_count *= 2;
+    }
+    lookup->names = calloc(slot_count, sizeof(*lookup->names));
+    if (lookup->names == NULL) {
+        errno = ENOMEM;
+        return ELF_ERROR_OPEN;
+    }
+    lookup->names_mask = slot_count - 1;
+
+    for (size_t i = 1; i < table->symbols.count; i++) {
+        elf_symbol(elf, table, i, &symbol);
+        const char *name = elf_string(table->strings, table->strings_size, symbol.name);
+        if (symbol.shndx == SHN_UNDEF || name == NULL || name[0] == '\0') {
+            continue;
+        }
+
+        uint32_t hash = gnu_hash(name);
+        size_t slot = hash & lookup->names_mask;
+        while (lookup->names[slot].symbol != 0) {
+            slot = (slot + 1) & lookup->names_mask;
+        }
+        lookup->names[slot] = (ElfNameSlot) { hash, (uint32_t)i };
+    }
+    return ELF_OK;
+}
+
+static int lookup_names(const ElfLookup *lookup, const char *name, ElfLookupMatch *match)
+{
+    uint32_t hash = gnu_hash(name);
+
+    for (size_t slot = hash & lookup->names_mask; lookup->names[slot].symbol != 0; slot = (slot + 1) & lookup->names_mask) {
+        if (lookup->names[slot].hash == hash &&
+            symbol_matches(lookup->elf, &lookup->names_table, lookup->names[slot].symbol, name, match)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Orders by address; at the same address the entry returned by the search (the last) is the
+ * one with a size, then the global one */
+static int compare_address(const void *a, const void *b)
+{
+    const ElfAddressEntry *left = a;
+    const ElfAddressEntry *right = b;
+    static const int bind_rank[] = { [STB_LOCAL] = 0, [STB_GLOBAL] = 2, [STB_WEAK] = 1 };
+
+    if (left->value != right->value) {
+        return left->value < right->value ? -1 : 1;
+    }
+    if ((left->size != 0) != (right->size != 0)) {
+        return left->size != 0 ? 1 : -1;
+    }
+
+    unsigned char left_bind = ELF64_ST_BIND(left->info);
+    unsigned char right_bind = ELF64_ST_BIND(right->info);
+    int left_rank = left_bind <= STB_WEAK ? bind_rank[left_bind] : 0;
+    int right_rank = right_bind <= STB_WEAK ? bind_rank[right_bind] : 0;
+    if (left_rank != right_rank) {
+        return left_rank - right_rank;
+    }
+    return left->symbol < right->symbol ? -1 : (left->symbol > right->symbol);
+}
+
+/* Functions, objects and code labels that are defined in a section ($ mapping symbols of ARM excluded) */
+static int is_addressable(const ElfSymbol *symbol, const char *name)
+{
+    if (symbol->shndx == SHN_UNDEF || symbol->shndx >= SHN_LORESERVE || name == NULL || name[0] == '\0') {
+        return 0;
+    }
+
+    switch (ELF64_ST_TYPE(symbol->info)) {
+    case STT_FUNC:
+    case STT_OBJECT:
+    case STT_GNU_IFUNC:
+        return 1;
+    case STT_NOTYPE:
+        return name[0] != '$';
+    default:
+        return 0;
+    }
+}
+
+static ElfStatus build_addresses(ElfLookup *lookup)
+{
+    const ElfFile *elf = lookup->elf;
+    ElfSymbolTable *table = &lookup->addresses_table;
+    ElfSection section;
+    ElfSymbol symbol;
+
+    if (elf_find_section(elf, ".symtab", &section) >= 0) {
+        lookup->addresses_source = ".symtab";
+    } else if (elf_find_section(elf, ".dynsym", &section) >= 0) {
+        lookup->addresses_source = ".dynsym";
+    } else {
+        return ELF_OK;
+    }
+
+    ElfStatus status = elf_symbol_table(elf, &section, table);
+    if (status != ELF_OK || table->symbols.count == 0) {
+        return status;
+    }
+
+    lookup->addresses = malloc(table->symbols.count * sizeof(*lookup->addresses));
+    if (lookup->addresses == NULL) {
+        errno = ENOMEM;
+        return ELF_ERROR_OPEN;
+    }
+
+    for (size_t i = 1; i < table->symbols.count; i++) {
+        elf_symbol(elf, table, i, &symbol);
+        if (is_addressable(&symbol, elf_string(table->strings, table->strings_size, symbol.name))) {
+            lookup->addresses[lookup->address_count++] = (ElfAddressEntry) {
+                symbol.value, symbol.size, (uint32_t)i, symbol.info
+            };
+        }
+    }
+
+    qsort(lookup->addresses, lookup->address_count, sizeof(*lookup->addresses), compare_address);
+    return ELF_OK;
+}
+
+/*****************************        Public Functions           ********************************/
+
+ElfStatus elf_lookup_open(ElfLookup *lookup, const ElfFile *elf, int flags)
+{
+    ElfSection section;
+    ElfStatus status = ELF_OK;
+
+    memset(lookup, 0, sizeof(*lookup));
+    lookup->elf = elf;
+
+    if (flags & ELF_LOOKUP_NAMES) {
+        /* A corrupted hash section is only an accelerator lost, the symbol table is searched instead */
+        if (open_hash_section(lookup) != ELF_OK) {
+            lookup->hash_name = NULL;
+            memset(&lookup->hash, 0, sizeof(lookup->hash));
+        }
+
+        /* The hash section only covers the exported symbols, the local ones are in .symtab */
+        if (elf_find_section(elf, ".symtab", &section) >= 0) {
+            lookup->names_source = ".symtab";
+            status = build_names(lookup, &section);
+        } else if (lookup->hash_name == NULL && elf_find_section(elf, ".dynsym", &section) >= 0) {
+            lookup->names_source = ".dynsym";
+            status = build_names(lookup, &section);
+        }
+    }
+
+    if (status == ELF_OK && (flags & ELF_LOOKUP_ADDRESSES)) {
+        status = build_addresses(lookup);
+    }
+
+    if (status != ELF_OK) {
+        int saved_errno = errno;
+        elf_lookup_close(lookup);
+        errno = saved_errno;
+    }
+    return status;
+}
+
+void elf_lookup_close(ElfLookup *lookup)
+{
+    free(lookup->names);
+    free(lookup->addresses);
+    lookup->names = NULL;
+    lookup->names_mask = 0;
+    lookup->addresses = NULL;
+    lookup->address_count = 0;
+}
+
+int elf_lookup_name(const ElfLookup *lookup, const char *name, ElfLookupMatch *match)
+{
+    int found = 0;
+
+    if (lookup->hash_name != NULL) {
+        found = (lookup->hash.bloom != NULL) ? lookup_gnu_hash(lookup, name, match)
+                                             : lookup_sysv_hash(lookup, name, match);
+        if (found) {
+            match->source = lookup->hash_name;
+            return 1;
+        }
+    }
+
+    if (lookup->names != NULL && lookup_names(lookup, name, match)) {
+        match->source = lookup->names_source;
+        return 1;
+    }
+    return 0;
+}
+
+int elf_lookup_address(const ElfLookup *lookup, uint64_t address, ElfLookupMatch *match, uint64_t *offset)
+{
+    size_t low = 0, high = lookup->address_count;
+
+    /* First entry above the address, the candidate is the one before it */
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (lookup->addresses[middle].value <= address) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == 0) {
+        return 0;
+    }
+
+    const ElfAddressEntry *entry = &lookup->addresses[low - 1];
+    if (entry->size != 0 && address - entry->value >= entry->size) {
+        return 0;
+    }
+
+    elf_symbol(lookup->elf, &lookup->addresses_table, entry->symbol, &match->symbol);
+
+    /* Without a size, the symbol can not go past the end of its section */
+    if (entry->size == 0 && match->symbol.shndx < lookup->elf->sections.count) {
+        ElfSection section;
+        elf_section(lookup->elf, match->symbol.shndx, &section);
+        if (address < section.addr || address - section.addr >= section.size) {
+            return 0;
+        }
+    }
+
+    match->name = elf_string(lookup->addresses_table.strings, lookup->addresses_table.strings_size,
+                             match->symbol.name);
+    match->source = lookup->addresses_source;
+    *offset = address - entry->value;
+    return 1;
+}
@@ -0,0 +1,120 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        elf_lookup.h           *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef ELF_LOOKUP_H
+#define ELF_LOOKUP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../elf_reader/elf_reader.h"
+
+/* Indexes built by elf_lookup_open() */
+#define ELF_LOOKUP_NAMES            0x1     /* Lookup by name */
+#define ELF_LOOKUP_ADDRESSES        0x2     /* Lookup by address */
+
+/* Bit of a .gnu.version entry set on the non-default versions of a symbol (memcpy@GLIBC_2.2.5) */
+#define ELF_VERSYM_HIDDEN           0x8000
+
+/* A slot of the name hash table built over the symbol table, symbol 0 marks an empty slot */
+typedef struct {
+    uint32_t hash;
+    uint32_t symbol;
+} ElfNameSlot;
+
+/* A defined function or object of the address index */
+typedef struct {
+    uint64_t value;
+    uint64_t size;
+    uint32_t symbol;
+    unsigned char info;
+} ElfAddressEntry;
+
+/* The hash section of the dynamic symbols, read in place from the mapping */
+typedef struct {
+    ElfSymbolTable table;           /* .dynsym */
+    const unsigned char *bloom;     /* .gnu.hash only, bloom_size address-sized words */
+    const unsigned char *buckets;
+    const unsigned char *chains;
+    uint32_t bucket_count;
+    uint32_t chain_count;
+    uint32_t symbol_offset;         /* .gnu.hash only, first symbol in the hash table */
+    uint32_t bloom_size;
+    uint32_t bloom_shift;
+    const unsigned char *versions;  /* .gnu.version, one 16-bit entry per symbol, NULL if missing */
+    size_t version_count;
+} ElfHashSection;
+
+/* Indexes over the symbols of a mapped file */
+typedef struct {
+    const ElfFile *elf;
+
+    const char *hash_name;          /* ".gnu.hash", ".hash" or NULL when there is none */
+    ElfHashSection hash;
+
+    ElfSymbolTable names_table;     /* Searched when the hash section does not know the name */
+    const char *names_source;       /* ".symtab", or ".dynsym" when the file has no hash section */
+    ElfNameSlot *names;
+    size_t names_mask;              /* Number of slots - 1 (a power of 2), 0 without table */
+
+    ElfSymbolTable addresses_table;
+    const char *addresses_source;   /* ".symtab", or ".dynsym" when the file is stripped */
+    ElfAddressEntry *addresses;     /* Sorted by value */
+    size_t address_count;
+} ElfLookup;
+
+/* A symbol found by one of the lookups */
+typedef struct {
+    ElfSymbol symbol;
+    const char *name;
+    const char *source;             /* The table it was found with: .gnu.hash, .hash, .symtab or .dynsym */
+} ElfLookupMatch;
+
+/**
+ * @brief Prepares the symbol indexes of a file.
+ *
+ * ELF_LOOKUP_NAMES uses the .gnu.hash (or .hash) section of the file as it is mapped, and
+ * builds a hash table over .symtab for the symbols that are not exported. ELF_LOOKUP_ADDRESSES
+ * sorts the defined functions and objects by address. Both are built once, the lookups do
+ * not allocate.
+ *
+ * @param flags ELF_LOOKUP_NAMES and/or ELF_LOOKUP_ADDRESSES.
+ * @return ElfStatus ELF_OK, the error of a corrupted table, or ELF_ERROR_OPEN with errno
+ *         ENOMEM if an index could not be allocated.
+ */
+ElfStatus elf_lookup_open(ElfLookup *lookup, const ElfFile *elf, int flags);
+
+/**
+ * @brief Frees the indexes.
+ */
+void elf_lookup_close(ElfLookup *lookup);
+
+/**
+ * @brief Finds a defined symbol by name.
+ *
+ * Like the dynamic linker, the default version of a versioned symbol is preferred to the hidden
+ * ones (memcpy@@GLIBC_2.14 rather than memcpy@GLIBC_2.2.5).
+ *
+ * @return int 1 if the symbol was found (match is filled), 0 otherwise.
+ */
+int elf_lookup_name(const ElfLookup *lookup, const char *name, ElfLookupMatch *match);
+
+/**
+ * @brief Finds the function or object containing an address, by binary search.
+ *
+ * A symbol without size contains the addresses up to the next symbol or the end of its section.
+ *
+ * @param offset Set to the distance between the address and the symbol.
+ * @return int 1 if a symbol was found (match is filled), 0 otherwise.
+ */
+int elf_lookup_address(const ElfLookup *lookup, uint64_t address, ElfLookupMatch *match, uint64_t *offset);
+
+#endif
@@ -1,73 +1,16 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
 
-// Define ELF header constants
-#define EI_NIDENT 16
-
-#define EI_MAG0         0               /* File identification byte 0 index */
-#define ELFMAG0         0x7f            /* Magic number byte 0 */
-
-#define EI_MAG1         1               /* File identification byte 1 index */
-#define ELFMAG1         'E'             /* Magic number byte 1 */
-
-#define EI_MAG2         2               /* File identification byte 2 index */
-#define ELFMAG2         'L'             /* Magic number byte 2 */
-
-#define EI_MAG3         3               /* File identification byte 3 index */
-#define ELFMAG3         'F'             /* Magic number byte 3 */
-
-
-// ELF file types
-#define ET_NONE         0               /* No file type */
-#define ET_REL          1               /* Relocatable file */
-#define ET_EXEC         2               /* Executable file */
-#define ET_DYN          3               /* Shared object file */
-#define ET_CORE         4               /* Core file */
-#define ET_NUM          5               /* Number of defined types */
-#define ET_LOOS         0xfe00          /* OS-specific range start */
-#define ET_HIOS         0xfeff          /* OS-specific range end */
-#define ET_LOPROC       0xff00          /* Processor-specific range start */
-#define ET_HIPROC       0xffff          /* Processor-specific range end */
-
-
-// ELF machine types
-#define EM_NONE 0
-#define EM_M32 1
-#define EM_SPARC 2
-#define EM_386 3
-#define EM_68K 4
-#define EM_88K 5
-#define EM_860 7
-#define EM_MIPS 8
-#define EM_S390 22
-#define EM_ARM 40
-#define EM_ALPHA 41
-#define EM_SH 42
-#define EM_SPARCV9 43
-#define EM_IA_64 50
-#define EM_X86_64 62
-#define EM_PPC 20
-#define EM_PPC64 21
-#define EM_RISCV 243
-
-// ELF header structure
-typedef struct {
-    unsigned char e_ident[EI_NIDENT]; /* ELF identification */
-    uint16_t e_type;           /* Object file type */
-    uint16_t e_machine;        /* Machine type */
-    uint32_t e_version;        /* Object file version */
-    uint64_t e_entry;          /* Entry point address */
-    uint64_t e_phoff;          /* Program header offset */
-    uint64_t e_shoff;          /* Section header offset */
-    uint32_t e_flags;          /* Processor-specific flags */
-    uint16_t e_ehsize;         /* ELF header size */
-    uint16_t e_phentsize;      /* Size of program header entry */
-    uint16_t e_phnum;          /* Number of program header entries */
-    uint16_t e_shentsize;      /* Size of section header entry */
-    uint16_t e_shnum;          /* Number of section header entries */
-    uint16_t e_shstrndx;       /* Section header string table index */
-} Elf64_Ehdr;
-
+#include "elf_reader/elf_reader.h"
+#include "elf_batch/elf_batch.h"
+#include "elf_size/elf_size.h"
+#include "elf_lookup/elf_lookup.h"
 
 const char* map_type(uint16_t e_type) {
     switch (e_type) {
@@ -100,6 +43,8 @@ const char* map_machine(uint16_t e_machine) {
         case EM_PPC: 			return "PowerPC";
         case EM_PPC64: 			return "PowerPC 64-bit";
         case EM_RISCV: 			return "RISC-V";
+        case EM_AARCH64: 		return "AArch64";
+        case EM_XTENSA: 		return "Tensilica Xtensa";
         
 		default: 				return "UNKNOWN";
     }
@@ -122,44 +67,524 @@ const char* map_data(unsigned char e_ident) {
     }
 }
 
-void print_elf_header(const Elf64_Ehdr *header) {
+const char* map_section_type(uint32_t sh_type) {
+    switch (sh_type) {
+        case SHT_NULL: 			return "NULL";
+        case SHT_PROGBITS: 		return "PROGBITS";
+        case SHT_SYMTAB: 		return "SYMTAB";
+        case SHT_STRTAB: 		return "STRTAB";
+        case SHT_RELA: 			return "RELA";
+        case SHT_HASH: 			return "HASH";
+        case SHT_DYNAMIC: 		return "DYNAMIC";
+        case SHT_NOTE: 			return "NOTE";
+        case SHT_NOBITS: 		return "NOBITS";
+        case SHT_REL: 			return "REL";
+        case SHT_DYNSYM: 		return "DYNSYM";
+        case SHT_INIT_ARRAY: 	return "INIT_ARRAY";
+        case SHT_FINI_ARRAY: 	return "FINI_ARRAY";
+        case SHT_PREINIT_ARRAY:	return "PREINIT_ARRAY";
+        case SHT_GROUP: 		return "GROUP";
+        case SHT_SYMTAB_SHNDX: 	return "SYMTAB SECTION INDICES";
+        case SHT_GNU_HASH: 		return "GNU_HASH";
+        case SHT_GNU_verdef: 	return "VERDEF";
+        case SHT_GNU_verneed: 	return "VERNEED";
+        case SHT_GNU_versym: 	return "VERSYM";
+        case SHT_ARM_EXIDX: 	return "ARM_EXIDX";
+        case SHT_ARM_ATTRIBUTES:return "ARM_ATTRIBUTES";
+        case 0x6fffff4c: 		return "GNU_SFRAME";
+
+        default: 				return "UNKNOWN";
+    }
+}
+
+const char* map_segment_type(uint32_t p_type) {
+    switch (p_type) {
+        case PT_NULL: 			return "NULL";
+        case PT_LOAD: 			return "LOAD";
+        case PT_DYNAMIC: 		return "DYNAMIC";
+        case PT_INTERP: 		return "INTERP";
+        case PT_NOTE: 			return "NOTE";
+        case PT_SHLIB: 			return "SHLIB";
+        case PT_PHDR: 			return "PHDR";
+        case PT_TLS: 			return "TLS";
+        case PT_GNU_EH_FRAME: 	return "GNU_EH_FRAME";
+        case PT_GNU_STACK: 		return "GNU_STACK";
+        case PT_GNU_RELRO: 		return "GNU_RELRO";
+        case PT_GNU_PROPERTY: 	return "GNU_PROPERTY";
+        case PT_ARM_EXIDX: 		return "ARM_EXIDX";
+
+        default: 				return "UNKNOWN";
+    }
+}
+
+const char* map_symbol_type(unsigned char st_info) {
+    switch (ELF64_ST_TYPE(st_info)) {
+        case STT_NOTYPE: 		return "NOTYPE";
+        case STT_OBJECT: 		return "OBJECT";
+        case STT_FUNC: 			return "FUNC";
+        case STT_SECTION: 		return "SECTION";
+        case STT_FILE: 			return "FILE";
+        case STT_COMMON: 		return "COMMON";
+        case STT_TLS: 			return "TLS";
+        case STT_GNU_IFUNC: 	return "IFUNC";
+
+        default: 				return "UNKNOWN";
+    }
+}
+
+const char* map_symbol_bind(unsigned char st_info) {
+    switch (ELF64_ST_BIND(st_info)) {
+        case STB_LOCAL: 		return "LOCAL";
+        case STB_GLOBAL: 		return "GLOBAL";
+        case STB_WEAK: 			return "WEAK";
+        case STB_GNU_UNIQUE: 	return "UNIQUE";
+
+        default: 				return "UNKNOWN";
+    }
+}
+
+const char* map_symbol_visibility(unsigned char st_other) {
+    switch (ELF64_ST_VISIBILITY(st_other)) {
+        case STV_DEFAULT: 		return "DEFAULT";
+        case STV_INTERNAL: 		return "INTERNAL";
+        case STV_HIDDEN: 		return "HIDDEN";
+        case STV_PROTECTED: 	return "PROTECTED";
+
+        default: 				return "UNKNOWN";
+    }
+}
+
+// Section flags as letters, like readelf ("WAX")
+void map_section_flags(uint64_t sh_flags, char *flags) {
+    static const struct { uint64_t flag; char letter; } letters[] = {
+        { SHF_WRITE, 'W' }, { SHF_ALLOC, 'A' }, { SHF_EXECINSTR, 'X' }, { SHF_MERGE, 'M' },
+        { SHF_STRINGS, 'S' }, { SHF_INFO_LINK, 'I' }, { SHF_LINK_ORDER, 'L' }, { SHF_GROUP, 'G' },
+        { SHF_TLS, 'T' }, { SHF_EXCLUDE, 'E' },
+    };
+    int len = 0;
+
+    for (size_t i = 0; i < sizeof(letters) / sizeof(letters[0]); i++) {
+        if (sh_flags & letters[i].flag) {
+            flags[len++] = letters[i].letter;
+        }
+    }
+    flags[len] = '\0';
+}
+
+// Section index of a symbol: UND, ABS, COM or the number
+void map_symbol_index(uint16_t st_shndx, char *index, size_t size) {
+    switch (st_shndx) {
+        case SHN_UNDEF: 		snprintf(index, size, "UND"); break;
+        case SHN_ABS: 			snprintf(index, size, "ABS"); break;
+        case SHN_COMMON: 		snprintf(index, size, "COM"); break;
+        default: 				snprintf(index, size, "%u", st_shndx); break;
+    }
+}
+
+// Hex digits of an address: 8 for ELF32 files, 16 for ELF64 files
+int address_width(const ElfFile *elf) {
+    return elf->header.ident[EI_CLASS] == ELFCLASS32 ? 8 : 16;
+}
+
+void print_elf_header(const ElfHeader *header) {
     printf("ELF Header:\n");
     printf("  Magic:   ");
 
     for (int i = 0; i < EI_NIDENT; i++) {
-        printf("%02x ", header->e_ident[i]);
+        printf("%02x ", header->ident[i]);
     }
     printf("\n");
 
-    printf("  Class:                             %s\n", map_class(header->e_ident[4]));
-    printf("  Data:                              %s\n", map_data(header->e_ident[5]));
-    printf("  Version:                           %d\n", header->e_ident[6]);
-    printf("  OS/ABI:                            %d\n", header->e_ident[7]);
-    printf("  ABI Version:                       %d\n", header->e_ident[8]);
-    printf("  Type:                              %s\n", map_type(header->e_type));
-    printf("  Machine:                           %s\n", map_machine(header->e_machine));
-    printf("  Version:                           0x%x\n", header->e_version);
-    printf("  Entry point address:               0x%lx\n", header->e_entry);
-    printf("  Start of program headers:          %lu (bytes into file)\n", header->e_phoff);
-    printf("  Start of section headers:          %lu (bytes into file)\n", header->e_shoff);
-    printf("  Flags:                             0x%x\n", header->e_flags);
-    printf("  Size of this header:               %u (bytes)\n", header->e_ehsize);
-    printf("  Size of program headers:           %u (bytes)\n", header->e_phentsize);
-    printf("  Number of program headers:         %u\n", header->e_phnum);
-    printf("  Size of section headers:           %u (bytes)\n", header->e_shentsize);
-    printf("  Number of section headers:         %u\n", header->e_shnum);
-    printf("  Section header string table index: %u\n", header->e_shstrndx);
+    printf("  Class:                             %s\n", map_class(header->ident[EI_CLASS]));
+    printf("  Data:                              %s\n", map_data(header->ident[EI_DATA]));
+    printf("  Version:                           %d\n", header->ident[EI_VERSION]);
+    printf("  OS/ABI:                            %d\n", header->ident[EI_OSABI]);
+    printf("  ABI Version:                       %d\n", header->ident[EI_ABIVERSION]);
+    printf("  Type:                              %s\n", map_type(header->type));
+    printf("  Machine:                           %s\n", map_machine(header->machine));
+    printf("  Version:                           0x%x\n", header->version);
+    printf("  Entry point address:               0x%" PRIx64 "\n", header->entry);
+    printf("  Start of program headers:          %" PRIu64 " (bytes into file)\n", header->phoff);
+    printf("  Start of section headers:          %" PRIu64 " (bytes into file)\n", header->shoff);
+    printf("  Flags:                             0x%x\n", header->flags);
+    printf("  Size of this header:               %u (bytes)\n", header->ehsize);
+    printf("  Size of program headers:           %u (bytes)\n", header->phentsize);
+    printf("  Number of program headers:         %u\n", header->phnum);
+    printf("  Size of section headers:           %u (bytes)\n", header->shentsize);
+    printf("  Number of section headers:         %u\n", header->shnum);
+    printf("  Section header string table index: %u\n", header->shstrndx);
 }
 
-int main(int argc, char *argv[]) {
+void print_section_headers(const ElfFile *elf) {
+    ElfSection section;
+    char flags[16];
+
+    if (elf->sections.count == 0) {
+        printf("\nThere are no sections in this file.\n");
+        return;
+    }
+
+    printf("\nSection Headers:\n");
+    int width = address_width(elf);
+    printf("  [Nr] Name                 Type             %-*s Offset   Size     EntSize  Flg  Lk Inf Al\n", width, "Address");
+    for (size_t i = 0; i < elf->sections.count; i++) {
+        elf_section(elf, i, &section);
+        const char *name = elf_section_name(elf, &section);
+        map_section_flags(section.flags, flags);
 
-    FILE *file = fopen(argv[1], "rb");
+        printf("  [%2zu] %-20.20s %-16.16s %0*" PRIx64 " %08" PRIx64 " %08" PRIx64 " %08" PRIx64 " %-4s %2u %3u %2" PRIu64 "\n",
+               i, name ? name : "<corrupt>", map_section_type(section.type), width, section.addr, section.offset,
+               section.size, section.entsize, flags, section.link, section.info, section.addralign);
+    }
+    printf("Key to Flags:\n");
+    printf("  W (write), A (alloc), X (execute), M (merge), S (strings), I (info),\n");
+    printf("  L (link order), G (group), T (TLS), E (exclude)\n");
+}
 
-    Elf64_Ehdr header;
-    size_t bytesRead = fread(&header, 1, sizeof(header), file);
+void print_program_headers(const ElfFile *elf) {
+    ElfSegment segment;
+
+    if (elf->segments.count == 0) {
+        printf("\nThere are no program headers in this file.\n");
+        return;
+    }
 
-    print_elf_header(&header);
+    printf("\nProgram Headers:\n");
+    int width = address_width(elf);
+    printf("  Type           Offset   %-*s %-*s FileSiz  MemSiz   Flg Align\n", width + 2, "VirtAddr", width + 2, "PhysAddr");
+    for (size_t i = 0; i < elf->segments.count; i++) {
+        elf_segment(elf, i, &segment);
+        printf("  %-14s 0x%06" PRIx64 " 0x%0*" PRIx64 " 0x%0*" PRIx64 " 0x%06" PRIx64 " 0x%06" PRIx64 " %c%c%c 0x%" PRIx64 "\n",
+               map_segment_type(segment.type), segment.offset, width, segment.vaddr, width, segment.paddr,
+               segment.filesz, segment.memsz,
+               (segment.flags & PF_R) ? 'R' : ' ', (segment.flags & PF_W) ? 'W' : ' ',
+               (segment.flags & PF_X) ? 'E' : ' ', segment.align);
+
+        // The interpreter is printed from the mapping, nothing else of the segment is read
+        if (segment.type == PT_INTERP && segment.filesz > 0 && segment.offset < elf->size &&
+            segment.filesz <= elf->size - segment.offset) {
+            const char *interpreter = elf_string((const char *)elf->data + segment.offset, segment.filesz, 0);
+            if (interpreter != NULL) {
+                printf("      [Requesting program interpreter: %s]\n", interpreter);
+            }
+        }
+    }
+}
+
+int print_symbol_tables(const ElfFile *elf) {
+    ElfSection section;
+    ElfSymbolTable table;
+    ElfSymbol symbol;
+    char index[16];
+    int found = 0;
+    int width = address_width(elf);
+
+    for (size_t i = 0; i < elf->sections.count; i++) {
+        elf_section(elf, i, &section);
+        if (section.type != SHT_SYMTAB && section.type != SHT_DYNSYM) {
+            continue;
+        }
+        found = 1;
+
+        const char *table_name = elf_section_name(elf, &section);
+        ElfStatus status = elf_symbol_table(elf, &section, &table);
+        if (status != ELF_OK) {
+            fprintf(stderr, "Symbol table '%s': %s\n", table_name ? table_name : "<corrupt>", elf_status_string(status));
+            return status;
+        }
+
+        printf("\nSymbol table '%s' contains %zu entries:\n", table_name ? table_name : "<corrupt>", table.symbols.count);
+        printf("   Num: %-*s  Size Type    Bind   Vis       Ndx Name\n", width, "   Value");
+        for (size_t j = 0; j < table.symbols.count; j++) {
+            elf_symbol(elf, &table, j, &symbol);
+            const char *name = elf_string(table.strings, table.strings_size, symbol.name);
+            map_symbol_index(symbol.shndx, index, sizeof(index));
+
+            printf("%6zu: %0*" PRIx64 " %5" PRIu64 " %-7s %-6s %-9s %3s %s\n",
+                   j, width, symbol.value, symbol.size, map_symbol_type(symbol.info), map_symbol_bind(symbol.info),
+                   map_symbol_visibility(symbol.other), index, name ? name : "<corrupt>");
+        }
+    }
 
-    fclose(file);
+    if (!found) {
+        printf("\nThere are no symbol tables in this file.\n");
+    }
+    return ELF_OK;
+}
+
+void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s [-h] [-S] [-l] [-s] [-z] [-t N] FILE...\n", program);
+    fprintf(stderr, "       %s [-L NAME]... [-A ADDR]... FILE...\n", program);
+    fprintf(stderr, "       %s -d [-t N] OLD NEW\n", program);
+    fprintf(stderr, "       %s -r DIR [-j N] [-f json|csv]\n", program);
+    fprintf(stderr, "  -h  print the ELF header (the default)\n");
+    fprintf(stderr, "  -S  print the section headers\n");
+    fprintf(stderr, "  -l  print the program headers\n");
+    fprintf(stderr, "  -s  print the symbol tables\n");
+    fprintf(stderr, "  -z  print the allocated sections and the text/data/bss totals, like size\n");
+    fprintf(stderr, "  -t  print the N largest symbols (with -d: print only the N largest symbol changes)\n");
+    fprintf(stderr, "  -d  compare the section and symbol sizes of two files\n");
+    fprintf(stderr, "  -L, --lookup NAME    print the defined symbol NAME (- reads one name per line from stdin)\n");
+    fprintf(stderr, "  -A, --addr2sym ADDR  print the symbol containing the hexadecimal ADDR (- reads stdin)\n");
+    fprintf(stderr, "  -r  print one record per ELF file under DIR, parsed by N workers (one per CPU by default)\n");
+    fprintf(stderr, "  -f  format of the records: JSON lines (the default) or CSV\n");
+}
+
+// Opens a file, printing why it can not be read
+int open_file(ElfFile *elf, const char *path) {
+    ElfStatus status = elf_open(elf, path);
+    if (status != ELF_OK) {
+        fprintf(stderr, "%s: %s%s%s\n", path, elf_status_string(status),
+                status == ELF_ERROR_OPEN ? ": " : "", status == ELF_ERROR_OPEN ? strerror(errno) : "");
+        return -1;
+    }
     return 0;
 }
+
+// Prints the symbol found for a name, returns 0 if it was not found
+int print_lookup(const ElfFile *elf, const ElfLookup *lookup, const char *name) {
+    ElfLookupMatch match;
+    char index[16];
+
+    if (!elf_lookup_name(lookup, name, &match)) {
+        printf("%s: not found\n", name);
+        return 0;
+    }
+
+    map_symbol_index(match.symbol.shndx, index, sizeof(index));
+    printf("%0*" PRIx64 " %5" PRIu64 " %-7s %-6s %3s %s [%s]\n", address_width(elf), match.symbol.value,
+           match.symbol.size, map_symbol_type(match.symbol.info), map_symbol_bind(match.symbol.info),
+           index, match.name, match.source);
+    return 1;
+}
+
+// Prints the symbol containing an address as symbol+offset, returns 0 if there is none
+int print_addr2sym(const ElfLookup *lookup, const char *text) {
+    ElfLookupMatch match;
+    uint64_t offset;
+    char *end;
+
+    errno = 0;
+    uint64_t address = strtoull(text, &end, 16);
+    if (errno != 0 || end == text || *end != '\0') {
+        printf("%s: not an address\n", text);
+        return 0;
+    }
+
+    if (!elf_lookup_address(lookup, address, &match, &offset)) {
+        printf("0x%" PRIx64 " ??\n", address);
+        return 0;
+    }
+    printf("0x%" PRIx64 " %s+0x%" PRIx64 "\n", address, match.name ? match.name : "<corrupt>", offset);
+    return 1;
+}
+
+// Runs the queries of one option, "-" stands for one query per line of stdin
+int run_queries(const ElfFile *elf, const ElfLookup *lookup, char **queries, int count, int by_address) {
+    int all_found = 1;
+    char *line = NULL;
+    size_t line_size = 0;
+    ssize_t length;
+
+    for (int i = 0; i < count; i++) {
+        if (strcmp(queries[i], "-") != 0) {
+            all_found &= by_address ? print_addr2sym(lookup, queries[i]) : print_lookup(elf, lookup, queries[i]);
+            continue;
+        }
+
+        while ((length = getline(&line, &line_size, stdin)) != -1) {
+            while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+                line[--length] = '\0';
+            }
+            if (length > 0) {
+                all_found &= by_address ? print_addr2sym(lookup, line) : print_lookup(elf, lookup, line);
+            }
+        }
+    }
+
+    free(line);
+    return all_found;
+}
+
+// Compares two files by section and symbol size
+int diff_files(const char *old_path, const char *new_path, size_t limit) {
+    ElfFile old_elf, new_elf;
+
+    if (open_file(&old_elf, old_path) != 0) {
+        return 1;
+    }
+    if (open_file(&new_elf, new_path) != 0) {
+        elf_close(&old_elf);
+        return 1;
+    }
+
+    printf("Comparing %s (old) with %s (new)\n\n", old_path, new_path);
+    ElfStatus status = elf_size_print_diff(&old_elf, &new_elf, limit);
+    if (status != ELF_OK) {
+        fprintf(stderr, "Symbol tables: %s\n", status == ELF_ERROR_OPEN ? strerror(errno) : elf_status_string(status));
+    }
+
+    elf_close(&new_elf);
+    elf_close(&old_elf);
+    return status == ELF_OK ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    int show_header = 0, show_sections = 0, show_segments = 0, show_symbols = 0;
+    int show_size = 0, diff_mode = 0;
+    long top_symbols = 0;
+    char **names = calloc(argc, sizeof(char *));
+    char **addresses = calloc(argc, sizeof(char *));
+    int name_count = 0, address_count = 0;
+    int exit_status = 0;
+    int option;
+    const char *batch_root = NULL;
+    long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    ElfRecordFormat format = ELF_RECORD_JSON;
+    char *end;
+
+    static const struct option long_options[] = {
+        { "lookup",   required_argument, NULL, 'L' },
+        { "addr2sym", required_argument, NULL, 'A' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    if (names == NULL || addresses == NULL) {
+        perror("Failed to allocate memory");
+        exit_status = 1;
+        goto out;
+    }
+
+    while ((option = getopt_long(argc, argv, "hSlszt:dL:A:r:j:f:", long_options, NULL)) != -1) {
+        switch (option) {
+            case 'h': 			show_header = 1; break;
+            case 'S': 			show_sections = 1; break;
+            case 'l': 			show_segments = 1; break;
+            case 's': 			show_symbols = 1; break;
+            case 'z': 			show_size = 1; break;
+            case 'd': 			diff_mode = 1; break;
+            case 'L': 			names[name_count++] = optarg; break;
+            case 'A': 			addresses[address_count++] = optarg; break;
+            case 't':
+                top_symbols = strtol(optarg, &end, 10);
+                if (*end != '\0' || top_symbols < 1) {
+                    fprintf(stderr, "%s: -t expects a positive number of symbols\n", argv[0]);
+                    exit_status = 1;
+                    goto out;
+                }
+                break;
+            case 'r': 			batch_root = optarg; break;
+            case 'j':
+                num_threads = strtol(optarg, &end, 10);
+                if (*end != '\0' || num_threads < 1) {
+                    fprintf(stderr, "%s: -j expects a positive number of workers\n", argv[0]);
+                    exit_status = 1;
+                    goto out;
+                }
+                break;
+            case 'f':
+                if (strcmp(optarg, "json") == 0) {
+                    format = ELF_RECORD_JSON;
+                } else if (strcmp(optarg, "csv") == 0) {
+                    format = ELF_RECORD_CSV;
+                } else {
+                    fprintf(stderr, "%s: -f expects json or csv\n", argv[0]);
+                    exit_status = 1;
+                    goto out;
+                }
+                break;
+            default:
+                print_usage(argv[0]);
+                exit_status = 1;
+                goto out;
+        }
+    }
+
+    if (batch_root != NULL) {
+        if (optind < argc) {
+            print_usage(argv[0]);
+            exit_status = 1;
+            goto out;
+        }
+        exit_status = elf_batch_run(batch_root, num_threads, format);
+        goto out;
+    }
+
+    if (diff_mode) {
+        if (argc - optind != 2) {
+            print_usage(argv[0]);
+            exit_status = 1;
+            goto out;
+        }
+        exit_status = diff_files(argv[optind], argv[optind + 1], top_symbols);
+        goto out;
+    }
+
+    if (optind >= argc) {
+        print_usage(argv[0]);
+        exit_status = 1;
+        goto out;
+    }
+    if (!show_sections && !show_segments && !show_symbols && !show_size && top_symbols == 0 &&
+        name_count == 0 && address_count == 0) {
+        show_header = 1;
+    }
+
+    for (int i = optind; i < argc; i++) {
+        ElfFile elf;
+        if (open_file(&elf, argv[i]) != 0) {
+            exit_status = 1;
+            continue;
+        }
+
+        if (argc - optind > 1) {
+            printf("\nFile: %s\n", argv[i]);
+        }
+        if (show_header) {
+            print_elf_header(&elf.header);
+        }
+        if (show_sections) {
+            print_section_headers(&elf);
+        }
+        if (show_segments) {
+            print_program_headers(&elf);
+        }
+        if (show_symbols && print_symbol_tables(&elf) != ELF_OK) {
+            exit_status = 1;
+        }
+        if (show_size) {
+            elf_size_print(&elf, argv[i]);
+        }
+        if (name_count > 0 || address_count > 0) {
+            ElfLookup lookup;
+            ElfStatus status = elf_lookup_open(&lookup, &elf, (name_count > 0 ? ELF_LOOKUP_NAMES : 0) |
+                                                              (address_count > 0 ? ELF_LOOKUP_ADDRESSES : 0));
+            if (status != ELF_OK) {
+                fprintf(stderr, "%s: %s\n", argv[i], status == ELF_ERROR_OPEN ? strerror(errno) : elf_status_string(status));
+                exit_status = 1;
+            } else {
+                if (!run_queries(&elf, &lookup, names, name_count, 0)) {
+                    exit_status = 1;
+                }
+                if (!run_queries(&elf, &lookup, addresses, address_count, 1)) {
+                    exit_status = 1;
+                }
+                elf_lookup_close(&lookup);
+            }
+        }
+        if (top_symbols > 0) {
+            ElfStatus status = elf_size_print_top(&elf, top_symbols);
+            if (status != ELF_OK) {
+                fprintf(stderr, "%s: %s\n", argv[i], status == ELF_ERROR_OPEN ? strerror(errno) : elf_status_string(status));
+                exit_status = 1;
+            }
+        }
+
+        elf_close(&elf);
+    }
+
+out:
+    free(names);
+    free(addresses);
+    return exit_status;
+}
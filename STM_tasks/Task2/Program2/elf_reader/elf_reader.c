@@ -0,0 +1,407 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        elf_reader.c           *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "elf_reader.h"
+
+/*****************************        Global Variables           ********************************/
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define ELF_HOST_DATA   ELFDATA2LSB
+#else
+#define ELF_HOST_DATA   ELFDATA2MSB
+#endif
+
+static const char *status_strings[] = {
+    [ELF_OK]                = "Success",
+    [ELF_ERROR_OPEN]        = "Failed to open the file",
+    [ELF_ERROR_NOT_ELF]     = "Not an ELF file",
+    [ELF_ERROR_UNSUPPORTED] = "Unsupported ELF class or data encoding",
+    [ELF_ERROR_TRUNCATED]   = "Truncated or corrupted file",
+    [ELF_ERROR_BAD_TABLE]   = "Corrupted section, segment or symbol table",
+};
+
+/*****************************        Decoders                   ********************************/
+
+/*
+ * The four decoders are generated from the same template. Fields are copied out of the raw
+ * structure (memcpy, the tables may be unaligned) and converted with SWAP16/32/64, which are
+ * either nothing or a byte swap depending on the variant.
+ */
+#define KEEP(value)     (value)
+
+#define DEFINE_ELF_DECODER(NAME, Ehdr, Shdr, Phdr, Sym, Addr, SWAP16, SWAP32, SWAP_ADDR)    \
+static void NAME##_header(const unsigned char *raw_bytes, ElfHeader *header)                \
+{                                                                                           \
+    Ehdr raw;                                                                               \
+    memcpy(&raw, raw_bytes, sizeof(raw));                                                   \
+    memcpy(header->ident, raw.e_ident, EI_NIDENT);                                          \
+    header->type = SWAP16(raw.e_type);                                                      \
+    header->machine = SWAP16(raw.e_machine);                                                \
+    header->version = SWAP32(raw.e_version);                                                \
+    header->entry = SWAP_ADDR(raw.e_entry);                                                 \
+    header->phoff = SWAP_ADDR(raw.e_phoff);                                                 \
+    header->shoff = SWAP_ADDR(raw.e_shoff);                                                 \
+    header->flags = SWAP32(raw.e_flags);                                                    \
+    header->ehsize = SWAP16(raw.e_ehsize);                                                  \
+    header->phentsize = SWAP16(raw.e_phentsize);                                            \
+    header->phnum = SWAP16(raw.e_phnum);                                                    \
+    header->shentsize = SWAP16(raw.e_shentsize);                                            \
+    header->shnum = SWAP16(raw.e_shnum);                                                    \
+    header->shstrndx = SWAP16(raw.e_shstrndx);                                              \
+}                                                                                           \
+                                                                                            \
+static void NAME##_section(const unsigned char *raw_bytes, ElfSection *section)             \
+{                                                                                           \
+    Shdr raw;                                                                               \
+    memcpy(&raw, raw_bytes, sizeof(raw));                                                   \
+    section->name = SWAP32(raw.sh_name);                                                    \
+    section->type = SWAP32(raw.sh_type);                                                    \
+    section->flags = SWAP_ADDR(raw.sh_flags);                                               \
+    section->addr = SWAP_ADDR(raw.sh_addr);                                                 \
+    section->offset = SWAP_ADDR(raw.sh_offset);                                             \
+    section->size = SWAP_ADDR(raw.sh_size);                                                 \
+    section->link = SWAP32(raw.sh_link);                                                    \
+    section->info = SWAP32(raw.sh_info);                                                    \
+    section->addralign = SWAP_ADDR(raw.sh_addralign);                                       \
+    section->entsize = SWAP_ADDR(raw.sh_entsize);                                           \
+}                                                                                           \
+                                                                                            \
+static void NAME##_segment(const unsigned char *raw_bytes, ElfSegment *segment)             \
+{                                                                                           \
+    Phdr raw;                                                                               \
+    memcpy(&raw, raw_bytes, sizeof(raw));                                                   \
+    segment->type = SWAP32(raw.p_type);                                                     \
+    segment->flags = SWAP32(raw.p_flags);                                                   \
+    segment->offset = SWAP_ADDR(raw.p_offset);                                              \
+    segment->vaddr = SWAP_ADDR(raw.p_vaddr);                                                \
+    segment->paddr = SWAP_ADDR(raw.p_paddr);                                                \
+    segment->filesz = SWAP_ADDR(raw.p_filesz);                                              \
+    segment->memsz = SWAP_ADDR(raw.p_memsz);                                                \
+    segment->align = SWAP_ADDR(raw.p_align);                                                \
+}                                                                                           \
+                                                                                            \
+static void NAME##_symbol(const unsigned char *raw_bytes, ElfSymbol *symbol)                \
+{                                                                                           \
+    Sym raw;                                                                                \
+    memcpy(&raw, raw_bytes, sizeof(raw));                                                   \
+    symbol->name = SWAP32(raw.st_name);                                                     \
+    symbol->info = raw.st_info;                                                             \
+    symbol->other = raw.st_other;                                                           \
+    symbol->shndx = SWAP16(raw.st_shndx);                                                   \
+    symbol->value = SWAP_ADDR(raw.st_value);                                                \
+    symbol->size = SWAP_ADDR(raw.st_size);                                                  \
+}                                                                                           \
+                                                                                            \
+static uint16_t NAME##_half(const unsigned char *raw_bytes)                                 \
+{                                                                                           \
+    uint16_t raw;                                                                           \
+    memcpy(&raw, raw_bytes, sizeof(raw));                                                   \
+    return SWAP16(raw);                                                                     \
+}                                                                                           \
+                                                                                            \
+static uint32_t NAME##_word(const unsigned char *raw_bytes)                                 \
+{                                                                                           \
+    uint32_t raw;                                                                           \
+    memcpy(&raw, raw_bytes, sizeof(raw));                                                   \
+    return SWAP32(raw);                                                                     \
+}                                                                                           \
+                                                                                            \
+static uint64_t NAME##_address(const unsigned char *raw_bytes)                              \
+{                                                                                           \
+    Addr raw;                                                                               \
+    memcpy(&raw, raw_bytes, sizeof(raw));                                                   \
+    return SWAP_ADDR(raw);                                                                  \
+}                                                                                           \
+                                                                                            \
+static const ElfDecoder NAME = {                                                            \
+    sizeof(Ehdr), sizeof(Shdr), sizeof(Phdr), sizeof(Sym), sizeof(Addr),                    \
+    NAME##_header, NAME##_section, NAME##_segment, NAME##_symbol,                           \
+    NAME##_half, NAME##_word, NAME##_address                                                \
+};
+
+DEFINE_ELF_DECODER(decoder64_native,  Elf64_Ehdr, Elf64_Shdr, Elf64_Phdr, Elf64_Sym, Elf64_Addr,
+                   KEEP, KEEP, KEEP)
+DEFINE_ELF_DECODER(decoder64_swapped, Elf64_Ehdr, Elf64_Shdr, Elf64_Phdr, Elf64_Sym, Elf64_Addr,
+                   __builtin_bswap16, __builtin_bswap32, __builtin_bswap64)
+DEFINE_ELF_DECODER(decoder32_native,  Elf32_Ehdr, Elf32_Shdr, Elf32_Phdr, Elf32_Sym, Elf32_Addr,
+                   KEEP, KEEP, KEEP)
+DEFINE_ELF_DECODER(decoder32_swapped, Elf32_Ehdr, Elf32_Shdr, Elf32_Phdr, Elf32_Sym, Elf32_Addr,
+                   __builtin_bswap16, __builtin_bswap32, __builtin_bswap32)
+
+/*****************************        Static Functions           ********************************/
+
+/* Chooses the decoder of the file's class and byte order, NULL if one of them is unknown */
+static const ElfDecoder *select_decoder(unsigned char elf_class, unsigned char data)
+{
+    if (data != ELFDATA2LSB && data != ELFDATA2MSB) {
+        return NULL;
+    }
+
+    int native = (data == ELF_HOST_DATA);
+    switch (elf_class) {
+    case ELFCLASS64:
+        return native ? &decoder64_native : &decoder64_swapped;
+    case ELFCLASS32:
+        return native ? &decoder32_native : &decoder32_swapped;
+    default:
+        return NULL;
+    }
+}
+
+/* Tells if [offset, offset + size) is inside the file, without overflowing */
+static int in_file(const ElfFile *elf, uint64_t offset, uint64_t size)
+{
+    return offset <= elf->size && size <= elf->size - offset;
+}
+
+/* Sets a table of count entries of entry_size bytes at offset, checking it is inside the file */
+static ElfStatus make_table(const ElfFile *elf, ElfTable *table, uint64_t offset, uint64_t count,
+                            uint64_t entry_size, size_t min_entry_size)
+{
+    table->data = NULL;
+    table->count = 0;
+    table->entry_size = entry_size;
+
+    if (count == 0) {
+        return ELF_OK;
+    }
+    if (entry_size < min_entry_size) {
+        return ELF_ERROR_BAD_TABLE;
+    }
+    if (count > elf->size / entry_size || !in_file(elf, offset, count * entry_size)) {
+        return ELF_ERROR_TRUNCATED;
+    }
+
+    table->data = elf->data + offset;
+    table->count = count;
+    return ELF_OK;
+}
+
+/* Reads the ELF header and resolves the counts stored in section 0 when they do not fit */
+static ElfStatus read_header(ElfFile *elf)
+{
+    ElfHeader *header = &elf->header;
+
+    if (elf->size < elf->decoder->header_size) {
+        return ELF_ERROR_TRUNCATED;
+    }
+    elf->decoder->header(elf->data, header);
+
+    /* More than 0xff00 sections or segments: the real counts are in section 0 */
+    if (header->shoff != 0 && (header->shnum == 0 || header->shstrndx == SHN_XINDEX || header->phnum == PN_XNUM)) {
+        ElfTable first;
+        ElfSection section0;
+        ElfStatus status = make_table(elf, &first, header->shoff, 1, header->shentsize, elf->decoder->section_size);
+        if (status != ELF_OK) {
+            return status;
+        }
+        elf->sections = first;
+        elf_section(elf, 0, &section0);
+
+        if (header->shnum == 0) {
+            header->shnum = section0.size;
+        }
+        if (header->shstrndx == SHN_XINDEX) {
+            header->shstrndx = section0.link;
+        }
+        if (header->phnum == PN_XNUM) {
+            header->phnum = section0.info;
+        }
+    }
+    return ELF_OK;
+}
+
+/*****************************        Public Functions           ********************************/
+
+ElfStatus elf_open(ElfFile *elf, const char *path)
+{
+    struct stat info;
+    ElfStatus status;
+
+    memset(elf, 0, sizeof(*elf));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return ELF_ERROR_OPEN;
+    }
+    if (fstat(fd, &info) < 0) {
+        close(fd);
+        return ELF_ERROR_OPEN;
+    }
+    if (!S_ISREG(info.st_mode) || info.st_size < EI_NIDENT) {
+        close(fd);
+        return ELF_ERROR_NOT_ELF;
+    }
+
+    /* Pages are only read from the disk when a view over them is accessed */
+    void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int saved_errno = errno;
+    close(fd);
+    if (data == MAP_FAILED) {
+        errno = saved_errno;
+        return ELF_ERROR_OPEN;
+    }
+    elf->data = data;
+    elf->size = info.st_size;
+
+    if (memcmp(elf->data, ELFMAG, SELFMAG) != 0) {
+        status = ELF_ERROR_NOT_ELF;
+    } else if ((elf->decoder = select_decoder(elf->data[EI_CLASS], elf->data[EI_DATA])) == NULL) {
+        status = ELF_ERROR_UNSUPPORTED;
+    } else {
+        status = read_header(elf);
+    }
+
+    if (status == ELF_OK) {
+        status = make_table(elf, &elf->sections, elf->header.shoff, elf->header.shnum,
+                            elf->header.shentsize, elf->decoder->section_size);
+    }
+    if (status == ELF_OK) {
+        status = make_table(elf, &elf->segments, elf->header.phoff, elf->header.phnum,
+                            elf->header.phentsize, elf->decoder->segment_size);
+    }
+
+    /* A missing or broken .shstrtab only loses the section names */
+    if (status == ELF_OK && elf->header.shstrndx != SHN_UNDEF && elf->header.shstrndx < elf->sections.count) {
+        ElfSection names;
+        const void *strings;
+        size_t size;
+        elf_section(elf, elf->header.shstrndx, &names);
+        if (names.type == SHT_STRTAB && elf_section_data(elf, &names, &strings, &size) == ELF_OK) {
+            elf->section_names = strings;
+            elf->section_names_size = size;
+        }
+    }
+
+    if (status != ELF_OK) {
+        elf_close(elf);
+    }
+    return status;
+}
+
+void elf_close(ElfFile *elf)
+{
+    if (elf->data != NULL) {
+        munmap((void *)elf->data, elf->size);
+    }
+    memset(elf, 0, sizeof(*elf));
+}
+
+const char *elf_status_string(ElfStatus status)
+{
+    if ((size_t)status >= sizeof(status_strings) / sizeof(status_strings[0])) {
+        return "Unknown error";
+    }
+    return status_strings[status];
+}
+
+void elf_section(const ElfFile *elf, size_t index, ElfSection *section)
+{
+    elf->decoder->section(elf->sections.data + index * elf->sections.entry_size, section);
+}
+
+const char *elf_section_name(const ElfFile *elf, const ElfSection *section)
+{
+    return elf_string(elf->section_names, elf->section_names_size, section->name);
+}
+
+long elf_find_section(const ElfFile *elf, const char *name, ElfSection *section)
+{
+    ElfSection current;
+
+    for (size_t i = 0; i < elf->sections.count; i++) {
+        elf_section(elf, i, &current);
+        const char *current_name = elf_section_name(elf, &current);
+        if (current_name != NULL && strcmp(current_name, name) == 0) {
+            if (section != NULL) {
+                *section = current;
+            }
+            return (long)i;
+        }
+    }
+    return -1;
+}
+
+ElfStatus elf_section_data(const ElfFile *elf, const ElfSection *section, const void **data, size_t *size)
+{
+    if (section->type == SHT_NOBITS) {
+        *data = NULL;
+        *size = 0;
+        return ELF_OK;
+    }
+    if (!in_file(elf, section->offset, section->size)) {
+        return ELF_ERROR_TRUNCATED;
+    }
+
+    *data = elf->data + section->offset;
+    *size = section->size;
+    return ELF_OK;
+}
+
+void elf_segment(const ElfFile *elf, size_t index, ElfSegment *segment)
+{
+    elf->decoder->segment(elf->segments.data + index * elf->segments.entry_size, segment);
+}
+
+ElfStatus elf_symbol_table(const ElfFile *elf, const ElfSection *section, ElfSymbolTable *table)
+{
+    ElfSection strings;
+    const void *strings_data = NULL;
+    ElfStatus status;
+
+    if ((section->type != SHT_SYMTAB && section->type != SHT_DYNSYM) || section->link >= elf->sections.count) {
+        return ELF_ERROR_BAD_TABLE;
+    }
+
+    uint64_t entry_size = section->entsize ? section->entsize : elf->decoder->symbol_size;
+    status = make_table(elf, &table->symbols, section->offset, section->size / entry_size,
+                        entry_size, elf->decoder->symbol_size);
+    if (status != ELF_OK) {
+        return status;
+    }
+
+    elf_section(elf, section->link, &strings);
+    if (strings.type != SHT_STRTAB) {
+        return ELF_ERROR_BAD_TABLE;
+    }
+    status = elf_section_data(elf, &strings, &strings_data, &table->strings_size);
+    if (status != ELF_OK) {
+        table->strings = NULL;
+        table->strings_size = 0;
+        return status;
+    }
+    table->strings = strings_data;
+    return ELF_OK;
+}
+
+void elf_symbol(const ElfFile *elf, const ElfSymbolTable *table, size_t index, ElfSymbol *symbol)
+{
+    elf->decoder->symbol(table->symbols.data + index * table->symbols.entry_size, symbol);
+}
+
+const char *elf_string(const char *strings, size_t size, uint64_t offset)
+{
+    if (strings == NULL || offset >= size || memchr(strings + offset, '\0', size - offset) == NULL) {
+        return NULL;
+    }
+    return strings + offset;
+}
@@ -0,0 +1,206 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        elf_reader.h           *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef ELF_READER_H
+#define ELF_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <elf.h>
+
+typedef enum {
+    ELF_OK,
+    ELF_ERROR_OPEN,                 /* open, fstat or mmap failed (errno is set) */
+    ELF_ERROR_NOT_ELF,              /* No ELF magic number */
+    ELF_ERROR_UNSUPPORTED,          /* Unknown class or data encoding */
+    ELF_ERROR_TRUNCATED,            /* A header or a table points outside of the file */
+    ELF_ERROR_BAD_TABLE             /* Wrong entry size, index or string table */
+} ElfStatus;
+
+/* The ELF header, with the extended section and segment counts already resolved */
+typedef struct {
+    unsigned char ident[EI_NIDENT];
+    uint16_t type;
+    uint16_t machine;
+    uint32_t version;
+    uint64_t entry;
+    uint64_t phoff;
+    uint64_t shoff;
+    uint32_t flags;
+    uint16_t ehsize;
+    uint16_t phentsize;
+    uint32_t phnum;
+    uint16_t shentsize;
+    uint32_t shnum;
+    uint32_t shstrndx;
+} ElfHeader;
+
+/* A section header */
+typedef struct {
+    uint32_t name;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t addr;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t link;
+    uint32_t info;
+    uint64_t addralign;
+    uint64_t entsize;
+} ElfSection;
+
+/* A program header */
+typedef struct {
+    uint32_t type;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t vaddr;
+    uint64_t paddr;
+    uint64_t filesz;
+    uint64_t memsz;
+    uint64_t align;
+} ElfSegment;
+
+/* An entry of .symtab or .dynsym */
+typedef struct {
+    uint32_t name;
+    unsigned char info;
+    unsigned char other;
+    uint16_t shndx;
+    uint64_t value;
+    uint64_t size;
+} ElfSymbol;
+
+/* A table inside the mapped file, its entries are only decoded when they are accessed */
+typedef struct {
+    const unsigned char *data;
+    size_t count;
+    size_t entry_size;
+} ElfTable;
+
+/* A symbol table with its string table, both pointing into the mapped file */
+typedef struct {
+    ElfTable symbols;
+    const char *strings;
+    size_t strings_size;
+} ElfSymbolTable;
+
+/*
+ * Decoding functions of one class and byte order (ELF32/ELF64, same or swapped compared to the
+ * host), chosen once by elf_open() so the loops over the tables do not test them for each field.
+ */
+typedef struct {
+    size_t header_size;
+    size_t section_size;
+    size_t segment_size;
+    size_t symbol_size;
+    size_t address_size;            /* 4 or 8, the size of the words of the .gnu.hash bloom filter */
+    void (*header)(const unsigned char *raw, ElfHeader *header);
+    void (*section)(const unsigned char *raw, ElfSection *section);
+    void (*segment)(const unsigned char *raw, ElfSegment *segment);
+    void (*symbol)(const unsigned char *raw, ElfSymbol *symbol);
+    uint16_t (*half)(const unsigned char *raw);         /* A 16-bit entry of .gnu.version */
+    uint32_t (*word)(const unsigned char *raw);         /* A 32-bit word of a hash section */
+    uint64_t (*address)(const unsigned char *raw);      /* An address-sized word */
+} ElfDecoder;
+
+/* An ELF file mapped read-only, nothing but the headers is read by elf_open() */
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    const ElfDecoder *decoder;
+    ElfHeader header;
+    ElfTable sections;
+    ElfTable segments;
+    const char *section_names;      /* .shstrtab, NULL if missing */
+    size_t section_names_size;
+} ElfFile;
+
+/**
+ * @brief Maps a file and validates its ELF header, section header table and program header table.
+ *
+ * @param elf Filled with the views of the file.
+ * @param path Path of the file.
+ * @return ElfStatus ELF_OK, or the reason the file can not be read (nothing stays mapped then).
+ */
+ElfStatus elf_open(ElfFile *elf, const char *path);
+
+/**
+ * @brief Unmaps the file, the views and strings taken from it become invalid.
+ */
+void elf_close(ElfFile *elf);
+
+/**
+ * @brief Returns a message for a status.
+ */
+const char *elf_status_string(ElfStatus status);
+
+/**
+ * @brief Decodes a section header.
+ *
+ * @param index Index of the section, below elf->sections.count.
+ */
+void elf_section(const ElfFile *elf, size_t index, ElfSection *section);
+
+/**
+ * @brief Returns the name of a section from .shstrtab.
+ *
+ * @return const char* The name, or NULL if it is outside of the string table.
+ */
+const char *elf_section_name(const ElfFile *elf, const ElfSection *section);
+
+/**
+ * @brief Finds a section by name.
+ *
+ * @param section Filled with the section when it is found (may be NULL).
+ * @return long The index of the first section with this name, or -1.
+ */
+long elf_find_section(const ElfFile *elf, const char *name, ElfSection *section);
+
+/**
+ * @brief Returns a view of the bytes of a section.
+ *
+ * @param data Set to the first byte of the section in the mapping (NULL for SHT_NOBITS).
+ * @param size Set to the number of bytes in the file (0 for SHT_NOBITS).
+ * @return ElfStatus ELF_OK, or ELF_ERROR_TRUNCATED if the section is outside of the file.
+ */
+ElfStatus elf_section_data(const ElfFile *elf, const ElfSection *section, const void **data, size_t *size);
+
+/**
+ * @brief Decodes a program header.
+ *
+ * @param index Index of the segment, below elf->segments.count.
+ */
+void elf_segment(const ElfFile *elf, size_t index, ElfSegment *segment);
+
+/**
+ * @brief Prepares the view of a SHT_SYMTAB or SHT_DYNSYM section and of its linked string table.
+ *
+ * @return ElfStatus ELF_OK, ELF_ERROR_TRUNCATED or ELF_ERROR_BAD_TABLE.
+ */
+ElfStatus elf_symbol_table(const ElfFile *elf, const ElfSection *section, ElfSymbolTable *table);
+
+/**
+ * @brief Decodes a symbol.
+ *
+ * @param index Index of the symbol, below table->symbols.count.
+ */
+void elf_symbol(const ElfFile *elf, const ElfSymbolTable *table, size_t index, ElfSymbol *symbol);
+
+/**
+ * @brief Returns a string of a string table.
+ *
+ * @return const char* The string, or NULL if the offset is outside of the table or the
+ *         string is not terminated inside it.
+ */
+const char *elf_string(const char *strings, size_t size, uint64_t offset);
+
+#endif
@@ -0,0 +1,401 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        elf_size.c             *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include "elf_size.h"
+
+/*****************************            Types                  ********************************/
+
+/* Size of a symbol name in the two compared files (symbols sharing a name are added) */
+typedef struct {
+    const char *name;
+    uint64_t old_size;
+    uint64_t new_size;
+} SymbolChange;
+
+/*****************************        Static Functions           ********************************/
+
+/* The size(1) group of a section, NULL when it does not take memory at run time */
+static const char *section_group(const ElfSection *section)
+{
+    if (!(section->flags & SHF_ALLOC)) {
+        return NULL;
+    }
+    if (section->type == SHT_NOBITS) {
+        return "bss";
+    }
+    return (section->flags & SHF_WRITE) ? "data" : "text";
+}
+
+static const char *symbol_type(unsigned char info)
+{
+    switch (ELF64_ST_TYPE(info)) {
+    case STT_OBJECT:    return "OBJECT";
+    case STT_FUNC:      return "FUNC";
+    case STT_SECTION:   return "SECTION";
+    case STT_FILE:      return "FILE";
+    case STT_COMMON:    return "COMMON";
+    case STT_TLS:       return "TLS";
+    case STT_GNU_IFUNC: return "IFUNC";
+    default:            return "NOTYPE";
+    }
+}
+
+static const char *symbol_bind(unsigned char info)
+{
+    switch (ELF64_ST_BIND(info)) {
+    case STB_LOCAL:     return "LOCAL";
+    case STB_GLOBAL:    return "GLOBAL";
+    case STB_WEAK:      return "WEAK";
+    case STB_GNU_UNIQUE: return "UNIQUE";
+    default:            return "OTHER";
+    }
+}
+
+/* Name of the section a symbol is defined in */
+static const char *symbol_section(const ElfFile *elf, uint16_t shndx)
+{
+    ElfSection section;
+
+    switch (shndx) {
+    case SHN_UNDEF:     return "UND";
+    case SHN_ABS:       return "ABS";
+    case SHN_COMMON:    return "COM";
+    default:
+        if (shndx >= SHN_LORESERVE || shndx >= elf->sections.count) {
+            return "?";
+        }
+        elf_section(elf, shndx, &section);
+        const char *name = elf_section_name(elf, &section);
+        return name != NULL ? name : "?";
+    }
+}
+
+static int compare_size_desc(const void *a, const void *b)
+{
+    const ElfSizedSymbol *left = a;
+    const ElfSizedSymbol *right = b;
+
+    if (left->size != right->size) {
+        return left->size < right->size ? 1 : -1;
+    }
+    return strcmp(left->name, right->name);
+}
+
+static int compare_name(const void *a, const void *b)
+{
+    return strcmp(((const ElfSizedSymbol *)a)->name, ((const ElfSizedSymbol *)b)->name);
+}
+
+static uint64_t change_magnitude(const SymbolChange *change)
+{
+    return change->new_size > change->old_size ? change->new_size - change->old_size
+                                               : change->old_size - change->new_size;
+}
+
+static int compare_change(const void *a, const void *b)
+{
+    uint64_t left = change_magnitude(a);
+    uint64_t right = change_magnitude(b);
+
+    if (left != right) {
+        return left < right ? 1 : -1;
+    }
+    return strcmp(((const SymbolChange *)a)->name, ((const SymbolChange *)b)->name);
+}
+
+/* Collects the sized symbols sorted by name, with the sizes of a repeated name added together */
+static ElfStatus merged_symbols(const ElfFile *elf, ElfSizedSymbol **symbols, size_t *count)
+{
+    ElfStatus status = elf_sized_symbols(elf, symbols, count);
+    if (status != ELF_OK || *count == 0) {
+        return status;
+    }
+
+    qsort(*symbols, *count, sizeof(**symbols), compare_name);
+
+    size_t merged = 0;
+    for (size_t i = 1; i < *count; i++) {
+        if (strcmp((*symbols)[merged].name, (*symbols)[i].name) == 0) {
+            (*symbols)[merged].size += (*symbols)[i].size;
+        } else {
+            (*symbols)[++merged] = (*symbols)[i];
+        }
+    }
+    *count = merged + 1;
+    return ELF_OK;
+}
+
+static void print_delta(uint64_t old_size, uint64_t new_size)
+{
+    if (new_size >= old_size) {
+        printf("%+12" PRId64, (int64_t)(new_size - old_size));
+    } else {
+        printf("%12" PRId64, -(int64_t)(old_size - new_size));
+    }
+}
+
+static void print_total_change(const char *name, uint64_t old_size, uint64_t new_size)
+{
+    printf("  %-24s %12" PRIu64 " %12" PRIu64, name, old_size, new_size);
+    print_delta(old_size, new_size);
+    printf("\n");
+}
+
+static void print_section_diff(const ElfFile *old_elf, const ElfFile *new_elf)
+{
+    ElfSection old_section, new_section;
+    int changes = 0;
+
+    printf("Section sizes:\n");
+    printf("  %-24s %12s %12s %12s\n", "Name", "Old", "New", "Delta");
+
+    /* Sections of the new file, with their size in the old one (0 when they were added) */
+    for (size_t i = 1; i < new_elf->sections.count; i++) {
+        elf_section(new_elf, i, &new_section);
+        const char *name = elf_section_name(new_elf, &new_section);
+        if (name == NULL || section_group(&new_section) == NULL) {
+            continue;
+        }
+        uint64_t old_size = 0;
+        if (elf_find_section(old_elf, name, &old_section) >= 0) {
+            old_size = old_section.size;
+        }
+        if (old_size != new_section.size) {
+            print_total_change(name, old_size, new_section.size);
+            changes++;
+        }
+    }
+
+    /* Sections that were removed */
+    for (size_t i = 1; i < old_elf->sections.count; i++) {
+        elf_section(old_elf, i, &old_section);
+        const char *name = elf_section_name(old_elf, &old_section);
+        if (name == NULL || section_group(&old_section) == NULL) {
+            continue;
+        }
+        if (elf_find_section(new_elf, name, NULL) < 0) {
+            print_total_change(name, old_section.size, 0);
+            changes++;
+        }
+    }
+
+    if (changes == 0) {
+        printf("  (no change)\n");
+    }
+
+    ElfSizeTotals old_totals, new_totals;
+    elf_size_totals(old_elf, &old_totals);
+    elf_size_totals(new_elf, &new_totals);
+
+    printf("\nTotals:\n");
+    print_total_change("text", old_totals.text, new_totals.text);
+    print_total_change("data", old_totals.data, new_totals.data);
+    print_total_change("bss", old_totals.bss, new_totals.bss);
+    print_total_change("dec", old_totals.text + old_totals.data + old_totals.bss,
+                       new_totals.text + new_totals.data + new_totals.bss);
+}
+
+/*****************************        Public Functions           ********************************/
+
+void elf_size_totals(const ElfFile *elf, ElfSizeTotals *totals)
+{
+    ElfSection section;
+
+    totals->text = totals->data = totals->bss = 0;
+
+    for (size_t i = 1; i < elf->sections.count; i++) {
+        elf_section(elf, i, &section);
+        const char *group = section_group(&section);
+        if (group == NULL) {
+            continue;
+        }
+        switch (group[0]) {
+        case 't':   totals->text += section.size; break;
+        case 'd':   totals->data += section.size; break;
+        default:    totals->bss += section.size; break;
+        }
+    }
+}
+
+ElfStatus elf_sized_symbols(const ElfFile *elf, ElfSizedSymbol **symbols, size_t *count)
+{
+    ElfSection section;
+    ElfSymbolTable table;
+    ElfSymbol symbol;
+
+    *symbols = NULL;
+    *count = 0;
+
+    if (elf_find_section(elf, ".symtab", &section) < 0 && elf_find_section(elf, ".dynsym", &section) < 0) {
+        return ELF_OK;
+    }
+
+    ElfStatus status = elf_symbol_table(elf, &section, &table);
+    if (status != ELF_OK) {
+        return status;
+    }
+    if (table.symbols.count == 0) {
+        return ELF_OK;
+    }
+
+    *symbols = malloc(table.symbols.count * sizeof(**symbols));
+    if (*symbols == NULL) {
+        errno = ENOMEM;
+        return ELF_ERROR_OPEN;
+    }
+
+    for (size_t i = 1; i < table.symbols.count; i++) {
+        elf_symbol(elf, &table, i, &symbol);
+        unsigned char type = ELF64_ST_TYPE(symbol.info);
+        if (symbol.size == 0 || symbol.shndx == SHN_UNDEF || type == STT_SECTION || type == STT_FILE) {
+            continue;
+        }
+        const char *name = elf_string(table.strings, table.strings_size, symbol.name);
+        (*symbols)[(*count)++] = (ElfSizedSymbol) {
+            .name = name != NULL ? name : "?",
+            .value = symbol.value,
+            .size = symbol.size,
+            .info = symbol.info,
+            .shndx = symbol.shndx
+        };
+    }
+
+    qsort(*symbols, *count, sizeof(**symbols), compare_size_desc);
+    return ELF_OK;
+}
+
+void elf_size_print(const ElfFile *elf, const char *path)
+{
+    ElfSection section;
+    ElfSizeTotals totals;
+    int width = elf->header.ident[EI_CLASS] == ELFCLASS32 ? 8 : 16;
+
+    printf("%-24s %10s  %-*s  %s\n", "Section", "Size", width, "Address", "Group");
+    for (size_t i = 1; i < elf->sections.count; i++) {
+        elf_section(elf, i, &section);
+        const char *group = section_group(&section);
+        if (group == NULL) {
+            continue;
+        }
+        const char *name = elf_section_name(elf, &section);
+        printf("%-24s %10" PRIu64 "  %0*" PRIx64 "  %s\n", name != NULL ? name : "?", section.size,
+               width, section.addr, group);
+    }
+
+    elf_size_totals(elf, &totals);
+    uint64_t total = totals.text + totals.data + totals.bss;
+
+    printf("\n%10s %10s %10s %10s %10s %s\n", "text", "data", "bss", "dec", "hex", "filename");
+    printf("%10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIx64 " %s\n",
+           totals.text, totals.data, totals.bss, total, total, path);
+}
+
+ElfStatus elf_size_print_top(const ElfFile *elf, size_t limit)
+{
+    ElfSizedSymbol *symbols;
+    size_t count;
+
+    ElfStatus status = elf_sized_symbols(elf, &symbols, &count);
+    if (status != ELF_OK) {
+        return status;
+    }
+
+    if (count > limit) {
+        count = limit;
+    }
+
+    printf("Largest symbols:\n");
+    printf("  %10s  %-7s %-6s %-20s %s\n", "Size", "Type", "Bind", "Section", "Name");
+    for (size_t i = 0; i < count; i++) {
+        printf("  %10" PRIu64 "  %-7s %-6s %-20s %s\n", symbols[i].size, symbol_type(symbols[i].info),
+               symbol_bind(symbols[i].info), symbol_section(elf, symbols[i].shndx), symbols[i].name);
+    }
+    if (count == 0) {
+        printf("  (no sized symbols)\n");
+    }
+
+    free(symbols);
+    return ELF_OK;
+}
+
+ElfStatus elf_size_print_diff(const ElfFile *old_elf, const ElfFile *new_elf, size_t limit)
+{
+    ElfSizedSymbol *old_symbols = NULL, *new_symbols = NULL;
+    size_t old_count, new_count;
+
+    ElfStatus status = merged_symbols(old_elf, &old_symbols, &old_count);
+    if (status == ELF_OK) {
+        status = merged_symbols(new_elf, &new_symbols, &new_count);
+    }
+    if (status != ELF_OK) {
+        free(old_symbols);
+        return status;
+    }
+
+    print_section_diff(old_elf, new_elf);
+
+    SymbolChange *changes = malloc((old_count + new_count + 1) * sizeof(*changes));
+    if (changes == NULL) {
+        free(old_symbols);
+        free(new_symbols);
+        errno = ENOMEM;
+        return ELF_ERROR_OPEN;
+    }
+
+    /* Both lists are sorted by name, walk them together */
+    size_t num_changes = 0, i = 0, j = 0;
+    while (i < old_count || j < new_count) {
+        int order = (i == old_count) ? 1 : (j == new_count) ? -1 : strcmp(old_symbols[i].name, new_symbols[j].name);
+        SymbolChange change = { NULL, 0, 0 };
+
+        if (order <= 0) {
+            change.name = old_symbols[i].name;
+            change.old_size = old_symbols[i++].size;
+        }
+        if (order >= 0) {
+            change.name = new_symbols[j].name;
+            change.new_size = new_symbols[j++].size;
+        }
+        if (change.old_size != change.new_size) {
+            changes[num_changes++] = change;
+        }
+    }
+
+    qsort(changes, num_changes, sizeof(*changes), compare_change);
+    size_t shown = (limit != 0 && num_changes > limit) ? limit : num_changes;
+
+    printf("\nSymbol sizes (%zu changed):\n", num_changes);
+    printf("  %12s %12s %12s  %s\n", "Old", "New", "Delta", "Name");
+    for (size_t k = 0; k < shown; k++) {
+        printf("  %12" PRIu64 " %12" PRIu64, changes[k].old_size, changes[k].new_size);
+        print_delta(changes[k].old_size, changes[k].new_size);
+        printf("  %s%s\n", changes[k].name,
+               changes[k].old_size == 0 ? " (added)" : changes[k].new_size == 0 ? " (removed)" : "");
+    }
+    if (num_changes == 0) {
+        printf("  (no change)\n");
+    } else if (shown < num_changes) {
+        printf("  ... %zu more\n", num_changes - shown);
+    }
+
+    free(changes);
+    free(old_symbols);
+    free(new_symbols);
+    return ELF_OK;
+}
@@ -0,0 +1,75 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        elf_size.h             *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef ELF_SIZE_H
+#define ELF_SIZE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../elf_reader/elf_reader.h"
+
+/* Section sizes grouped like size(1) does (Berkeley format) */
+typedef struct {
+    uint64_t text;                  /* Allocated, read-only: code, .rodata, .eh_frame... */
+    uint64_t data;                  /* Allocated, writable, stored in the file */
+    uint64_t bss;                   /* Allocated, not stored in the file (SHT_NOBITS) */
+} ElfSizeTotals;
+
+/* A symbol that occupies memory (size > 0), the name points into the mapped file */
+typedef struct {
+    const char *name;
+    uint64_t value;
+    uint64_t size;
+    unsigned char info;
+    uint16_t shndx;
+} ElfSizedSymbol;
+
+/**
+ * @brief Sums the allocated sections into text, data and bss.
+ */
+void elf_size_totals(const ElfFile *elf, ElfSizeTotals *totals);
+
+/**
+ * @brief Collects the symbols with a size from .symtab (.dynsym when the file is stripped).
+ *
+ * @param symbols Set to an array the caller frees, sorted by decreasing size.
+ * @param count Set to the number of symbols.
+ * @return ElfStatus ELF_OK, or the error of the symbol table (ELF_ERROR_OPEN with errno
+ *         ENOMEM if the array could not be allocated).
+ */
+ElfStatus elf_sized_symbols(const ElfFile *elf, ElfSizedSymbol **symbols, size_t *count);
+
+/**
+ * @brief Prints the allocated sections with their size(1) group, then the Berkeley totals.
+ */
+void elf_size_print(const ElfFile *elf, const char *path);
+
+/**
+ * @brief Prints the largest symbols.
+ *
+ * @param limit Number of symbols to print.
+ * @return ElfStatus ELF_OK, or the error of the symbol table.
+ */
+ElfStatus elf_size_print_top(const ElfFile *elf, size_t limit);
+
+/**
+ * @brief Compares two files by section size and by symbol size.
+ *
+ * Sections are matched by name, symbols by name (sizes of symbols sharing a name are added).
+ * Only the differences are printed, the symbols by decreasing absolute change.
+ *
+ * @param limit Maximum number of symbols printed, 0 for all of them.
+ * @return ElfStatus ELF_OK, or the error of one of the symbol tables.
+ */
+ElfStatus elf_size_print_diff(const ElfFile *old_elf, const ElfFile *new_elf, size_t limit);
+
+#endif
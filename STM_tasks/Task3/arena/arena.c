@@ -0,0 +1,163 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        arena.c                *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "../exit_status.h"
+
+#define ARENA_ALIGN(size)   (((size) + 15) & ~(size_t)15)
+
+/*****************************        Static Functions           ********************************/
+
+static ArenaBlock *new_block(size_t min_size)
+{
+    size_t size = min_size > ARENA_BLOCK_SIZE ? min_size : ARENA_BLOCK_SIZE;
+    ArenaBlock *block = malloc(sizeof(ArenaBlock) + size);
+    if (block == NULL) {
+        return NULL;
+    }
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+/* Tries to grow the last allocation of the arena to new_size bytes without moving it */
+static int arena_extend(Arena *arena, void *ptr, size_t new_size)
+{
+    ArenaBlock *block = arena->head;
+    if (block == NULL || ptr != arena->last) {
+        return 0;
+    }
+
+    size_t start = (char *)ptr - block->data;
+    if (start + ARENA_ALIGN(new_size) > block->size) {
+        return 0;
+    }
+
+    block->used = start + ARENA_ALIGN(new_size);
+    return 1;
+}
+
+/*****************************        Public Functions           ********************************/
+
+void *arena_alloc(Arena *arena, size_t size)
+{
+    size = ARENA_ALIGN(size ? size : 1);
+
+    if (arena->head == NULL || arena->head->used + size > arena->head->size) {
+        ArenaBlock *block = new_block(size);
+        if (block == NULL) {
+            return NULL;
+        }
+        block->next = arena->head;
+        arena->head = block;
+    }
+
+    void *ptr = arena->head->data + arena->head->used;
+    arena->head->used += size;
+    arena->last = ptr;
+    return ptr;
+}
+
+char *arena_strndup(Arena *arena, const char *str, size_t len)
+{
+    char *copy = arena_alloc(arena, len + 1);
+    if (copy != NULL) {
+        memcpy(copy, str, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+void arena_reset(Arena *arena)
+{
+    if (arena->head == NULL) {
+        return;
+    }
+
+    /* Keep only the oldest block, which is the standard sized one */
+    ArenaBlock *block = arena->head;
+    while (block->next != NULL) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    block->used = 0;
+    arena->head = block;
+    arena->last = NULL;
+}
+
+void arena_free(Arena *arena)
+{
+    ArenaBlock *block = arena->head;
+    while (block != NULL) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->last = NULL;
+}
+
+void strbuf_init(StrBuf *buf, Arena *arena)
+{
+    buf->arena = arena;
+    buf->data = NULL;
+    buf->len = 0;
+    buf->cap = 0;
+}
+
+void *arena_realloc(Arena *arena, void *ptr, size_t old_size, size_t new_size)
+{
+    if (ptr != NULL && arena_extend(arena, ptr, new_size)) {
+        return ptr;
+    }
+
+    void *new_ptr = arena_alloc(arena, new_size);
+    if (new_ptr != NULL && ptr != NULL) {
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    }
+    return new_ptr;
+}
+
+int strbuf_append(StrBuf *buf, const char *str, size_t len)
+{
+    /* Always keep room for the null terminator */
+    if (buf->data == NULL || buf->len + len + 1 > buf->cap) {
+        size_t new_cap = buf->cap ? buf->cap * 2 : 64;
+        while (new_cap < buf->len + len + 1) {
+            new_cap *= 2;
+        }
+
+        char *new_data = arena_realloc(buf->arena, buf->data, buf->len, new_cap);
+        if (new_data == NULL) {
+            return S_EXIT_MEM_ALLOC;
+        }
+        buf->data = new_data;
+        buf->cap = new_cap;
+    }
+
+    memcpy(buf->data + buf->len, str, len);
+    buf->len += len;
+    buf->data[buf->len] = '\0';
+    return S_EXIT_SUCCESS;
+}
+
+int strbuf_putc(StrBuf *buf, char c)
+{
+    return strbuf_append(buf, &c, 1);
+}
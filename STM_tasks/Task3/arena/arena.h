@@ -0,0 +1,103 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        arena.h                *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/* Size of the first block of an arena, bigger requests get a block of their own size */
+#define ARENA_BLOCK_SIZE    4096
+
+/* Blocks are chained so that previously returned pointers never move */
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;
+    size_t used;
+    char data[];
+} ArenaBlock;
+
+/* Bump allocator used for everything that lives as long as one command line */
+typedef struct {
+    ArenaBlock *head;
+    void *last;                     /* Last allocation, the only one that may be extended in place */
+} Arena;
+
+/* Growable string whose storage comes from an arena */
+typedef struct {
+    Arena *arena;
+    char *data;
+    size_t len;
+    size_t cap;
+} StrBuf;
+
+/**
+ * @brief Allocates size bytes from the arena (aligned for any type).
+ *
+ * @param arena The arena to allocate from.
+ * @param size Number of bytes.
+ * @return void* Pointer to the memory, or NULL if malloc failed.
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/**
+ * @brief Copies the first len characters of str into the arena and null-terminates them.
+ *
+ * @return char* The copy, or NULL if malloc failed.
+ */
+char *arena_strndup(Arena *arena, const char *str, size_t len);
+
+/**
+ * @brief Resizes an allocation of the arena.
+ *
+ * The last allocation is grown in place when its block has room, otherwise a new area is
+ * allocated and the old content copied (the old area is only reclaimed by arena_reset).
+ *
+ * @param arena The arena that owns ptr.
+ * @param ptr The allocation to resize, or NULL to allocate a new one.
+ * @param old_size Current size of the allocation in bytes.
+ * @param new_size Requested size in bytes.
+ * @return void* Pointer to the resized memory, or NULL if malloc failed.
+ */
+void *arena_realloc(Arena *arena, void *ptr, size_t old_size, size_t new_size);
+
+/**
+ * @brief Releases every allocation of the arena at once.
+ *
+ * The first block is kept for reuse so that a steady stream of short lines does not call malloc.
+ */
+void arena_reset(Arena *arena);
+
+/**
+ * @brief Frees all the memory owned by the arena.
+ */
+void arena_free(Arena *arena);
+
+/**
+ * @brief Initializes an empty string buffer backed by arena.
+ */
+void strbuf_init(StrBuf *buf, Arena *arena);
+
+/**
+ * @brief Appends len characters to the buffer, growing it when needed.
+ *
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_MEM_ALLOC if the buffer could not grow.
+ */
+int strbuf_append(StrBuf *buf, const char *str, size_t len);
+
+/**
+ * @brief Appends a single character to the buffer.
+ *
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_MEM_ALLOC if the buffer could not grow.
+ */
+int strbuf_putc(StrBuf *buf, char c);
+
+#endif
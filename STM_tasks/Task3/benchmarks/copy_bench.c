@@ -0,0 +1,172 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        copy_bench.c           *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*
+ * Measures the throughput of scp's copy strategies for file sizes from 4 KB up to a maximum
+ * size (x16 each step): the old 1 KB read/write loop, then each method of Copy_File_Data.
+ * The source file is in the page cache, so this measures the copy path, not the disk.
+ *
+ * Usage: ./benchmarks/copy_bench [directory] [max size in MB]   (default: /tmp 256)
+ *        ./benchmarks/copy_bench /data 4096                     (4 KB ... 4 GB)
+ */
+
+/*****************************            Includes               ********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+
+#include "../file_copy/file_copy.h"
+#include "../exit_status.h"
+
+/* Each measurement is repeated until it took at least this long */
+#define MIN_DURATION    0.2
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* The copy loop scp used before: 1 KB stack buffer, one read and one write per KB */
+static int copy_old_loop(int source_fd, int target_fd, CopyMethod method, off_t *copied)
+{
+    char buffer[1024];
+    ssize_t bytes_read;
+    (void)method;
+
+    *copied = 0;
+    while ((bytes_read = read(source_fd, buffer, sizeof(buffer))) > 0) {
+        if (write(target_fd, buffer, bytes_read) != bytes_read) {
+            return S_EXIT_OPEN_FILE_FAILED;
+        }
+        *copied += bytes_read;
+    }
+    return (bytes_read < 0) ? S_EXIT_READ_FILE_FAIL : S_EXIT_SUCCESS;
+}
+
+static int create_source(const char *path, off_t size)
+{
+    static char block[1 << 20];
+    memset(block, 'x', sizeof(block));
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    for (off_t done = 0; done < size; ) {
+        size_t n = (size - done < (off_t)sizeof(block)) ? (size_t)(size - done) : sizeof(block);
+        if (write(fd, block, n) != (ssize_t)n) {
+            close(fd);
+            return -1;
+        }
+        done += n;
+    }
+    close(fd);
+    return 0;
+}
+
+/* Returns the throughput in MB/s, or a negative value if the method is not supported */
+static double measure(const char *source, const char *target, off_t size,
+                      int (*copy)(int, int, CopyMethod, off_t *), CopyMethod method)
+{
+    double elapsed = 0;
+    long runs = 0;
+
+    do {
+        int source_fd = open(source, O_RDONLY);
+        int target_fd = open(target, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        off_t copied = 0;
+
+        if (source_fd < 0 || target_fd < 0) {
+            perror("open");
+            exit(1);
+        }
+
+        double start = now_seconds();
+        int ret = copy(source_fd, target_fd, method, &copied);
+        elapsed += now_seconds() - start;
+
+        close(source_fd);
+        close(target_fd);
+
+        if (ret != S_EXIT_SUCCESS || copied != size) {
+            return -1;
+        }
+        runs++;
+    } while (elapsed < MIN_DURATION);
+
+    return (double)size * runs / elapsed / (1024 * 1024);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *directory = (argc > 1) ? argv[1] : "/tmp";
+    long max_mb = (argc > 2) ? atol(argv[2]) : 256;
+    char source[4096];
+    char target[4096];
+
+    struct {
+        const char *name;
+        int (*copy)(int, int, CopyMethod, off_t *);
+        CopyMethod method;
+    } methods[] = {
+        { "old 1KB loop",    copy_old_loop,  COPY_METHOD_READ_WRITE },
+        { "read/write 1MB",  Copy_File_Data, COPY_METHOD_READ_WRITE },
+        { "sendfile",        Copy_File_Data, COPY_METHOD_SENDFILE },
+        { "copy_file_range", Copy_File_Data, COPY_METHOD_COPY_FILE_RANGE },
+        { "FICLONE",         Copy_File_Data, COPY_METHOD_CLONE },
+        { "auto (scp)",      Copy_File_Data, COPY_METHOD_AUTO },
+    };
+    int num_methods = sizeof(methods) / sizeof(methods[0]);
+
+    snprintf(source, sizeof(source), "%s/copy_bench_source", directory);
+    snprintf(target, sizeof(target), "%s/copy_bench_target", directory);
+
+    printf("%10s", "size");
+    for (int m = 0; m < num_methods; m++) {
+        printf(" %16s", methods[m].name);
+    }
+    printf("   (MB/s)\n");
+
+    for (off_t size = 4096; size <= (off_t)max_mb * 1024 * 1024; size *= 16) {
+        if (create_source(source, size) < 0) {
+            perror("Failed to create the source file");
+            return 1;
+        }
+
+        if (size >= 1024 * 1024) {
+            printf("%8ldMB", (long)(size / (1024 * 1024)));
+        } else {
+            printf("%8ldKB", (long)(size / 1024));
+        }
+
+        for (int m = 0; m < num_methods; m++) {
+            double rate = measure(source, target, size, methods[m].copy, methods[m].method);
+            if (rate < 0) {
+                printf(" %16s", "n/a");
+            } else {
+                printf(" %16.1f", rate);
+            }
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+
+    unlink(source);
+    unlink(target);
+    return 0;
+}
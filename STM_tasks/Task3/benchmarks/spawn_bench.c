@@ -0,0 +1,112 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        spawn_bench.c          *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*
+ * Measures how many external commands per second the shell can launch with:
+ *   1- the old path : fork the shell, fork again and exec `sh -c "cmd"`
+ *   2- fork + execv of the resolved program
+ *   3- posix_spawn of the resolved program (what Spawn_External_Command uses now)
+ *
+ * Usage: ./benchmarks/spawn_bench [launches] [program]   (default: 2000 /bin/true)
+ */
+
+/*****************************            Includes               ********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <spawn.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+extern char **__environ;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Old Execute_Single_Command + Execute_External_Command: two forks and a full sh startup */
+static void launch_fork_sh(const char *program)
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        pid_t inner = fork();
+        if (inner == 0) {
+            execlp("sh", "sh", "-c", program, (char *)NULL);
+            _exit(127);
+        }
+        waitpid(inner, NULL, 0);
+        _exit(0);
+    }
+    waitpid(pid, NULL, 0);
+}
+
+static void launch_fork_exec(const char *program)
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        char *argv[] = { (char *)program, NULL };
+        execv(program, argv);
+        _exit(127);
+    }
+    waitpid(pid, NULL, 0);
+}
+
+static void launch_posix_spawn(const char *program)
+{
+    pid_t pid;
+    char *argv[] = { (char *)program, NULL };
+    if (posix_spawn(&pid, program, NULL, NULL, argv, __environ) == 0) {
+        waitpid(pid, NULL, 0);
+    }
+}
+
+static void run(const char *name, void (*launch)(const char *), const char *program, int launches)
+{
+    double start = now_seconds();
+    for (int i = 0; i < launches; i++) {
+        launch(program);
+    }
+    double elapsed = now_seconds() - start;
+
+    printf("%-22s %8d launches in %7.3f s  => %9.1f launches/s  (%7.1f us each)\n",
+           name, launches, elapsed, launches / elapsed, elapsed * 1e6 / launches);
+}
+
+int main(int argc, char *argv[])
+{
+    int launches = (argc > 1) ? atoi(argv[1]) : 2000;
+    const char *program = (argc > 2) ? argv[2] : "/bin/true";
+
+    if (launches <= 0) {
+        fprintf(stderr, "Usage: %s [launches] [program]\n", argv[0]);
+        return 1;
+    }
+
+    /* A fatter parent makes fork() copy bigger page tables, like a long running shell */
+    size_t ballast_size = 64 << 20;
+    char *ballast = malloc(ballast_size);
+    if (ballast != NULL) {
+        memset(ballast, 1, ballast_size);
+    }
+
+    run("fork + fork + sh -c", launch_fork_sh, program, launches);
+    run("fork + execv", launch_fork_exec, program, launches);
+    run("posix_spawn", launch_posix_spawn, program, launches);
+
+    free(ballast);
+    return 0;
+}
@@ -23,63 +23,64 @@
 #include <sys/wait.h>
 #include <pwd.h>
 #include <sys/utsname.h>
+#include <spawn.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
 
 #include "cmds.h"
 #include "../exit_status.h"
 #include "../helper_functions/helpers.h"
+#include "../path_cache/path_cache.h"
+#include "../file_copy/file_copy.h"
+#include "../console/console.h"
+#include "../history/history.h"
+#include "../jobs/jobs.h"
+#include "../variables/variables.h"
+#include "../prompt/prompt.h"
+#include "../utilities/utils.h"
+#include "../proc_stats/proc_stats.h"
+#include "../event_loop/event_loop.h"
 
 /*****************************        Global Variables           ********************************/
 
 extern char ** __environ;
-ProcessHistory history[HISTORY_SIZE];
-static int history_index = 0;
-static int history_count = 0;
 
 /**************************        Internal Commands Implementation           ****************************/
 
-void print_prompt() 
-{
-    // Get the username
-    uid_t uid = getuid();
-    struct passwd *pw = getpwuid(uid);
-    if (pw == NULL) {
-        perror("Failed to get user info");
-        return;
-    }
-
-    // Get the hostname
-    char hostname[100];
-    if (gethostname(hostname, sizeof(hostname)) < 0) {
-        perror("Failed to get hostname");
-        return;
-    }
-
-    // Print the prompt
-    Write_syscall(STDOUT, pw->pw_name,blue);
-    Write_syscall(STDOUT, "@", blue);
-    Write_syscall(STDOUT, hostname, blue);
-    Write_syscall(STDOUT, ":",blue);
-
-}
-
 void Help_Command() {
     Write_syscall(STDOUT, "\nThe supported commands are:\n\n", blue);
     Write_syscall(STDOUT, "1- spwd: print working directory\n\n", blue);
     Write_syscall(STDOUT, "2- secho: print a user input string on stdout\n\n", blue);
     Write_syscall(STDOUT, "3- scp: copy a file to another file (cp {sourcePath} {targetPath})\n", blue);
-    Write_syscall(STDOUT, "    options: -a to append the source content to the end of the target file\n\n", green);
+    Write_syscall(STDOUT, "    options: -a to append the source content to the end of the target file\n", green);
+    Write_syscall(STDOUT, "             -r to copy a directory tree, -j N to copy N files in parallel\n\n", green);
     Write_syscall(STDOUT, "4- smv: move a file to another place (mv {sourcePath} {targetPath})\n", blue);
     Write_syscall(STDOUT, "    options: -f to force overwriting the target file if exists\n\n", green);
     Write_syscall(STDOUT, "5- scd: Change directory to the passed path\n\n", blue);
     Write_syscall(STDOUT, "6- senvir: print all the environment variables\n", blue);
     Write_syscall(STDOUT, "    if variable name is passed, it prints the value of this variable alone\n\n",green);
     Write_syscall(STDOUT, "7- stype: print the type of the command (Internal, External or Unsupported\n\n", blue);
-    Write_syscall(STDOUT, "8- sphist: print The last 10 commands with their exit status\n\n", blue);
+    Write_syscall(STDOUT, "8- sphist: print The last 10 commands with their exit status\n", blue);
+    Write_syscall(STDOUT, "    pass a number N to print the last N commands\n\n", green);
     Write_syscall(STDOUT, "9- shelp: print all the supported command with a brief info about each one\n\n", blue);
     Write_syscall(STDOUT, "10- sexit: terminate the shell\n\n", blue);
 
-    Write_syscall(STDOUT, "11- sfree: prints information about RAM\n\n",blue);
-    Write_syscall(STDOUT, "12- suptime: prints the system's uptime and idle time\n\n",blue);
+    Write_syscall(STDOUT, "11- sfree [-s N] [-c COUNT]: prints information about RAM (every N seconds with -s, -s 0 stops)\n\n",blue);
+    Write_syscall(STDOUT, "12- suptime [-s N] [-c COUNT]: prints the system's uptime, idle time and CPU usage\n\n",blue);
+    Write_syscall(STDOUT, "13- shash: print the remembered locations of external commands\n", blue);
+    Write_syscall(STDOUT, "    options: -r to forget all locations, or pass command names to look them up\n\n", green);
+    Write_syscall(STDOUT, "14- stime: print the time and memory used by the last command\n", blue);
+    Write_syscall(STDOUT, "    options: N for the last N commands, -s on|off to print a summary before each prompt\n\n", green);
+    Write_syscall(STDOUT, "15- sjobs: print the background and stopped jobs (-l to print their pids)\n\n", blue);
+    Write_syscall(STDOUT, "16- sfg: continue a job in the foreground (sfg [%N])\n\n", blue);
+    Write_syscall(STDOUT, "17- sbg: continue a stopped job in the background (sbg [%N])\n\n", blue);
+    Write_syscall(STDOUT, "18- swait: wait for the given jobs, or for all of them (swait [%N...])\n\n", blue);
+    Write_syscall(STDOUT, "19- sset: print the shell options, or change one with sset -o|+o OPTION\n", blue);
+    Write_syscall(STDOUT, "    pipefail: a pipeline fails with the status of its last failing stage\n", green);
+    Write_syscall(STDOUT, "    errexit: the shell exits when a command fails (like running it with -e)\n\n", green);
+    Write_syscall(STDOUT, "20- sps: print the running processes with their CPU and memory usage\n", blue);
+    Write_syscall(STDOUT, "    options: -s cpu|mem|name|pid to sort, -f NAME to filter, -n COUNT, -d MS between the two samples\n\n", green);
 
 }
 
@@ -113,8 +114,7 @@ int Copy_Command(char** Command_tokens)
     int flags = O_WRONLY|O_TRUNC;
     char *source_path = NULL;
     char *target_path = NULL;
-    char buffer[BUFFER_SIZE];
-    ssize_t bytesRead;
+    char tempPath[BUFFER_SIZE];
 
     flags = Process_Options(Command_tokens, &source_path, &target_path);
 
@@ -123,6 +123,42 @@ int Copy_Command(char** Command_tokens)
         return S_EXIT_NO_ARGS;
     }
 
+    /* scp -r [-j N] copies a whole directory tree */
+    int recursive = 0;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 1; Command_tokens[i] != NULL; i++) {
+        if (strcmp(Command_tokens[i], "-r") == 0) {
+            recursive = 1;
+        } else if (strcmp(Command_tokens[i], "-j") == 0 && Command_tokens[i + 1] != NULL) {
+            jobs = strtol(Command_tokens[++i], NULL, 10);
+            if (jobs < 1) {
+                Write_syscall(STDERR, "Error: -j needs a positive number of jobs\n", red);
+                return S_EXIT_INVALID_COMMAND;
+            }
+        }
+    }
+
+    if (recursive && is_directory(source_path) == EXIT_SUCCESS) {
+        if (strcmp(source_path, target_path) == 0) {
+            Write_syscall(STDERR, "Error: Source and Target files are the same\n", red);
+            return S_EXIT_SAME_OPERANDS; // Error
+        }
+
+        /* Like cp -r: copying into an existing directory creates target/basename(source) */
+        if (is_directory(target_path) == EXIT_SUCCESS) {
+            char *source_copy = strdup(source_path);
+            snprintf(tempPath, sizeof(tempPath), "%s/%s", target_path, source_copy ? basename(source_copy) : source_path);
+            free(source_copy);
+            target_path = tempPath;
+        }
+
+        int ret = Copy_Tree(source_path, target_path, (int)jobs);
+        if (ret == S_EXIT_SUCCESS) {
+            Write_syscall(STDOUT, "Directory copied successfully.\n", green);
+        }
+        return ret;
+    }
+
     if (is_file(source_path) != EXIT_SUCCESS) {
         Write_syscall(STDERR, "Error: Source path is not a file or does not exist.\n", red);
         return S_EXIT_FILE_NOT_FOUND; // Error
@@ -134,7 +170,6 @@ int Copy_Command(char** Command_tokens)
     }
 
     if (is_directory(target_path) == EXIT_SUCCESS) {
-        char tempPath[BUFFER_SIZE];
         char *source_filename = basename((char *)source_path);
         snprintf(tempPath, sizeof(tempPath), "%s/%s", target_path, source_filename);
         target_path = tempPath;
@@ -156,22 +191,20 @@ int Copy_Command(char** Command_tokens)
         return S_EXIT_OPEN_FILE_FAILED; // Error
     }
 
-    while ((bytesRead = read(source_fd, buffer, sizeof(buffer))) > 0) {
-        if (write(target_fd, buffer, bytesRead) != bytesRead) {
-            Write_syscall(STDERR, "Error writing to target file\n", red);
-            close(source_fd);
-            close(target_fd);
-            return S_EXIT_OPEN_FILE_FAILED; // Error
-        }
-    }
-
-    if (bytesRead == -1) {
-        Write_syscall(STDERR, "Error reading source file\n", red);
-    }
+    /* Reflink, copy_file_range or sendfile when possible, a large buffer otherwise */
+    int ret = Copy_File_Data(source_fd, target_fd, COPY_METHOD_AUTO, NULL);
 
     close(source_fd);
     close(target_fd);
 
+    if (ret == S_EXIT_READ_FILE_FAIL) {
+        Write_syscall(STDERR, "Error reading source file\n", red);
+        return ret; // Error
+    } else if (ret != S_EXIT_SUCCESS) {
+        Write_syscall(STDERR, "Error writing to target file\n", red);
+        return S_EXIT_OPEN_FILE_FAILED; // Error
+    }
+
     Write_syscall(STDOUT, "File copied successfully.\n", green);
     return EXIT_SUCCESS; // Success
 }
@@ -186,6 +219,7 @@ int Move_Command(char** Command_tokens) {
     char *source_path = NULL;
     char *target_path = NULL;
     char *source_filename;
+    char tempPath[BUFFER_SIZE];
     int flags;
 
     flags = Process_Options(Command_tokens, &source_path, &target_path);
@@ -197,7 +231,6 @@ int Move_Command(char** Command_tokens) {
 
     if (is_directory(target_path) == EXIT_SUCCESS) {
         source_filename = basename((char *)source_path);
-        char tempPath[BUFFER_SIZE];
         snprintf(tempPath, sizeof(tempPath), "%s/%s", target_path, source_filename);
         target_path = tempPath;
     }
@@ -207,38 +240,49 @@ int Move_Command(char** Command_tokens) {
         return S_EXIT_MODIFY_EXISTED_FILE; // Error
     }
 
+    /* On the same filesystem a move is just a new directory entry, no data is copied */
+    if (rename(source_path, target_path) == 0) {
+        Write_syscall(STDOUT, "File moved successfully.\n", green);
+        return EXIT_SUCCESS; // Success
+    }
+
+    if (errno != EXDEV) {
+        perror("Error moving file");
+        return (errno == ENOENT) ? S_EXIT_FILE_NOT_FOUND : S_EXIT_FAILURE; // Error
+    }
+
+    /* Different devices => copy the data then remove the source */
     int source_fd = open(source_path, O_RDONLY);
     if (source_fd == -1) {
         Write_syscall(STDERR, "Error opening source file\n", red);
         return S_EXIT_OPEN_FILE_FAILED; // Error
     }
 
-    int target_fd = open(target_path, flags, 0644);
+    struct stat source_stat;
+    fstat(source_fd, &source_stat);
+
+    int target_fd = open(target_path, flags, source_stat.st_mode & 07777);
     if (target_fd == -1) {
         Write_syscall(STDERR, "Error opening target file\n", red);
         close(source_fd);
         return S_EXIT_OPEN_FILE_FAILED; // Error
     }
 
-    char buffer[BUFFER_SIZE];
-    ssize_t bytesRead;
+    int ret = Copy_File_Data(source_fd, target_fd, COPY_METHOD_AUTO, NULL);
 
-    while ((bytesRead = read(source_fd, buffer, sizeof(buffer))) > 0) {
-        if (write(target_fd, buffer, bytesRead) != bytesRead) {
-            Write_syscall(STDERR, "Error writing to target file\n", red);
-            close(source_fd);
-            close(target_fd);
-            return S_EXIT_OPEN_FILE_FAILED; // Error
-        }
+    close(source_fd);
+    if (close(target_fd) < 0 && ret == S_EXIT_SUCCESS) {
+        ret = S_EXIT_OPEN_FILE_FAILED;
     }
 
-    if (bytesRead == -1) {
-        Write_syscall(STDERR, "Error reading source file\n", red);
+    /* Never remove the source unless the copy is complete */
+    if (ret != S_EXIT_SUCCESS) {
+        Write_syscall(STDERR, (ret == S_EXIT_READ_FILE_FAIL) ? "Error reading source file\n"
+                                                              : "Error writing to target file\n", red);
+        unlink(target_path);
+        return ret; // Error
     }
 
-    close(source_fd);
-    close(target_fd);
-
     if (remove(source_path) != 0) {
         perror("Error removing source file");
         return EXIT_FAILURE; // Error
@@ -255,13 +299,14 @@ int change_Directory_Command(char** Command_tokens) {
         return S_EXIT_INVALID_COMMAND; // Error
     }
 
-    printf("new dir: %s\n", Command_tokens[1]);
+    console_printf(STDOUT, NULL, "new dir: %s\n", Command_tokens[1]);
 
     int retValue = chdir(Command_tokens[1]);
     if (retValue < 0) {
         perror("Change directory failed");
         return EXIT_FAILURE; // Error
     }
+    prompt_directory_changed();
 
     return EXIT_SUCCESS; // Success
 }
@@ -322,173 +367,744 @@ void Type_of_Command(char** Command_tokens)
 }
 
 
-void add_to_history(const char* command, int exit_status) {
-    int fd = open("history.txt", O_WRONLY | O_APPEND | O_CREAT, 0644);
-    if (fd < 0) {
-        perror("Failed to open history file");
-        return;
+int History_Command(char **Command_tokens)
+{
+    size_t count = HISTORY_SIZE;
+
+    if (Command_tokens[1] != NULL) {
+        char *end;
+        long value = strtol(Command_tokens[1], &end, 10);
+        if (*end != '\0' || value <= 0) {
+            Write_syscall(STDERR, "Error: sphist expects a positive number of commands\n", red);
+            return S_EXIT_INVALID_COMMAND;
+        }
+        count = value;
     }
 
-    char buffer[BUFFER_SIZE];
-    
-    // Format command with padding
-    char formatted_command[MAX_COMMAND_LENGTH + 1];
-    snprintf(formatted_command, sizeof(formatted_command), "%-*s", MAX_COMMAND_LENGTH, command);
-
-    // Write to buffer
-    snprintf(buffer, sizeof(buffer), "%s %d\n", formatted_command, exit_status);
-    write(fd, buffer, strlen(buffer));
-    close(fd);
+    cmd_history_print(count);
+    return S_EXIT_SUCCESS;
+}
+
+/* Whether fd is open in the new process once the redirections before stop are applied */
+static int is_open_after(const Redirection *redirections, const Redirection *stop, int fd)
+{
+    int flags = fcntl(fd, F_GETFD);
+    int is_open = (flags >= 0 && !(flags & FD_CLOEXEC));
+
+    for (const Redirection *redirection = redirections; redirection != stop; redirection = redirection->next) {
+        if (redirection->fd == fd) {
+            is_open = (redirection->type != REDIR_CLOSE);
+        }
+    }
+    return is_open;
 }
 
-void print_history() {
-    int fd = open("history.txt", O_RDONLY);
-    if (fd < 0) {
-        perror("Failed to open history file");
-        return;
+/* Opens the file or here-document of a redirection in the shell (close-on-exec), -1 on failure */
+static int open_redirection(const Redirection *redirection)
+{
+    switch (redirection->type) {
+    case REDIR_INPUT:
+        return open(redirection->target, O_RDONLY | O_CLOEXEC);
+    case REDIR_OUTPUT:
+        return open(redirection->target, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    case REDIR_APPEND:
+        return open(redirection->target, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    default:
+        return Open_Here_Document(redirection->body ? redirection->body : "");
+    }
+}
+
+pid_t Spawn_External_Command(char **Command_tokens, const Redirection *redirections,
+                             int in_fd, int out_fd, const int *close_fds, int num_close_fds, pid_t pgid,
+                             int *failure_status)
+{
+    char full_path[BUFFER_SIZE];
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attributes;
+    sigset_t default_signals;
+    pid_t pid;
+    int ret;
+
+    /* Resolve the program in the shell so no intermediate sh is needed */
+    if (resolve_command_path(Command_tokens[0], full_path, sizeof(full_path)) != S_EXIT_SUCCESS) {
+        Write_syscall(STDERR, Command_tokens[0], red);
+        Write_syscall(STDERR, ": command not found\n", red);
+        *failure_status = S_EXIT_COMMAND_NOT_FOUND;
+        return -1;
+    }
+
+    posix_spawn_file_actions_init(&actions);
+
+    /* Connect the pipes first, explicit redirections take precedence over them */
+    if (in_fd >= 0 && in_fd != STDIN) {
+        posix_spawn_file_actions_adddup2(&actions, in_fd, STDIN);
+    }
+    if (out_fd >= 0 && out_fd != STDOUT) {
+        posix_spawn_file_actions_adddup2(&actions, out_fd, STDOUT);
+    }
+    for (int i = 0; i < num_close_fds; i++) {
+        posix_spawn_file_actions_addclose(&actions, close_fds[i]);
     }
 
-    char buffer[BUFFER_SIZE];
-    ssize_t bytesRead;
-    int count = 1;
-    while ((bytesRead = read(fd, buffer, sizeof(buffer) - 1)) > 0) {
-        buffer[bytesRead] = '\0';
+    /* Files and here-documents are opened by the shell and handed over, so a failure is reported
+       with the file name before anything is started */
+    int num_opened = 0;
+    for (const Redirection *redirection = redirections; redirection != NULL; redirection = redirection->next) {
+        num_opened += (redirection->type != REDIR_DUP && redirection->type != REDIR_CLOSE);
+    }
+    int *opened = NULL;
+    if (num_opened > 0 && (opened = malloc(num_opened * sizeof(int))) == NULL) {
+        perror("Failed to allocate memory");
+        posix_spawn_file_actions_destroy(&actions);
+        *failure_status = S_EXIT_MEM_ALLOC;
+        return -1;
+    }
+    num_opened = 0;
+    int failed = 0;
+
+    for (const Redirection *redirection = redirections; redirection != NULL && !failed; redirection = redirection->next) {
+        switch (redirection->type) {
+        case REDIR_DUP:
+            /* n>&m: m must be open in the program, it may come from an earlier redirection */
+            if (!is_open_after(redirections, redirection, redirection->target_fd)) {
+                console_printf(STDERR, red, "%d: bad file descriptor\n", redirection->target_fd);
+                failed = 1;
+                break;
+            }
+            posix_spawn_file_actions_adddup2(&actions, redirection->target_fd, redirection->fd);
+            break;
+        case REDIR_CLOSE:
+            posix_spawn_file_actions_addclose(&actions, redirection->fd);
+            break;
+        default: {
+            int fd = open_redirection(redirection);
+            if (fd < 0) {
+                int is_file = (redirection->type == REDIR_INPUT || redirection->type == REDIR_OUTPUT ||
+                               redirection->type == REDIR_APPEND);
+                perror(is_file ? redirection->target : "here-document");
+                failed = 1;
+                break;
+            }
+            opened[num_opened++] = fd;
+            posix_spawn_file_actions_adddup2(&actions, fd, redirection->fd);
+            break;
+        }
+        }
+    }
 
-        char *line = strtok(buffer, "\n");
-        while (line != NULL) {
-            printf("%d: %s\n", count++, line);
-            line = strtok(NULL, "\n");
+    if (failed) {
+        for (int i = 0; i < num_opened; i++) {
+            close(opened[i]);
         }
+        free(opened);
+        posix_spawn_file_actions_destroy(&actions);
+        *failure_status = S_EXIT_FAILURE;
+        return -1;
     }
 
-    if (bytesRead < 0) {
-        perror("Failed to read history file");
+    /* The job control signals ignored by the shell are restored, the signals it reads from a
+       signalfd are unblocked, and the job gets its group */
+    posix_spawnattr_init(&attributes);
+    sigemptyset(&default_signals);
+    sigaddset(&default_signals, SIGTSTP);
+    sigaddset(&default_signals, SIGTTIN);
+    sigaddset(&default_signals, SIGTTOU);
+    posix_spawnattr_setsigdefault(&attributes, &default_signals);
+    sigemptyset(&default_signals);
+    posix_spawnattr_setsigmask(&attributes, &default_signals);
+    if (pgid >= 0) {
+        posix_spawnattr_setpgroup(&attributes, pgid);
+        posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETPGROUP);
+    } else {
+        posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
     }
 
-    close(fd);
-}
+    /* Whatever the shell printed so far must appear before the program's output */
+    console_flush_all();
+
+    /* posix_spawn uses vfork semantics: no page table copy of the shell */
+    ret = posix_spawn(&pid, full_path, &actions, &attributes, Command_tokens, __environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
 
-int Execute_External_Command(char **Command_tokens) {
+    for (int i = 0; i < num_opened; i++) {
+        close(opened[i]);
+    }
+    free(opened);
 
-    char *argv[10]; // Ensure this is large enough for your needs
+    if (ret != 0) {
+        errno = ret;
+        perror(Command_tokens[0]);
+        *failure_status = S_EXIT_COMMAND_NOT_FOUND;
+        return -1;
+    }
 
-    pid_t retPID = fork();
-    int exit_status;
+    return pid;
+}
 
-    if (retPID < 0) {
-        perror("fork");
-        return S_EXIT_FAILURE;
-    } else if (retPID == 0) {
-        // In child process
-        argv[0] = "sh";
-        argv[1] = "-c";
-
-        // Allocate memory for the command string
-        size_t total_length = 1; // Start with 1 for the null terminator
-        for (int i = 0; Command_tokens[i] != NULL; i++) {
-            total_length += strlen(Command_tokens[i]) + 1; // +1 for the space
+int Time_Command(char **Command_tokens)
+{
+    if (Command_tokens[1] != NULL && strcmp(Command_tokens[1], "-s") == 0) {
+        if (Command_tokens[2] != NULL && strcmp(Command_tokens[2], "on") == 0) {
+            cmd_history_set_summary(1);
+        } else if (Command_tokens[2] != NULL && strcmp(Command_tokens[2], "off") == 0) {
+            cmd_history_set_summary(0);
+        } else {
+            Write_syscall(STDERR, "Error: stime -s expects on or off\n", red);
+            return S_EXIT_INVALID_COMMAND;
         }
+        return S_EXIT_SUCCESS;
+    }
 
-        char *cmd = malloc(total_length);
-        if (cmd == NULL) {
-            perror("malloc failed");
-            return S_EXIT_FAILURE;
+    size_t count = 1;
+    if (Command_tokens[1] != NULL) {
+        char *end;
+        long value = strtol(Command_tokens[1], &end, 10);
+        if (*end != '\0' || value <= 0) {
+            Write_syscall(STDERR, "Error: stime expects a positive number of commands\n", red);
+            return S_EXIT_INVALID_COMMAND;
         }
+        count = value;
+    }
 
-        // Initialize the cmd string
-        cmd[0] = '\0';
+    cmd_history_print_times(count);
+    return S_EXIT_SUCCESS;
+}
 
-        // Concatenate Command_tokens
-        for (int i = 0; Command_tokens[i] != NULL; i++) {
-            strcat(cmd, Command_tokens[i]);
-            if (Command_tokens[i + 1] != NULL) {
-                strcat(cmd, " "); // Add a space between Command_tokens
-            }
+int Set_Command(char **Command_tokens)
+{
+    static const struct {
+        const char *name;
+        int option;
+    } options[] = {
+        { "errexit",  SHELL_OPTION_ERREXIT },
+        { "pipefail", SHELL_OPTION_PIPEFAIL },
+    };
+    size_t num_options = sizeof(options) / sizeof(options[0]);
+
+    if (Command_tokens[1] == NULL) {
+        for (size_t i = 0; i < num_options; i++) {
+            console_printf(STDOUT, NULL, "%s\t%s\n", options[i].name, get_shell_option(options[i].option) ? "on" : "off");
         }
+        return S_EXIT_SUCCESS;
+    }
 
-        argv[2] = cmd;
-        argv[3] = NULL; // Null-terminate the argv array
+    int enabled = (strcmp(Command_tokens[1], "-o") == 0);
+    if ((!enabled && strcmp(Command_tokens[1], "+o") != 0) || Command_tokens[2] == NULL) {
+        Write_syscall(STDERR, "Error: sset expects -o OPTION or +o OPTION\n", red);
+        return S_EXIT_INVALID_COMMAND;
+    }
 
-        if (execvp("sh", argv) < 0) {
-            perror("execvp");
-            free(cmd); // Free the allocated memory
-            return S_EXIT_FAILURE;
+    for (size_t i = 0; i < num_options; i++) {
+        if (strcmp(Command_tokens[2], options[i].name) == 0) {
+            set_shell_option(options[i].option, enabled);
+            return S_EXIT_SUCCESS;
         }
-    } else {
-        // In parent process
-        int status;
-        waitpid(retPID, &status, 0);
+    }
+
+    console_printf(STDERR, red, "Error: %s: unknown option\n", Command_tokens[2]);
+    return S_EXIT_INVALID_COMMAND;
+}
+
+int Jobs_Command(char **Command_tokens)
+{
+    jobs_reap();
+    jobs_print(Command_tokens[1] != NULL && strcmp(Command_tokens[1], "-l") == 0);
+    return S_EXIT_SUCCESS;
+}
+
+int Foreground_Command(char **Command_tokens)
+{
+    jobs_reap();
+
+    Job *job = job_find(Command_tokens[1]);
+    if (job == NULL) {
+        Write_syscall(STDERR, "sfg: no such job\n", red);
+        return S_EXIT_INVALID_COMMAND;
+    }
+
+    return job_continue(job, 1);
+}
+
+int Background_Command(char **Command_tokens)
+{
+    int Exit_Status = S_EXIT_SUCCESS;
+    int i = 1;
 
-        if (WIFEXITED(status)) {
-            exit_status = WEXITSTATUS(status);
+    jobs_reap();
+
+    /* Without arguments the most recent job is continued */
+    do {
+        Job *job = job_find(Command_tokens[1] ? Command_tokens[i] : NULL);
+        if (job == NULL) {
+            Write_syscall(STDERR, "sbg: no such job\n", red);
+            Exit_Status = S_EXIT_INVALID_COMMAND;
         } else {
-            exit_status = S_EXIT_FAILURE;
+            job_continue(job, 0);
         }
+    } while (Command_tokens[1] != NULL && Command_tokens[++i] != NULL);
+
+    return Exit_Status;
+}
+
+int Wait_Command(char **Command_tokens)
+{
+    int Exit_Status = S_EXIT_SUCCESS;
+
+    jobs_reap();
 
-        // Assuming add_to_history is defined elsewhere
-        add_to_history(Command_tokens[0], exit_status);
+    if (Command_tokens[1] == NULL) {
+        return jobs_wait_all();
     }
 
-    return exit_status;
+    for (int i = 1; Command_tokens[i] != NULL; i++) {
+        Job *job = job_find(Command_tokens[i]);
+        if (job == NULL) {
+            Write_syscall(STDERR, "swait: no such job\n", red);
+            Exit_Status = S_EXIT_INVALID_COMMAND;
+            continue;
+        }
+        Exit_Status = job_wait(job);
+    }
+
+    return Exit_Status;
 }
 
-int Free_Command(void)
+int Hash_Command(char **Command_tokens)
 {
-    char buffer[BUFFER_SIZE];
-    ssize_t bytesRead;
-    int count = 1;
+    char full_path[BUFFER_SIZE];
+    int Exit_Status = S_EXIT_SUCCESS;
 
-    int fd = open("/proc/meminfo", O_RDONLY);
-    if(fd<0)
-    {
-        perror("Failed opening meminfo");
+    if (Command_tokens[1] == NULL) {
+        path_cache_print();
+        return S_EXIT_SUCCESS;
+    }
+
+    for (int i = 1; Command_tokens[i] != NULL; i++) {
+        if (strcmp(Command_tokens[i], "-r") == 0) {
+            path_cache_clear();
+        } else if (resolve_command_path(Command_tokens[i], full_path, sizeof(full_path)) != S_EXIT_SUCCESS) {
+            Write_syscall(STDERR, Command_tokens[i], red);
+            Write_syscall(STDERR, ": not found\n", red);
+            Exit_Status = S_EXIT_COMMAND_NOT_FOUND;
+        }
     }
 
+    return Exit_Status;
+}
+
+/* Live refresh of sfree / suptime (-s N), the previous tick is kept to print the changes */
+typedef struct StatsWatch {
+    const char *name;
+    int (*print)(struct StatsWatch *watch);
+    int timer;                      /* timerfd of the refresh in the event loop, -1 if off */
+    long remaining;                 /* Ticks left, -1 without -c */
+    int has_previous;
+    struct timespec previous_time;
+    MemoryStats memory;
+    CpuStats cpu;
+} StatsWatch;
+
+static int print_memory(StatsWatch *watch);
+static int print_uptime(StatsWatch *watch);
+
+static StatsWatch free_watch = { "sfree", print_memory, -1, -1, 0, { 0, 0 }, { 0 }, { 0 } };
+static StatsWatch uptime_watch = { "suptime", print_uptime, -1, -1, 0, { 0, 0 }, { 0 }, { 0 } };
+
+/* Seconds since the previous tick of the watch (and remembers now for the next one) */
+static double seconds_since_previous(StatsWatch *watch)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    double elapsed = (now.tv_sec - watch->previous_time.tv_sec) +
+                     (now.tv_nsec - watch->previous_time.tv_nsec) / 1e9;
+    watch->previous_time = now;
+    return elapsed;
+}
+
+static int print_memory(StatsWatch *watch)
+{
+    MemoryStats current;
+    char columns[6][32];
+
+    int ret = proc_read_memory(&current);
+    if (ret != S_EXIT_SUCCESS) {
+        return ret;
+    }
+    double elapsed = seconds_since_previous(watch);
 
-    while ((bytesRead = read(fd, buffer, sizeof(buffer) - 1)) > 0) {
-        buffer[bytesRead] = '\0';
+    /* Computed like free(1): buff/cache includes the reclaimable slab */
+    double cache = current.buffers + current.cached + current.reclaimable;
+    double used = (double)current.total - current.free - cache;
+    if (used < 0) {
+        used = (double)current.total - current.free;
+    }
 
-        char *line = strtok(buffer, "\n");
-        while (line != NULL) {
-            Write_syscall(STDOUT, line,blue);
-            
-            Write_syscall(STDOUT, "\n",white);
-            line = strtok(NULL, "\n");
+    console_printf(STDOUT, blue, "%-8s%12s%12s%12s%12s%12s%12s\n", "", "total", "used", "free", "shared", "buff/cache", "available");
+    console_printf(STDOUT, NULL, "%-8s%12s%12s%12s%12s%12s%12s\n", "Mem:",
+                   proc_format_size(columns[0], sizeof(columns[0]), current.total, 0),
+                   proc_format_size(columns[1], sizeof(columns[1]), used, 0),
+                   proc_format_size(columns[2], sizeof(columns[2]), current.free, 0),
+                   proc_format_size(columns[3], sizeof(columns[3]), current.shared, 0),
+                   proc_format_size(columns[4], sizeof(columns[4]), cache, 0),
+                   proc_format_size(columns[5], sizeof(columns[5]), current.available, 0));
+    console_printf(STDOUT, NULL, "%-8s%12s%12s%12s\n", "Swap:",
+                   proc_format_size(columns[0], sizeof(columns[0]), current.swap_total, 0),
+                   proc_format_size(columns[1], sizeof(columns[1]), (double)current.swap_total - current.swap_free, 0),
+                   proc_format_size(columns[2], sizeof(columns[2]), current.swap_free, 0));
+
+    if (watch->has_previous && elapsed > 0) {
+        const MemoryStats *previous = &watch->memory;
+        double previous_cache = previous->buffers + previous->cached + previous->reclaimable;
+        double changes[5] = {
+            ((double)current.total - current.free - cache) - ((double)previous->total - previous->free - previous_cache),
+            (double)current.free - previous->free,
+            (double)current.shared - previous->shared,
+            cache - previous_cache,
+            (double)current.available - previous->available,
+        };
+        const char *labels[2] = { "Change:", "Per sec:" };
+
+        for (int row = 0; row < 2; row++) {
+            for (int i = 0; i < 5; i++) {
+                proc_format_size(columns[i], sizeof(columns[i]), row ? changes[i] / elapsed : changes[i], 1);
+            }
+            console_printf(STDOUT, NULL, "%-8s%12s%12s%12s%12s%12s%12s\n", labels[row], "",
+                           columns[0], columns[1], columns[2], columns[3], columns[4]);
         }
     }
 
-    if (bytesRead < 0) {
-        perror("Failed to read history file");
+    watch->memory = current;
+    watch->has_previous = 1;
+    return S_EXIT_SUCCESS;
+}
+
+static int print_uptime(StatsWatch *watch)
+{
+    UptimeStats uptime;
+    CpuStats current;
+
+    int ret = proc_read_uptime(&uptime);
+    if (ret == S_EXIT_SUCCESS) {
+        ret = proc_read_cpu(&current);
+    }
+    if (ret != S_EXIT_SUCCESS) {
+        return ret;
+    }
+    double elapsed = seconds_since_previous(watch);
+
+    long seconds = (long)uptime.uptime;
+    console_printf(STDOUT, NULL, "System Uptime: %.2f seconds (%ld days, %02ld:%02ld:%02ld)\n", uptime.uptime,
+                   seconds / 86400, seconds / 3600 % 24, seconds / 60 % 60, seconds % 60);
+    console_printf(STDOUT, NULL, "Idle Time: %.2f seconds\n", uptime.idle);
+
+    /* Share of each CPU state since the previous tick, or since boot the first time */
+    CpuStats delta = current;
+    if (watch->has_previous) {
+        const CpuStats *previous = &watch->cpu;
+        delta.user -= previous->user;
+        delta.nice -= previous->nice;
+        delta.system -= previous->system;
+        delta.idle -= previous->idle;
+        delta.iowait -= previous->iowait;
+        delta.irq -= previous->irq;
+        delta.softirq -= previous->softirq;
+        delta.steal -= previous->steal;
     }
 
-    close(fd);
+    double total = proc_cpu_total(&delta);
+    if (total > 0) {
+        if (watch->has_previous) {
+            console_printf(STDOUT, blue, "CPU (last %.1fs):", elapsed);
+        } else {
+            console_printf(STDOUT, blue, "CPU (since boot):");
+        }
+        console_printf(STDOUT, NULL, " user %.1f%%  nice %.1f%%  system %.1f%%  iowait %.1f%%  irq %.1f%%  steal %.1f%%  idle %.1f%%\n",
+                       100 * delta.user / total, 100 * delta.nice / total, 100 * delta.system / total,
+                       100 * delta.iowait / total, 100 * (delta.irq + delta.softirq) / total,
+                       100 * delta.steal / total, 100 * delta.idle / total);
+    }
 
+    watch->cpu = current;
+    watch->has_previous = 1;
+    return S_EXIT_SUCCESS;
+}
 
+static void stop_watch(StatsWatch *watch)
+{
+    if (watch->timer >= 0) {
+        event_loop_remove_timer(watch->timer);
+        watch->timer = -1;
+    }
 }
 
-int Uptime_Command(void)
+/* Timer callback: one refresh printed above the line being typed */
+static void watch_tick(void *context)
 {
-    int fd = open("/proc/uptime", O_RDONLY);
-    if (fd < 0) {
-        perror("Failed to open /proc/uptime");
+    StatsWatch *watch = context;
+
+    event_loop_output_begin();
+    console_write(STDOUT, "\n", 1, NULL);
+    int ret = watch->print(watch);
+    event_loop_output_end();
+
+    if (ret != S_EXIT_SUCCESS || (watch->remaining > 0 && --watch->remaining == 0)) {
+        stop_watch(watch);
     }
+}
 
-    char buffer[BUFFER_SIZE];
-    ssize_t bytes_read = read(fd, buffer, sizeof(buffer) - 1);
-    if (bytes_read < 0) {
-        perror("Failed to read /proc/uptime");
-        close(fd);
+/**
+ * Runs sfree / suptime with their options:
+ *   -s N       refresh every N seconds (fractions allowed), -s 0 stops a running refresh
+ *   -c COUNT   stop after COUNT refreshes (every second when -s is not given)
+ * At the interactive prompt the refresh runs on a timer of the event loop, so the shell keeps
+ * reading commands. Elsewhere (scripts, pipelines, background jobs) it runs in the foreground.
+ */
+static int run_stats_command(StatsWatch *watch, char **Command_tokens)
+{
+    double interval = -1;
+    long count = -1;
+
+    for (int i = 1; Command_tokens[i] != NULL; i++) {
+        char *end = NULL;
+        if (strcmp(Command_tokens[i], "-s") == 0 && Command_tokens[i + 1] != NULL) {
+            interval = strtod(Command_tokens[++i], &end);
+            if (*end == '\0' && interval >= 0 && interval <= 86400) {
+                continue;
+            }
+        } else if (strcmp(Command_tokens[i], "-c") == 0 && Command_tokens[i + 1] != NULL) {
+            count = strtol(Command_tokens[++i], &end, 10);
+            if (*end == '\0' && count > 0) {
+                continue;
+            }
+        }
+        console_printf(STDERR, red, "Error: usage: %s [-s SECONDS] [-c COUNT]\n", watch->name);
+        return S_EXIT_INVALID_COMMAND;
     }
 
-    buffer[bytes_read] = '\0'; // Null-terminate the buffer
+    if (interval == 0) {
+        stop_watch(watch);
+        return S_EXIT_SUCCESS;
+    }
+    if (interval < 0 && count < 0) {
+        StatsWatch once = *watch;
+        once.has_previous = 0;
+        return once.print(&once);
+    }
+    if (interval < 0) {
+        interval = 1;
+    }
 
-    close(fd);
+    long interval_ms = (long)(interval * 1000 + 0.5);
+    if (interval_ms < 1) {
+        interval_ms = 1;
+    }
 
-    double uptime, idle_time;
-    if (sscanf(buffer, "%lf %lf", &uptime, &idle_time) != 2) {
-        fprintf(stderr, "Failed to parse /proc/uptime data\n");
+    if (event_loop_running()) {
+        if (!isatty(STDOUT) && count < 0) {
+            /* The redirection is undone when the builtin returns, the loop would block the shell */
+            console_printf(STDERR, red, "Error: %s -s with redirected output needs -c COUNT or &\n", watch->name);
+            return S_EXIT_INVALID_COMMAND;
+        }
+        if (isatty(STDOUT)) {
+            stop_watch(watch);
+            watch->has_previous = 0;
+            int ret = watch->print(watch);
+            watch->remaining = (count > 0) ? count - 1 : -1;
+            if (ret != S_EXIT_SUCCESS || watch->remaining == 0) {
+                return ret;
+            }
+            watch->timer = event_loop_add_timer(interval_ms, 1, watch_tick, watch);
+            return (watch->timer < 0) ? S_EXIT_FAILURE : S_EXIT_SUCCESS;
+        }
+    }
+
+    StatsWatch foreground = *watch;
+    struct timespec delay = { interval_ms / 1000, (interval_ms % 1000) * 1000000L };
+    foreground.has_previous = 0;
+    for (long tick = 0; count < 0 || tick < count; tick++) {
+        if (tick > 0) {
+            nanosleep(&delay, NULL);
+            console_write(STDOUT, "\n", 1, NULL);
+        }
+        int ret = foreground.print(&foreground);
+        console_flush_all();
+        if (ret != S_EXIT_SUCCESS) {
+            return ret;
+        }
+    }
+    return S_EXIT_SUCCESS;
+}
+
+int Free_Command(char **Command_tokens)
+{
+    return run_stats_command(&free_watch, Command_tokens);
+}
+
+int Uptime_Command(char **Command_tokens)
+{
+    return run_stats_command(&uptime_watch, Command_tokens);
+}
+
+/* One line of sps */
+typedef struct {
+    const ProcessStats *process;
+    double cpu;                     /* % of one CPU over the sampling delay */
+    double memory;                  /* % of MemTotal */
+} ProcessRow;
+
+typedef enum {
+    SORT_BY_CPU,
+    SORT_BY_MEMORY,
+    SORT_BY_NAME,
+    SORT_BY_PID
+} ProcessSortKey;
+
+static ProcessSortKey process_sort_key;
+
+static int compare_process_rows(const void *a, const void *b)
+{
+    const ProcessRow *first = a;
+    const ProcessRow *second = b;
+    int order = 0;
+
+    switch (process_sort_key) {
+    case SORT_BY_CPU:
+        order = (second->cpu > first->cpu) - (second->cpu < first->cpu);
+        break;
+    case SORT_BY_MEMORY:
+        order = (second->memory > first->memory) - (second->memory < first->memory);
+        break;
+    case SORT_BY_NAME:
+        order = strcmp(first->process->name, second->process->name);
+        break;
+    case SORT_BY_PID:
+        break;
+    }
+
+    /* Equal rows stay in pid order */
+    if (order == 0) {
+        order = (first->process->pid > second->process->pid) - (first->process->pid < second->process->pid);
     }
+    return order;
+}
 
-    printf("System Uptime: %.2f seconds\n", uptime);
-    printf("Idle Time: %.2f seconds\n", idle_time);
-}
\ No newline at end of file
+int Process_Status_Command(char **Command_tokens)
+{
+    static const struct {
+        const char *name;
+        ProcessSortKey key;
+    } sort_keys[] = {
+        { "cpu",  SORT_BY_CPU },
+        { "mem",  SORT_BY_MEMORY },
+        { "name", SORT_BY_NAME },
+        { "pid",  SORT_BY_PID },
+    };
+    ProcessSnapshot before = { NULL, 0, 0, { 0, 0 } };
+    ProcessSnapshot after = { NULL, 0, 0, { 0, 0 } };
+    const char *filter = NULL;
+    long limit = -1;
+    long delay_ms = SPS_DEFAULT_DELAY_MS;
+    int ret = S_EXIT_SUCCESS;
+
+    process_sort_key = SORT_BY_CPU;
+    for (int i = 1; Command_tokens[i] != NULL; i++) {
+        char *end = NULL;
+        const char *value = Command_tokens[i + 1];
+        int valid = 0;
+
+        if (value != NULL && strcmp(Command_tokens[i], "-s") == 0) {
+            for (size_t k = 0; k < sizeof(sort_keys) / sizeof(sort_keys[0]); k++) {
+                if (strcmp(value, sort_keys[k].name) == 0) {
+                    process_sort_key = sort_keys[k].key;
+                    valid = 1;
+                }
+            }
+        } else if (value != NULL && strcmp(Command_tokens[i], "-f") == 0) {
+            filter = value;
+            valid = 1;
+        } else if (value != NULL && strcmp(Command_tokens[i], "-n") == 0) {
+            limit = strtol(value, &end, 10);
+            valid = (*end == '\0' && limit > 0);
+        } else if (value != NULL && strcmp(Command_tokens[i], "-d") == 0) {
+            delay_ms = strtol(value, &end, 10);
+            valid = (*end == '\0' && delay_ms >= 0 && delay_ms <= 60000);
+        }
+
+        if (!valid) {
+            Write_syscall(STDERR, "Error: usage: sps [-s cpu|mem|name|pid] [-f NAME] [-n COUNT] [-d MS]\n", red);
+            return S_EXIT_INVALID_COMMAND;
+        }
+        i++;
+    }
+
+    /* CPU% needs two snapshots, the first one is taken delay_ms before the printed one */
+    MemoryStats memory;
+    struct timespec delay = { delay_ms / 1000, (delay_ms % 1000) * 1000000L };
+    ret = proc_read_memory(&memory);
+    if (ret == S_EXIT_SUCCESS) {
+        ret = proc_read_processes(&before);
+    }
+    if (ret == S_EXIT_SUCCESS) {
+        nanosleep(&delay, NULL);
+        ret = proc_read_processes(&after);
+    }
+    if (ret != S_EXIT_SUCCESS) {
+        if (ret == S_EXIT_MEM_ALLOC) {
+            perror("Failed to allocate memory");
+        }
+        proc_free_processes(&before);
+        proc_free_processes(&after);
+        return ret;
+    }
+
+    ProcessRow *rows = malloc((after.count ? after.count : 1) * sizeof(ProcessRow));
+    if (rows == NULL) {
+        perror("Failed to allocate memory");
+        proc_free_processes(&before);
+        proc_free_processes(&after);
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    double elapsed = (after.time.tv_sec - before.time.tv_sec) + (after.time.tv_nsec - before.time.tv_nsec) / 1e9;
+    double ticks = elapsed * sysconf(_SC_CLK_TCK);
+    double page_kb = sysconf(_SC_PAGESIZE) / 1024.0;
+    size_t num_rows = 0;
+
+    for (size_t i = 0; i < after.count; i++) {
+        const ProcessStats *process = &after.processes[i];
+        if (filter != NULL && strstr(process->name, filter) == NULL) {
+            continue;
+        }
+
+        /* A process started between the snapshots is measured from zero */
+        const ProcessStats *previous = proc_find_process(&before, process->pid);
+        unsigned long long used = process->cpu_ticks - (previous && previous->cpu_ticks <= process->cpu_ticks ? previous->cpu_ticks : 0);
+
+        ProcessRow *row = &rows[num_rows++];
+        row->process = process;
+        row->cpu = (ticks > 0 && previous != NULL) ? 100.0 * used / ticks : 0;
+        row->memory = memory.total ? 100.0 * process->rss_pages * page_kb / memory.total : 0;
+    }
+
+    qsort(rows, num_rows, sizeof(ProcessRow), compare_process_rows);
+    if (limit > 0 && (size_t)limit < num_rows) {
+        num_rows = limit;
+    }
+
+    char tty[16];
+    char rss[16];
+    console_printf(STDOUT, blue, "%7s %-8s %4s %6s %6s %8s  %s\n", "PID", "TTY", "STAT", "CPU%", "MEM%", "RSS", "COMMAND");
+    for (size_t i = 0; i < num_rows; i++) {
+        const ProcessStats *process = rows[i].process;
+        console_printf(STDOUT, NULL, "%7d %-8s %4c %6.1f %6.1f %8s  %s\n", (int)process->pid,
+                       proc_format_tty(tty, sizeof(tty), process->tty), process->state, rows[i].cpu, rows[i].memory,
+                       proc_format_size(rss, sizeof(rss), process->rss_pages * page_kb, 0), process->name);
+    }
+
+    free(rows);
+    proc_free_processes(&before);
+    proc_free_processes(&after);
+    return S_EXIT_SUCCESS;
+}
@@ -12,12 +12,12 @@
 #ifndef CMDS_H
 #define CMDS_H
 
-#define MAX_COMMAND_LENGTH 35  // Adjust this length as needed
+#include <sys/types.h>
 
-/**
- * @brief Prints the shell prompt with the username and hostname.
- */
-void print_prompt();
+#include "../parser/parser.h"
+
+/* Time between the two scans of /proc that sps uses to measure the CPU usage */
+#define SPS_DEFAULT_DELAY_MS        250
 
 /**
  * @brief Displays help information for the supported commands.
@@ -71,39 +71,134 @@ void Print_Environmen_Variables(char **Command_tokens);
 void Type_of_Command(char** Command_tokens);
 
 /**
- * @brief Adds a command to the history file with its exit status.
+ * @brief Prints the last commands of the history (sphist [N]).
+ * 
+ * @param Command_tokens Array of strings containing the command and its arguments,
+ *        an optional number of commands (HISTORY_SIZE by default).
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_INVALID_COMMAND if N is not a positive number.
+ */
+int History_Command(char **Command_tokens);
+
+/**
+ * @brief Launches an external program directly with posix_spawn.
+ * 
+ * The program is looked up in PATH by the shell and started without an intermediate
+ * `sh -c`. The files of the redirections are opened by the shell (close-on-exec), so an
+ * error is reported as `<file>: <error>` before anything is started, then pipe ends and
+ * redirections are installed with spawn file actions.
+ * 
+ * @param Command_tokens NULL terminated array containing the command and its arguments.
+ * @param redirections Redirections of the command (may be NULL).
+ * @param in_fd File descriptor to use as stdin, or -1 to inherit it.
+ * @param out_fd File descriptor to use as stdout, or -1 to inherit it.
+ * @param close_fds File descriptors to close in the new process (e.g. unused pipe ends).
+ * @param num_close_fds Number of entries in close_fds.
+ * @param pgid Process group to join, 0 to start a new one, or -1 to stay in the shell's group.
+ * @param failure_status Set when no process is started: S_EXIT_COMMAND_NOT_FOUND if the program
+ *        could not be run, S_EXIT_FAILURE if a redirection failed, or S_EXIT_MEM_ALLOC.
+ * @return pid_t The pid of the new process, or -1 if it could not be started.
+ */
+pid_t Spawn_External_Command(char **Command_tokens, const Redirection *redirections,
+                             int in_fd, int out_fd, const int *close_fds, int num_close_fds, pid_t pgid,
+                             int *failure_status);
+
+/**
+ * @brief Shows or resets the command path cache (like bash's hash builtin).
+ * 
+ * Without arguments the cached commands are printed with their number of hits,
+ * -r forgets all of them, and command names are looked up and remembered.
+ * 
+ * @param Command_tokens Array of strings containing the command and its arguments.
+ * @return int Status code indicating success or failure.
+ */
+int Hash_Command(char **Command_tokens);
+
+/**
+ * @brief Prints the real time, CPU times and peak memory of the last commands.
+ * 
+ * Without arguments the last command is shown, N shows the last N commands and
+ * -s on|off enables or disables a summary line printed before each prompt.
+ * 
+ * @param Command_tokens Array of strings containing the command and its arguments.
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_INVALID_COMMAND for invalid arguments.
+ */
+int Time_Command(char **Command_tokens);
+
+/**
+ * @brief Prints or changes the shell options.
+ * 
+ * Without arguments every option is printed with its state, sset -o OPTION enables an
+ * option and sset +o OPTION disables it. The options are errexit and pipefail.
+ * 
+ * @param Command_tokens Array of strings containing the command and its arguments.
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_INVALID_COMMAND for invalid arguments.
+ */
+int Set_Command(char **Command_tokens);
+
+/**
+ * @brief Prints the background and stopped jobs (sjobs [-l]).
  * 
- * @param command The command string.
- * @param exit_status The exit status of the command.
+ * @param Command_tokens Array of strings containing the command and its arguments.
+ * @return int Returns S_EXIT_SUCCESS.
  */
-void add_to_history(const char* command, int exit_status);
+int Jobs_Command(char **Command_tokens);
 
 /**
- * @brief Prints the command history.
+ * @brief Continues a job in the foreground and waits for it (sfg [%N]).
+ * 
+ * @param Command_tokens Array of strings containing the command and its arguments.
+ * @return int Exit status of the job, or S_EXIT_INVALID_COMMAND if there is no such job.
  */
-void print_history();
+int Foreground_Command(char **Command_tokens);
 
 /**
- * @brief Executes an external command.
+ * @brief Continues stopped jobs in the background (sbg [%N...]).
+ * 
+ * @param Command_tokens Array of strings containing the command and its arguments.
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_INVALID_COMMAND if a job does not exist.
+ */
+int Background_Command(char **Command_tokens);
+
+/**
+ * @brief Waits for the given jobs, or for all the jobs (swait [%N...]).
+ * 
+ * @param Command_tokens Array of strings containing the command and its arguments.
+ * @return int Exit status of the last job waited for.
+ */
+int Wait_Command(char **Command_tokens);
+
+/**
+ * @brief Prints information about RAM usage (sfree [-s N] [-c COUNT]).
+ *
+ * With -s the table is printed again every N seconds with the changes since the previous
+ * refresh and their rate per second. At the prompt the refresh runs in the background.
  * 
  * @param Command_tokens Array of strings containing the command and its arguments.
  * @return int Status code indicating success or failure.
  */
-int Execute_External_Command(char **Command_tokens);
+int Free_Command(char **Command_tokens);
 
 /**
- * @brief Prints information about RAM usage.
+ * @brief Prints the system's uptime, idle time and CPU usage (suptime [-s N] [-c COUNT]).
+ *
+ * With -s the CPU usage is computed over the last N seconds instead of since boot.
  * 
+ * @param Command_tokens Array of strings containing the command and its arguments.
  * @return int Status code indicating success or failure.
  */
-int Free_Command(void);
+int Uptime_Command(char **Command_tokens);
 
 /**
- * @brief Prints the system's uptime and idle time.
+ * @brief Prints the running processes (sps [-s cpu|mem|name|pid] [-f NAME] [-n COUNT] [-d MS]).
+ *
+ * The CPU usage is measured between two scans of /proc taken MS milliseconds apart
+ * (SPS_DEFAULT_DELAY_MS by default). The table is sorted by CPU usage unless -s is given,
+ * -f keeps the processes whose name contains NAME and -n prints the first COUNT ones.
  * 
+ * @param Command_tokens Array of strings containing the command and its arguments.
  * @return int Status code indicating success or failure.
  */
-int Uptime_Command(void);
+int Process_Status_Command(char **Command_tokens);
 
 
 
@@ -0,0 +1,178 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        console.c              *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "console.h"
+#include "../helper_functions/helpers.h"
+
+/*****************************            Types                  ********************************/
+
+typedef struct {
+    char data[CONSOLE_BUFFER_SIZE];
+    size_t len;
+    int is_tty;                     /* -1 until checked with isatty() */
+} ConsoleStream;
+
+/*****************************        Global Variables           ********************************/
+
+static ConsoleStream streams[2] = { { .is_tty = -1 }, { .is_tty = -1 } };   /* STDOUT, STDERR */
+static int exit_flush_registered = 0;
+
+/*****************************        Static Functions           ********************************/
+
+static ConsoleStream *get_stream(int stream)
+{
+    if (stream == STDOUT) {
+        return &streams[0];
+    }
+    if (stream == STDERR) {
+        return &streams[1];
+    }
+    return NULL;
+}
+
+/* Writes all the vectors, resuming after partial writes and signals */
+static void write_vectors(int fd, struct iovec *iov, int count)
+{
+    while (count > 0) {
+        ssize_t written = writev(fd, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;                     /* Nowhere left to report the error */
+        }
+
+        while (count > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+}
+
+/*****************************        Public Functions           ********************************/
+
+void console_write(int stream, const char *msg, size_t len, const char *color_code)
+{
+    ConsoleStream *console = get_stream(stream);
+
+    if (!exit_flush_registered) {
+        atexit(console_flush_all);      /* Also flushes the forked builtins when they exit */
+        exit_flush_registered = 1;
+    }
+
+    int is_tty = console ? console->is_tty : -1;
+    if (is_tty < 0) {
+        is_tty = isatty(stream);
+        if (console) {
+            console->is_tty = is_tty;
+        }
+    }
+    if (!is_tty) {
+        color_code = NULL;              /* No escape sequences in files and pipes */
+    }
+
+    const char *reset_code = color_code ? white : NULL;
+    struct iovec iov[3] = {
+        { (void *)color_code, color_code ? strlen(color_code) : 0 },
+        { (void *)msg, len },
+        { (void *)reset_code, reset_code ? strlen(reset_code) : 0 },
+    };
+    size_t total = iov[0].iov_len + iov[1].iov_len + iov[2].iov_len;
+
+    if (console == NULL) {
+        write_vectors(stream, iov, 3);
+        return;
+    }
+
+    /* Keep the order of errors and normal output when both go to the same place */
+    if (stream == STDERR) {
+        console_flush(STDOUT);
+    }
+
+    if (console->len + total > CONSOLE_BUFFER_SIZE) {
+        console_flush(stream);
+    }
+    if (total > CONSOLE_BUFFER_SIZE) {
+        write_vectors(stream, iov, 3);  /* Too big to be buffered, still a single syscall */
+        return;
+    }
+
+    for (int i = 0; i < 3; i++) {
+        memcpy(console->data + console->len, iov[i].iov_base, iov[i].iov_len);
+        console->len += iov[i].iov_len;
+    }
+
+    if (is_tty && memchr(msg, '\n', len) != NULL) {
+        console_flush(stream);          /* Line buffered on a terminal */
+    }
+}
+
+int console_printf(int stream, const char *color_code, const char *format, ...)
+{
+    char message[CONSOLE_BUFFER_SIZE];
+    va_list args, args_copy;
+
+    va_start(args, format);
+    va_copy(args_copy, args);
+    int len = vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+
+    if (len >= 0 && (size_t)len < sizeof(message)) {
+        console_write(stream, message, len, color_code);
+    } else if (len >= 0) {
+        char *long_message = malloc(len + 1);
+        if (long_message != NULL) {
+            vsnprintf(long_message, len + 1, format, args_copy);
+            console_write(stream, long_message, len, color_code);
+            free(long_message);
+        }
+    }
+
+    va_end(args_copy);
+    return len;
+}
+
+void console_flush(int stream)
+{
+    ConsoleStream *console = get_stream(stream);
+    if (console == NULL || console->len == 0) {
+        return;
+    }
+
+    struct iovec iov = { console->data, console->len };
+    write_vectors(stream, &iov, 1);
+    console->len = 0;
+}
+
+void console_flush_all(void)
+{
+    console_flush(STDOUT);
+    console_flush(STDERR);
+
+    /* The descriptors may be redirected before the next write */
+    streams[0].is_tty = -1;
+    streams[1].is_tty = -1;
+}
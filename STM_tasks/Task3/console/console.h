@@ -0,0 +1,58 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        console.h              *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stddef.h>
+
+/* Size of the buffer of each output stream (STDOUT and STDERR) */
+#define CONSOLE_BUFFER_SIZE     4096
+
+/**
+ * @brief Appends a colored message to the buffer of a stream.
+ *
+ * The color code, the message and the color reset are copied into the same buffer, so
+ * they reach the terminal with one write(). A stream that is a terminal is flushed at
+ * every newline; other streams are flushed when the buffer is full or by console_flush().
+ * Color codes are dropped when the stream is not a terminal (file or pipe).
+ *
+ * @param stream STDOUT or STDERR, any other descriptor is written directly.
+ * @param msg The message.
+ * @param len Number of characters of msg.
+ * @param color_code The color of the message, or NULL for plain text.
+ */
+void console_write(int stream, const char *msg, size_t len, const char *color_code);
+
+/**
+ * @brief printf-like version of console_write().
+ *
+ * @return int Number of characters of the formatted message, or -1 on a formatting error.
+ */
+int console_printf(int stream, const char *color_code, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * @brief Writes the pending content of one stream.
+ */
+void console_flush(int stream);
+
+/**
+ * @brief Writes the pending content of STDOUT and STDERR.
+ *
+ * Must be called at the end of every command and before fork() or posix_spawn(), so that
+ * a child never inherits (and prints again) the parent's pending output. Whether the
+ * streams are terminals is checked again after this call, since a redirection may have
+ * replaced the descriptors.
+ */
+void console_flush_all(void);
+
+#endif
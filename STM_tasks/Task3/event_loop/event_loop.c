@@ -0,0 +1,307 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        event_loop.c           *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <readline/readline.h>
+
+#include "event_loop.h"
+#include "../console/console.h"
+#include "../exit_status.h"
+
+/*****************************            Types                  ********************************/
+
+typedef enum {
+    WATCH_FD,
+    WATCH_TIMER,
+    WATCH_SIGNALS
+} WatchType;
+
+/* A descriptor registered in the epoll set, epoll events point to it */
+typedef struct Watch {
+    WatchType type;
+    int fd;
+    int repeat;                     /* WATCH_TIMER: periodic */
+    int removed;                    /* Freed after the current batch of events */
+    EventCallback callback;
+    void *context;
+    struct Watch *next;
+} Watch;
+
+typedef struct {
+    EventCallback callback;
+    void *context;
+} SignalHandler;
+
+/*****************************        Global Variables           ********************************/
+
+static int epoll_fd = -1;
+static int signal_fd = -1;
+static sigset_t watched_signals;
+static SignalHandler signal_handlers[NSIG];
+static Watch *watches = NULL;
+static int stop_requested = 0;
+static pid_t loop_pid = 0;                  /* Process running event_loop_run(), 0 if none */
+
+/*****************************        Static Functions           ********************************/
+
+static Watch *add_watch(WatchType type, int fd, EventCallback callback, void *context)
+{
+    Watch *watch = malloc(sizeof(Watch));
+    if (watch == NULL) {
+        return NULL;
+    }
+
+    watch->type = type;
+    watch->fd = fd;
+    watch->repeat = 0;
+    watch->removed = 0;
+    watch->callback = callback;
+    watch->context = context;
+
+    struct epoll_event event = { .events = EPOLLIN, .data.ptr = watch };
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        free(watch);
+        return NULL;
+    }
+
+    watch->next = watches;
+    watches = watch;
+    return watch;
+}
+
+static Watch *find_watch(int fd)
+{
+    for (Watch *watch = watches; watch != NULL; watch = watch->next) {
+        if (watch->fd == fd && !watch->removed) {
+            return watch;
+        }
+    }
+    return NULL;
+}
+
+/* Takes a watch out of the epoll set, the memory is released by free_removed_watches() */
+static void remove_watch(Watch *watch)
+{
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, watch->fd, NULL);
+    if (watch->type == WATCH_TIMER) {
+        close(watch->fd);
+    }
+    watch->removed = 1;
+}
+
+/* Events of the same batch may still point to removed watches, so they are freed afterwards */
+static void free_removed_watches(void)
+{
+    Watch **link = &watches;
+    while (*link != NULL) {
+        Watch *watch = *link;
+        if (watch->removed) {
+            *link = watch->next;
+            free(watch);
+        } else {
+            link = &watch->next;
+        }
+    }
+}
+
+static void dispatch_signals(void)
+{
+    struct signalfd_siginfo info[8];
+    ssize_t count;
+
+    while ((count = read(signal_fd, info, sizeof(info))) > 0) {
+        for (size_t i = 0; i < count / sizeof(info[0]); i++) {
+            SignalHandler *handler = &signal_handlers[info[i].ssi_signo];
+            if (handler->callback != NULL) {
+                handler->callback(handler->context);
+            }
+        }
+    }
+}
+
+static void dispatch(Watch *watch)
+{
+    uint64_t expirations;
+
+    switch (watch->type) {
+    case WATCH_SIGNALS:
+        dispatch_signals();
+        return;
+    case WATCH_TIMER:
+        if (read(watch->fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+            return;                     /* Spurious wake-up */
+        }
+        if (!watch->repeat) {
+            remove_watch(watch);
+        }
+        break;
+    case WATCH_FD:
+        break;
+    }
+
+    watch->callback(watch->context);
+}
+
+/*****************************        Public Functions           ********************************/
+
+int event_loop_init(void)
+{
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        perror("epoll_create1");
+        return S_EXIT_FAILURE;
+    }
+
+    sigemptyset(&watched_signals);
+    signal_fd = signalfd(-1, &watched_signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd < 0 || add_watch(WATCH_SIGNALS, signal_fd, NULL, NULL) == NULL) {
+        perror("signalfd");
+        return S_EXIT_FAILURE;
+    }
+
+    return S_EXIT_SUCCESS;
+}
+
+int event_loop_add_fd(int fd, EventCallback callback, void *context)
+{
+    if (add_watch(WATCH_FD, fd, callback, context) == NULL) {
+        perror("epoll_ctl");
+        return S_EXIT_FAILURE;
+    }
+    return S_EXIT_SUCCESS;
+}
+
+void event_loop_remove_fd(int fd)
+{
+    Watch *watch = find_watch(fd);
+    if (watch != NULL && watch->type == WATCH_FD) {
+        remove_watch(watch);
+    }
+}
+
+int event_loop_add_timer(long interval_ms, int repeat, EventCallback callback, void *context)
+{
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        perror("timerfd_create");
+        return -1;
+    }
+
+    struct timespec interval = { interval_ms / 1000, (interval_ms % 1000) * 1000000L };
+    struct itimerspec spec = { .it_interval = { 0, 0 }, .it_value = interval };
+    if (repeat) {
+        spec.it_interval = interval;
+    }
+
+    Watch *watch = NULL;
+    if (timerfd_settime(fd, 0, &spec, NULL) < 0 ||
+        (watch = add_watch(WATCH_TIMER, fd, callback, context)) == NULL) {
+        perror("timerfd");
+        close(fd);
+        return -1;
+    }
+
+    watch->repeat = repeat;
+    return fd;
+}
+
+void event_loop_remove_timer(int timer)
+{
+    Watch *watch = find_watch(timer);
+    if (watch != NULL && watch->type == WATCH_TIMER) {
+        remove_watch(watch);
+    }
+}
+
+int event_loop_watch_signal(int sig, EventCallback callback, void *context)
+{
+    if (sig <= 0 || sig >= NSIG) {
+        return S_EXIT_FAILURE;
+    }
+
+    signal_handlers[sig].callback = callback;
+    signal_handlers[sig].context = context;
+
+    /* A blocked signal stays pending until the signalfd is read */
+    sigaddset(&watched_signals, sig);
+    if (sigprocmask(SIG_BLOCK, &watched_signals, NULL) < 0 ||
+        signalfd(signal_fd, &watched_signals, SFD_NONBLOCK | SFD_CLOEXEC) < 0) {
+        perror("signalfd");
+        return S_EXIT_FAILURE;
+    }
+    return S_EXIT_SUCCESS;
+}
+
+void event_loop_run(void)
+{
+    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+
+    stop_requested = 0;
+    loop_pid = getpid();
+    while (!stop_requested) {
+        int count = epoll_wait(epoll_fd, events, EVENT_LOOP_MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < count && !stop_requested; i++) {
+            Watch *watch = events[i].data.ptr;
+            if (!watch->removed) {
+                dispatch(watch);
+            }
+        }
+        free_removed_watches();
+    }
+    loop_pid = 0;
+}
+
+int event_loop_running(void)
+{
+    /* A child forked by a callback inherits the variables but not the loop */
+    return loop_pid != 0 && loop_pid == getpid();
+}
+
+void event_loop_stop(void)
+{
+    stop_requested = 1;
+}
+
+void event_loop_output_begin(void)
+{
+    if (RL_ISSTATE(RL_STATE_CALLBACK)) {
+        rl_clear_visible_line();
+    }
+}
+
+void event_loop_output_end(void)
+{
+    console_flush_all();
+    if (RL_ISSTATE(RL_STATE_CALLBACK)) {
+        rl_on_new_line();
+        rl_forced_update_display();
+    }
+}
@@ -0,0 +1,95 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        event_loop.h           *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+/* Maximum number of events handled per epoll_wait() call */
+#define EVENT_LOOP_MAX_EVENTS       16
+
+/* Called when a watched descriptor is readable, a timer expired or a signal arrived */
+typedef void (*EventCallback)(void *context);
+
+/**
+ * @brief Creates the epoll instance and the signalfd of the loop.
+ *
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_FAILURE if epoll or signalfd are not available.
+ */
+int event_loop_init(void);
+
+/**
+ * @brief Calls callback every time fd becomes readable.
+ *
+ * @return int Returns S_EXIT_SUCCESS, S_EXIT_MEM_ALLOC or S_EXIT_FAILURE.
+ */
+int event_loop_add_fd(int fd, EventCallback callback, void *context);
+
+/**
+ * @brief Stops watching a descriptor (it is not closed).
+ */
+void event_loop_remove_fd(int fd);
+
+/**
+ * @brief Starts a timer backed by a timerfd.
+ *
+ * @param interval_ms Delay before the first call, and between calls if repeat is set.
+ * @param repeat 1 for a periodic timer, 0 for a single call (the timer is then removed).
+ * @return int The timer id to pass to event_loop_remove_timer(), or -1 on failure.
+ */
+int event_loop_add_timer(long interval_ms, int repeat, EventCallback callback, void *context);
+
+/**
+ * @brief Stops and frees a timer.
+ */
+void event_loop_remove_timer(int timer);
+
+/**
+ * @brief Delivers a signal through the loop's signalfd instead of an asynchronous handler.
+ *
+ * The signal is blocked in the shell, the processes it starts must unblock it again
+ * (see Spawn_External_Command() and job_child_setup()).
+ *
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_FAILURE.
+ */
+int event_loop_watch_signal(int sig, EventCallback callback, void *context);
+
+/**
+ * @brief Waits for events and runs their callbacks until event_loop_stop() is called.
+ */
+void event_loop_run(void);
+
+/**
+ * @brief Tells if the calling process is inside event_loop_run().
+ *
+ * @return int 1 in the shell while the loop runs (timers can be used), 0 in scripts and children.
+ */
+int event_loop_running(void);
+
+/**
+ * @brief Makes event_loop_run() return after the current callback.
+ */
+void event_loop_stop(void);
+
+/**
+ * @brief Prepares the terminal for output printed while a line is being edited.
+ *
+ * The prompt and the edited line are cleared, and put back by event_loop_output_end()
+ * after the output, so a message from a background job does not mix with the input.
+ * Nothing is done when no line is being read.
+ */
+void event_loop_output_begin(void);
+
+/**
+ * @brief Flushes the console and redraws the prompt with the line being edited.
+ */
+void event_loop_output_end(void);
+
+#endif
@@ -15,7 +15,8 @@ typedef enum {
     S_EXIT_NO_ARGS                  ,     // No arguments passed
     S_EXIT_DUP_FILE_FAILED          ,     // Failed to duplicate file in redirecting streams    
     S_EXIT_INVALID_VARIABLE_NAME    ,
-    S_EXIT_MEM_ALLOC                     // Failed to allocate memory using malloc   
+    S_EXIT_MEM_ALLOC                ,     // Failed to allocate memory using malloc   
+    S_EXIT_COMMAND_NOT_FOUND              // External command not found in PATH
 } ExitStatus;
 
 #endif // EXIT_STATUS_H
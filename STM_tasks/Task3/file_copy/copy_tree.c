@@ -0,0 +1,258 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        copy_tree.c            *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <limits.h>
+#include <libgen.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "file_copy.h"
+#include "../thread_pool/thread_pool.h"
+#include "../exit_status.h"
+
+/* Maximum number of directories nftw keeps open */
+#define COPY_TREE_OPEN_FDS  64
+
+/*****************************            Types                  ********************************/
+
+/* A regular file handed to a worker */
+typedef struct {
+    char *source;
+    char *target;
+    struct stat source_stat;
+} FileJob;
+
+/* Metadata of a created directory, applied once everything inside it is written */
+typedef struct {
+    char *path;
+    struct stat source_stat;
+} DirectoryEntry;
+
+/*****************************        Global Variables           ********************************/
+
+/* nftw() has no user pointer, so the state of the running copy lives here (one copy at a time) */
+static ThreadPool copy_pool;
+static const char *tree_source;
+static const char *tree_target;
+static size_t tree_source_len;
+static DirectoryEntry *directories;
+static size_t num_directories;
+static size_t directories_capacity;
+static int copy_errors;             /* Updated atomically by the workers */
+
+/*****************************        Static Functions           ********************************/
+
+static void report_error(const char *action, const char *path)
+{
+    /* One dprintf() per message, so lines from different workers do not interleave */
+    dprintf(STDERR_FILENO, "scp: %s '%s': %s\n", action, path, strerror(errno));
+    __atomic_add_fetch(&copy_errors, 1, __ATOMIC_RELAXED);
+}
+
+static void set_times(int fd, const char *path, const struct stat *source_stat, int flags)
+{
+    struct timespec times[2] = { source_stat->st_atim, source_stat->st_mtim };
+    int ret = (fd >= 0) ? futimens(fd, times) : utimensat(AT_FDCWD, path, times, flags);
+    if (ret < 0) {
+        report_error("cannot preserve times of", path);
+    }
+}
+
+static void copy_file_task(void *arg)
+{
+    FileJob *job = arg;
+
+    int source_fd = open(job->source, O_RDONLY);
+    if (source_fd < 0) {
+        report_error("cannot open", job->source);
+        goto out;
+    }
+
+    int target_fd = open(job->target, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (target_fd < 0) {
+        report_error("cannot create", job->target);
+        close(source_fd);
+        goto out;
+    }
+
+    if (Copy_File_Data(source_fd, target_fd, COPY_METHOD_AUTO, NULL) != S_EXIT_SUCCESS) {
+        report_error("cannot copy", job->source);
+    } else {
+        if (fchmod(target_fd, job->source_stat.st_mode & 07777) < 0) {
+            report_error("cannot preserve mode of", job->target);
+        }
+        set_times(target_fd, job->target, &job->source_stat, 0);
+    }
+
+    close(source_fd);
+    close(target_fd);
+
+out:
+    free(job->source);
+    free(job->target);
+    free(job);
+}
+
+static char *target_path_of(const char *source_path)
+{
+    char *path;
+    if (asprintf(&path, "%s%s", tree_target, source_path + tree_source_len) < 0) {
+        return NULL;
+    }
+    return path;
+}
+
+static int visit(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf)
+{
+    (void)ftwbuf;
+
+    char *target = target_path_of(fpath);
+    if (target == NULL) {
+        return -1;                  /* Out of memory, stop walking */
+    }
+
+    switch (typeflag) {
+        case FTW_D: {
+            /* Created writable now, the real mode is applied when the copy is complete */
+            if (mkdir(target, 0700) < 0 && errno != EEXIST) {
+                report_error("cannot create directory", target);
+                free(target);
+                return FTW_SKIP_SUBTREE;
+            }
+
+            if (num_directories == directories_capacity) {
+                size_t new_capacity = directories_capacity ? directories_capacity * 2 : 64;
+                DirectoryEntry *grown = realloc(directories, new_capacity * sizeof(DirectoryEntry));
+                if (grown == NULL) {
+                    free(target);
+                    return -1;
+                }
+                directories = grown;
+                directories_capacity = new_capacity;
+            }
+            directories[num_directories++] = (DirectoryEntry){ target, *sb };
+            return FTW_CONTINUE;
+        }
+
+        case FTW_F: {
+            FileJob *job = malloc(sizeof(FileJob));
+            char *source = strdup(fpath);
+            if (job == NULL || source == NULL) {
+                free(job);
+                free(source);
+                free(target);
+                return -1;
+            }
+            *job = (FileJob){ source, target, *sb };
+            thread_pool_submit(&copy_pool, copy_file_task, job);
+            return FTW_CONTINUE;
+        }
+
+        case FTW_SL: {
+            char link_target[PATH_MAX];
+            ssize_t len = readlink(fpath, link_target, sizeof(link_target) - 1);
+            if (len < 0) {
+                report_error("cannot read link", fpath);
+            } else {
+                link_target[len] = '\0';
+                if (symlink(link_target, target) < 0) {
+                    report_error("cannot create link", target);
+                } else {
+                    set_times(-1, target, sb, AT_SYMLINK_NOFOLLOW);
+                }
+            }
+            break;
+        }
+
+        case FTW_DNR:
+        case FTW_NS:
+            errno = EACCES;
+            report_error("cannot read", fpath);
+            break;
+
+        default:
+            /* Devices, fifos and sockets are not copied */
+            dprintf(STDERR_FILENO, "scp: skipping special file '%s'\n", fpath);
+            break;
+    }
+
+    free(target);
+    return FTW_CONTINUE;
+}
+
+/*****************************        Public Functions           ********************************/
+
+int Copy_Tree(const char *source, const char *target, int jobs)
+{
+    char real_source[PATH_MAX];
+    char real_target_parent[PATH_MAX];
+
+    /* Refuse to copy a directory into itself, the walk would never end */
+    char *target_copy = strdup(target);
+    if (target_copy == NULL) {
+        return S_EXIT_MEM_ALLOC;
+    }
+    if (realpath(source, real_source) != NULL && realpath(dirname(target_copy), real_target_parent) != NULL) {
+        size_t len = strlen(real_source);
+        if (strncmp(real_target_parent, real_source, len) == 0 &&
+            (real_target_parent[len] == '\0' || real_target_parent[len] == '/')) {
+            dprintf(STDERR_FILENO, "scp: cannot copy '%s' into itself\n", source);
+            free(target_copy);
+            return S_EXIT_SAME_OPERANDS;
+        }
+    }
+    free(target_copy);
+
+    if (thread_pool_init(&copy_pool, jobs) != S_EXIT_SUCCESS) {
+        return S_EXIT_FAILURE;
+    }
+
+    tree_source = source;
+    tree_target = target;
+    tree_source_len = strlen(source);
+    directories = NULL;
+    num_directories = 0;
+    directories_capacity = 0;
+    copy_errors = 0;
+
+    int walk = nftw(source, visit, COPY_TREE_OPEN_FDS, FTW_PHYS | FTW_ACTIONRETVAL);
+
+    /* Every file must be written before the directories get their final mode and times */
+    thread_pool_wait(&copy_pool);
+    thread_pool_destroy(&copy_pool);
+
+    /* Deepest directories first: setting the times of a child touches its parent */
+    for (size_t i = num_directories; i-- > 0; ) {
+        if (chmod(directories[i].path, directories[i].source_stat.st_mode & 07777) < 0) {
+            report_error("cannot preserve mode of", directories[i].path);
+        }
+        set_times(-1, directories[i].path, &directories[i].source_stat, 0);
+        free(directories[i].path);
+    }
+    free(directories);
+    directories = NULL;
+
+    if (walk != 0) {
+        dprintf(STDERR_FILENO, "scp: failed to walk '%s'\n", source);
+        return S_EXIT_FAILURE;
+    }
+    return (copy_errors == 0) ? S_EXIT_SUCCESS : S_EXIT_FAILURE;
+}
@@ -0,0 +1,189 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        file_copy.c            *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h>
+
+#include "file_copy.h"
+#include "../exit_status.h"
+
+/* Largest chunk handed to the kernel at once (sendfile/copy_file_range limit) */
+#define KERNEL_COPY_CHUNK   0x7ffff000
+
+/* Result of one copy strategy */
+typedef enum {
+    COPY_DONE,                          /* Reached the end of the source */
+    COPY_UNSUPPORTED,                   /* Nothing wrong, but try the next method */
+    COPY_READ_ERROR,
+    COPY_WRITE_ERROR
+} CopyResult;
+
+/*****************************        Global Variables           ********************************/
+
+/* Read/write buffer of each thread, freed when the thread exits (the workers of each scp -r) */
+static pthread_key_t buffer_key;
+static pthread_once_t buffer_key_once = PTHREAD_ONCE_INIT;
+
+/*****************************        Static Functions           ********************************/
+
+static void create_buffer_key(void)
+{
+    pthread_key_create(&buffer_key, free);
+}
+
+/* errno values meaning "this method does not work for these two files" */
+static int is_unsupported(int error)
+{
+    return error == EXDEV || error == EINVAL || error == ENOSYS || error == EOPNOTSUPP
+        || error == EBADF || error == ETXTBSY || error == EPERM;
+}
+
+static CopyResult copy_clone(int source_fd, int target_fd, off_t *copied)
+{
+#ifdef FICLONE
+    struct stat source_stat;
+    struct stat target_stat;
+
+    /* A reflink replaces the whole target, so only use it for a fresh copy from offset 0 */
+    if (fstat(source_fd, &source_stat) < 0 || fstat(target_fd, &target_stat) < 0 ||
+        target_stat.st_size != 0 || (fcntl(target_fd, F_GETFL) & O_APPEND) ||
+        lseek(source_fd, 0, SEEK_CUR) != 0) {
+        return COPY_UNSUPPORTED;
+    }
+
+    if (ioctl(target_fd, FICLONE, source_fd) == 0) {
+        *copied += source_stat.st_size;
+        return COPY_DONE;
+    }
+#else
+    (void)source_fd;
+    (void)target_fd;
+    (void)copied;
+#endif
+    return COPY_UNSUPPORTED;
+}
+
+static CopyResult copy_kernel(int source_fd, int target_fd, off_t *copied, CopyMethod method)
+{
+    while (1) {
+        ssize_t n;
+
+        if (method == COPY_METHOD_COPY_FILE_RANGE) {
+            n = copy_file_range(source_fd, NULL, target_fd, NULL, KERNEL_COPY_CHUNK, 0);
+        } else {
+            n = sendfile(target_fd, source_fd, NULL, KERNEL_COPY_CHUNK);
+        }
+
+        if (n == 0) {
+            return COPY_DONE;
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            /* Both calls move the offsets, so a fallback continues where this one stopped */
+            if (is_unsupported(errno)) {
+                return COPY_UNSUPPORTED;
+            }
+            return (errno == EIO) ? COPY_READ_ERROR : COPY_WRITE_ERROR;
+        }
+        *copied += n;
+    }
+}
+
+static CopyResult copy_read_write(int source_fd, int target_fd, off_t *copied)
+{
+    /* Allocated once per thread and reused, small files should not pay for an mmap/munmap */
+    CopyResult result = COPY_DONE;
+    pthread_once(&buffer_key_once, create_buffer_key);
+    char *buffer = pthread_getspecific(buffer_key);
+
+    if (buffer == NULL) {
+        if (posix_memalign((void **)&buffer, COPY_BUFFER_ALIGNMENT, COPY_BUFFER_SIZE) != 0) {
+            return COPY_WRITE_ERROR;
+        }
+        if (pthread_setspecific(buffer_key, buffer) != 0) {
+            free(buffer);
+            return COPY_WRITE_ERROR;
+        }
+    }
+
+    while (1) {
+        ssize_t bytes_read = read(source_fd, buffer, COPY_BUFFER_SIZE);
+        if (bytes_read == 0) {
+            break;
+        }
+        if (bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            result = COPY_READ_ERROR;
+            break;
+        }
+
+        /* write() may be partial, e.g. on pipes or when interrupted */
+        for (ssize_t done = 0; done < bytes_read; ) {
+            ssize_t written = write(target_fd, buffer + done, bytes_read - done);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return COPY_WRITE_ERROR;
+            }
+            done += written;
+        }
+        *copied += bytes_read;
+    }
+
+    return result;
+}
+
+/*****************************        Public Functions           ********************************/
+
+int Copy_File_Data(int source_fd, int target_fd, CopyMethod method, off_t *copied)
+{
+    off_t total = 0;
+    CopyResult result = COPY_UNSUPPORTED;
+
+    if (method == COPY_METHOD_AUTO || method == COPY_METHOD_CLONE) {
+        result = copy_clone(source_fd, target_fd, &total);
+    }
+    if (result == COPY_UNSUPPORTED && (method == COPY_METHOD_AUTO || method == COPY_METHOD_COPY_FILE_RANGE)) {
+        result = copy_kernel(source_fd, target_fd, &total, COPY_METHOD_COPY_FILE_RANGE);
+    }
+    if (result == COPY_UNSUPPORTED && (method == COPY_METHOD_AUTO || method == COPY_METHOD_SENDFILE)) {
+        result = copy_kernel(source_fd, target_fd, &total, COPY_METHOD_SENDFILE);
+    }
+    if (result == COPY_UNSUPPORTED && (method == COPY_METHOD_AUTO || method == COPY_METHOD_READ_WRITE)) {
+        result = copy_read_write(source_fd, target_fd, &total);
+    }
+
+    if (copied != NULL) {
+        *copied = total;
+    }
+
+    switch (result) {
+        case COPY_DONE:         return S_EXIT_SUCCESS;
+        case COPY_READ_ERROR:   return S_EXIT_READ_FILE_FAIL;
+        case COPY_WRITE_ERROR:  return S_EXIT_OPEN_FILE_FAILED;
+        default:                return S_EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,63 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        file_copy.h            *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef FILE_COPY_H
+#define FILE_COPY_H
+
+#include <sys/types.h>
+
+/* Size (and alignment) of the buffer used when no in-kernel copy is possible */
+#define COPY_BUFFER_SIZE        (1024 * 1024)
+#define COPY_BUFFER_ALIGNMENT   4096
+
+/* Ways of moving the data, from the cheapest to the most expensive */
+typedef enum {
+    COPY_METHOD_AUTO,                   /* Try each of the methods below in order */
+    COPY_METHOD_CLONE,                  /* FICLONE reflink: shares the blocks, copies nothing */
+    COPY_METHOD_COPY_FILE_RANGE,        /* In-kernel copy, may be offloaded by the filesystem */
+    COPY_METHOD_SENDFILE,               /* In-kernel copy through the page cache */
+    COPY_METHOD_READ_WRITE              /* User space copy with a large aligned buffer */
+} CopyMethod;
+
+/**
+ * @brief Copies everything from the current offset of source_fd to target_fd.
+ *
+ * With COPY_METHOD_AUTO the data is reflinked when the filesystem supports it (only for an
+ * empty, non-append target), otherwise copied with copy_file_range, then sendfile, and
+ * finally read/write. A method that is not supported for these files falls back to the
+ * next one, continuing from where the previous one stopped.
+ *
+ * @param source_fd File descriptor open for reading.
+ * @param target_fd File descriptor open for writing.
+ * @param method The method to use (COPY_METHOD_AUTO in the shell).
+ * @param copied If not NULL, receives the number of bytes copied.
+ * @return int Returns S_EXIT_SUCCESS, S_EXIT_READ_FILE_FAIL or S_EXIT_OPEN_FILE_FAILED (write error),
+ *         or S_EXIT_FAILURE if a forced method is not supported.
+ */
+int Copy_File_Data(int source_fd, int target_fd, CopyMethod method, off_t *copied);
+
+/**
+ * @brief Copies a directory tree, the files being copied in parallel by a pool of workers.
+ *
+ * The tree is walked with nftw (symbolic links are copied as links, special files are
+ * skipped). Directories are created by the walker while regular files are queued to the
+ * workers; the modes and access/modification times of files, directories and links are
+ * preserved. Errors are reported on STDERR and do not stop the copy.
+ *
+ * @param source The directory to copy.
+ * @param target The path of the copy (created if it does not exist).
+ * @param jobs Number of worker threads.
+ * @return int Returns S_EXIT_SUCCESS if everything was copied, S_EXIT_SAME_OPERANDS if target
+ *         is inside source, otherwise S_EXIT_FAILURE.
+ */
+int Copy_Tree(const char *source, const char *target, int jobs);
+
+#endif
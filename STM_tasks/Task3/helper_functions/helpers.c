@@ -26,13 +26,14 @@
 #include "helpers.h"
 #include "../cmds_implementations/cmds.h"
 #include "../exit_status.h"
+#include "../variables/variables.h"
+#include "../arena/arena.h"
+#include "../path_cache/path_cache.h"
+#include "../console/console.h"
 
 /*****************************        Global Variables           ********************************/
 
 extern char ** __environ;
-static ProcessHistory history[HISTORY_SIZE];
-static int history_index = 0;
-static int history_count = 0;
 
 
 
@@ -41,7 +42,7 @@ static int history_count = 0;
 
 int is_internal_command(const char* command) 
 {
-    char* internal_commands[] = {"shelp", "secho", "spwd", "scp", "smv", "scd", "senvir", "stype", "sphist","sexit","sfree","suptime"};
+    char* internal_commands[] = {"shelp", "secho", "spwd", "scp", "smv", "scd", "senvir", "stype", "sphist","sexit","sfree","suptime","shash","stime","sjobs","sfg","sbg","swait","sset","sps"};
     int commands_number = sizeof(internal_commands) / sizeof(internal_commands[0]);
     for (int i = 0; i < commands_number; i++) {
         if (strcmp(internal_commands[i], command) == 0) {
@@ -51,37 +52,69 @@ int is_internal_command(const char* command)
     return S_EXIT_INVALID_COMMAND; // Command is not internal
 }
 
-int is_external_command(const char* command) 
+int resolve_command_path(const char* command, char* full_path, size_t size)
 {
+    struct stat path_stat;
+
+    /* A name with a '/' is a path, it is not searched in PATH */
+    if (strchr(command, '/') != NULL) {
+        snprintf(full_path, size, "%s", command);
+        return (stat(full_path, &path_stat) == 0 && S_ISREG(path_stat.st_mode) && access(full_path, X_OK) == 0)
+               ? S_EXIT_SUCCESS : S_EXIT_COMMAND_NOT_FOUND;
+    }
+
+    /* Repeated launches of the same program are served by the command path cache */
+    if (path_cache_lookup(command, full_path, size) == S_EXIT_SUCCESS) {
+        return S_EXIT_SUCCESS;
+    }
+
     const char* path_env = getenv("PATH");
-    if (path_env == NULL) return S_EXIT_INVALID_COMMAND; // PATH environment variable not set
-
-    char path_copy[BUFFER_SIZE];
-    strncpy(path_copy, path_env, sizeof(path_copy));
-    path_copy[sizeof(path_copy) - 1] = '\0';
-
-    char* token = strtok(path_copy, ":");
-    while (token != NULL) {
-        char full_path[BUFFER_SIZE];
-        snprintf(full_path, sizeof(full_path), "%s/%s", token, command);
-        if (access(full_path, X_OK) == 0) { // search for the command in each path in the $PATH env
-            return EXIT_SUCCESS; // Command is external
+    if (path_env == NULL || command[0] == '\0') return S_EXIT_COMMAND_NOT_FOUND; // PATH environment variable not set
+
+    /* Walk the PATH entries in place instead of copying and strtok'ing it */
+    const char* dir = path_env;
+    while (1) {
+        size_t dir_len = strcspn(dir, ":");
+        if (dir_len == 0) {
+            snprintf(full_path, size, "./%s", command);     /* Empty entry means the current directory */
+        } else {
+            snprintf(full_path, size, "%.*s/%s", (int)dir_len, dir, command);
         }
-        token = strtok(NULL, ":");
+
+        // search for the command in each path in the $PATH env
+        if (access(full_path, X_OK) == 0 && stat(full_path, &path_stat) == 0 && S_ISREG(path_stat.st_mode)) {
+            path_cache_insert(command, full_path);
+            return S_EXIT_SUCCESS;
+        }
+
+        if (dir[dir_len] == '\0') {
+            break;
+        }
+        dir += dir_len + 1;
     }
-    return S_EXIT_INVALID_COMMAND; // Command is not external
+    return S_EXIT_COMMAND_NOT_FOUND;
+}
+
+int is_external_command(const char* command) 
+{
+    char full_path[BUFFER_SIZE];
+    return resolve_command_path(command, full_path, sizeof(full_path)) == S_EXIT_SUCCESS
+           ? EXIT_SUCCESS : S_EXIT_INVALID_COMMAND;
 }
 
 void Write_syscall(int stream, const char* msg, const char* color_code) 
 {
     if (msg != NULL) {
-        write(stream, color_code, strlen(color_code));  //Changing text color
-        write(stream, msg, strlen(msg));                // Writing the message
-        write(stream, white, strlen(white));            // Return to the default text color
+        /* Color, message and reset are buffered together and written with one syscall */
+        console_write(stream, msg, strlen(msg), color_code);
     }
 }
 
 void printLineSeparator() {
+    /* Scripts only print what their commands print */
+    if (!get_shell_option(SHELL_OPTION_INTERACTIVE)) {
+        return;
+    }
     Write_syscall(STDOUT, "=========================================================================================================\n", blue);
 }
 
@@ -120,86 +153,19 @@ int is_directory(const char *path)
 }
 
 
-void trim_spaces(char *str) {
-    int start = 0;                  /* Index to mark the start of the string after trimming leading spaces. */
-    int end = strlen(str) - 1;      /* Index to mark the end of the string after trimming trailing spaces. */
-    int i, j;                       /* Loop indices for character shifting. */
-
-    /* Trim leading spaces. */
-    while (isspace((unsigned char)str[start])) {
-        start++;                    /* Move the start index forward while leading spaces are found. */
-    }
-
-    /* Trim trailing spaces. */
-    while (end >= start && isspace((unsigned char)str[end])) {
-        end--;                      /* Move the end index backward while trailing spaces are found. */
-    }
-
-    /* Shift characters to the beginning of the string to remove trimmed spaces. */
-    for (i = start, j = 0; i <= end; i++) {
-        str[j++] = str[i];          /* Copy characters from the trimmed portion to the start of the string. */
-    }
-    str[j] = '\0';                  /* Null-terminate the string after shifting characters. */
-}
-
-void reduce_spaces(char *str) {
-    int readIndex = 0, writeIndex = 0;  /* Initialize read and write indices. */
-    int inSpace = 0;                    /* Flag to track if the current character is a space. */
-
-    /* Iterate through the string until the null terminator is encountered. */
-    while (str[readIndex] != '\0') {
-        if (isspace((unsigned char)str[readIndex])) {  /* Check if the current character is a space. */
-            if (!inSpace) {                            /* If not already in a space sequence, */
-                str[writeIndex++] = ' ';               /* write a single space to the write index. */
-                inSpace = 1;                           /* Set the flag indicating we are in a space sequence. */
-            }
-        } else {
-            str[writeIndex++] = str[readIndex];        /* Write non-space characters to the write index. */
-            inSpace = 0;                               /* Reset the flag indicating we are not in a space sequence. */
-        }
-        readIndex++;                                   /* Move to the next character in the read index. */
-    }
-
-    /* Null-terminate the string. */
-    str[writeIndex] = '\0';
-
-    /* Trim trailing space if any. */
-    if (writeIndex > 0 && isspace((unsigned char)str[writeIndex - 1])) {
-        str[writeIndex - 1] = '\0';
-    }
-}
-
 int Print_Current_Directory()
 {
     char PWD[BUFFER_SIZE];
     if (getcwd(PWD, BUFFER_SIZE) != NULL) {
         // Print the current working directory in green without a newline
         Write_syscall(STDOUT, PWD,green);
-        fflush(stdout); // Flush the output buffer
+        console_flush(STDOUT); // Flush the output buffer
     } else {
         perror("getcwd() error");
     }
 }
 
 
-void Parse_Commands(char* full_command, char** Command_tokens) {
-    if (full_command == NULL || Command_tokens == NULL) {
-        return;  /* Return if input is invalid. */
-    }
-    char *tempText = strdup(full_command);  /* Create a copy of the command string to avoid modifying the original. */
-
-    char* token = strtok(tempText, " ");  /* Tokenize the copied string using space as a delimiter. */
-    int index = 0;
-    while (token != NULL && index < MAX_TOKENS - 1) {
-        Command_tokens[index++] = token;  /* Store each token in the Command_tokens array. */
-        token = strtok(NULL, " ");        /* Get the next token. */
-    }
-    
-    /* Ensure the last element of Command_tokens is NULL to mark the end of tokens. */
-    Command_tokens[index] = NULL;
-
-}
-
 int Process_Options(char** Command_tokens, char** source_path, char** target_path)
 {
     int flags = O_WRONLY;  /* Initialize flags with write-only access. */
@@ -216,6 +182,15 @@ int Process_Options(char** Command_tokens, char** source_path, char** target_pat
             flags |= O_TRUNC;         /* Add truncate flag if '-f' option is found. */
         }
 
+        /* -r and -j N (recursive copy) are read by Copy_Command itself. */
+        else if (strcmp(Command_tokens[i], "-r") == 0) {
+            continue;
+        } else if (strcmp(Command_tokens[i], "-j") == 0) {
+            if (Command_tokens[i + 1] != NULL) {
+                i++;                  /* Skip the number of jobs. */
+            }
+        }
+
         else if (*source_path == NULL) {
             *source_path = Command_tokens[i];  /* Set the source path if not already set. */
         } else if (*target_path == NULL) {
@@ -228,231 +203,283 @@ int Process_Options(char** Command_tokens, char** source_path, char** target_pat
 
 
 
+static int is_name_char(char c)
+{
+    return isalnum((unsigned char)c) || c == '_';
+}
+
 // Function to detect variable declarations (VAR_NAME=value)
-int contains_variable_declaration(const char *command, char *var_name, char *var_value) 
+int contains_variable_declaration(char *command, char **var_name, char **var_value) 
 {
     /* Find the position of the '=' character which separates variable name and value */
-    const char *var_start = strchr(command, '=');
+    char *var_start = strchr(command, '=');
     if (!var_start) {
         return S_EXIT_FAILURE; /* No '=' found, so no variable declaration */
     }
 
     /* Find the start of the variable name by moving backwards from '=' */
-    const char *var_end = var_start;
+    char *var_end = var_start;
     while (var_end > command && *(var_end - 1) != ' ' && *(var_end - 1) != '\t' && *(var_end - 1) != '\n') {
         --var_end;
     }
 
     /* Extract the variable name */
     size_t name_len = var_start - var_end;
-    if (name_len >= MAX_VAR_SIZE) {
-        return S_EXIT_FAILURE; /* Variable name exceeds maximum size */
-    }
-    strncpy(var_name, var_end, name_len);
-    var_name[name_len] = '\0'; /* Null-terminate the variable name */
 
-    /* Extract the variable value */
-    const char *value_start = var_start + 1; /* Move past '=' */
-    size_t value_len = strlen(value_start);
-    if (value_len >= MAX_VAR_SIZE) {
-        return S_EXIT_FAILURE; /* Variable value exceeds maximum size */
+    /* A name is made of letters, digits and '_' and does not start with a digit */
+    if (name_len == 0 || isdigit((unsigned char)var_end[0])) {
+        return S_EXIT_INVALID_VARIABLE_NAME;
+    }
+    for (size_t i = 0; i < name_len; i++) {
+        if (!is_name_char(var_end[i])) {
+            return S_EXIT_INVALID_VARIABLE_NAME;
+        }
     }
-    strncpy(var_value, value_start, value_len);
-    var_value[value_len] = '\0'; /* Null-terminate the variable value */
+    /* Split the word in place: the name ends at '=' and the value is the rest of the word */
+    *var_start = '\0';
+    *var_name = var_end;
+    *var_value = var_start + 1;
 
     return S_EXIT_SUCCESS; /* Successfully extracted variable name and value */
 }
 
 
-// Function to add or update a variable
-void set_variable(const char *name, const char *value) {
-    int fd = open(VAR_FILE, O_RDWR | O_CREAT, 0644);
-    if (fd < 0) {
-        perror("Failed to open file");
-        return;
+/* Returns the value of the variable name[0..len), or NULL if it does not exist.
+ * scratch is used for the special parameters which have no stored value, and the
+ * arena for the null-terminated copy of a long name looked up in the environment. */
+static const char *resolve_variable(Arena *arena, const char *name, size_t len, char *scratch, size_t scratch_size)
+{
+    if (len == 1 && name[0] == '?') {
+        snprintf(scratch, scratch_size, "%d", get_last_exit_status());
+        return scratch;
+    }
+    if (len == 1 && name[0] == '$') {
+        snprintf(scratch, scratch_size, "%d", (int)getpid());
+        return scratch;
+    }
+    if (len == 10 && memcmp(name, "PIPESTATUS", 10) == 0) {
+        return get_pipe_status();
+    }
+
+    /* Shell variables are served from the in-memory table, then the environment */
+    const char *value = lookup_variable(name, len);
+    if (value == NULL) {
+        char *env_name = scratch;
+        if (len < scratch_size) {
+            memcpy(scratch, name, len);
+            scratch[len] = '\0';
+        } else if ((env_name = arena_strndup(arena, name, len)) == NULL) {
+            return NULL;
+        }
+        value = getenv(env_name);
     }
+    return value;
+}
 
-    /* Read the entire file content */
-    off_t file_size = lseek(fd, 0, SEEK_END);
-    lseek(fd, 0, SEEK_SET);
-
-    char *file_content = malloc(file_size + 1);
-    if (!file_content) {
-        perror("Failed to allocate memory");
-        close(fd);
-        return;
+/* Returns the index-th (from 0) blank separated word of value and its length in *len,
+ * NULL if there is none. The word is not null-terminated. */
+static const char *select_word(const char *value, long index, size_t *len)
+{
+    while (value != NULL && *value != '\0') {
+        value += strspn(value, " \t");
+        size_t word_len = strcspn(value, " \t");
+        if (word_len == 0) {
+            break;
+        }
+        if (index-- == 0) {
+            *len = word_len;
+            return value;
+        }
+        value += word_len;
     }
+    *len = 0;
+    return NULL;
+}
 
-    ssize_t bytes_read = read(fd, file_content, file_size);
-    if (bytes_read < 0) {
-        perror("Failed to read file");
-        free(file_content);
-        close(fd);
-        return;
-    }
-    file_content[file_size] = '\0'; /* Null-terminate the file content */
+/* Expands the braced form ${NAME}, ${NAME[N]}, ${NAME:-word}, ${NAME-word} or ${NAME:=word}.
+ * body points after "${" and body_len excludes the closing brace. */
+static int expand_braced(StrBuf *out, const char *body, size_t body_len);
 
-    /* Prepare to write updated content to a temporary file */
-    int temp_fd = open("temp.txt", O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    if (temp_fd < 0) {
-        perror("Failed to open temp file");
-        free(file_content);
-        close(fd);
-        return;
-    }
+/* Appends src[0..len) to out, replacing every variable reference by its value */
+static int expand_into(StrBuf *out, const char *src, size_t len)
+{
+    size_t i = 0;
+    int in_double = 0;                  /* Inside "...", where ' is an ordinary character */
+
+    while (i < len) {
+        /* Copy the run of ordinary characters with a single append */
+        size_t run = i;
+        while (run < len && src[run] != '$' && src[run] != '\'' && src[run] != '"' && src[run] != '\\') {
+            run++;
+        }
+        if (run > i && strbuf_append(out, src + i, run - i) != S_EXIT_SUCCESS) {
+            return S_EXIT_MEM_ALLOC;
+        }
+        i = run;
+        if (i >= len) {
+            break;
+        }
 
-    int found = 0;
-    char *line_start = file_content;
-    char *line_end;
+        if (src[i] == '"' || (src[i] == '\'' && in_double)) {
+            /* The quotes are kept for the tokenizer, variables inside "..." are expanded */
+            if (src[i] == '"') {
+                in_double = !in_double;
+            }
+            if (strbuf_putc(out, src[i]) != S_EXIT_SUCCESS) {
+                return S_EXIT_MEM_ALLOC;
+            }
+            i++;
+            continue;
+        }
 
-    while (line_start && *line_start != '\0') {
-        line_end = strchr(line_start, '\n');
-        if (line_end) {
-            *line_end = '\0';
+        if (src[i] == '\'') {
+            /* Single quoted text is never expanded, copy it with its quotes */
+            const char *close = memchr(src + i + 1, '\'', len - i - 1);
+            size_t end = close ? (size_t)(close - src) + 1 : len;
+            if (strbuf_append(out, src + i, end - i) != S_EXIT_SUCCESS) {
+                return S_EXIT_MEM_ALLOC;
+            }
+            i = end;
+            continue;
         }
 
-        char *eq_pos = strchr(line_start, '=');
-        if (eq_pos) {
-            *eq_pos = '\0'; /* Split the line into name and value */
-            if (strcmp(line_start, name) == 0) {
-                /* Update the existing variable with the new value */
-                dprintf(temp_fd, "%s=%s\n", name, value);
-                found = 1;
-            } else {
-                dprintf(temp_fd, "%s=%s\n", line_start, eq_pos + 1);
+        if (src[i] == '\\') {
+            /* Keep the escaped character (and the backslash) for the tokenizer */
+            size_t n = (i + 1 < len) ? 2 : 1;
+            if (strbuf_append(out, src + i, n) != S_EXIT_SUCCESS) {
+                return S_EXIT_MEM_ALLOC;
             }
+            i += n;
+            continue;
         }
 
-        if (line_end) {
-            line_start = line_end + 1;
-        } else {
-            break;
+        /* src[i] == '$' */
+        size_t consumed;
+        if (expand_variable_reference(out, src + i, len - i, &consumed) != S_EXIT_SUCCESS) {
+            return S_EXIT_MEM_ALLOC;
         }
+        i += consumed;
     }
 
-    /* If the variable was not found, add it to the end of the file */
-    if (!found) {
-        dprintf(temp_fd, "%s=%s\n", name, value);
-    }
+    return S_EXIT_SUCCESS;
+}
 
-    free(file_content);
-    close(fd);
-    close(temp_fd);
+size_t variable_reference_length(const char *src, size_t len)
+{
+    if (len > 1 && (src[1] == '?' || src[1] == '$')) {
+        return 2;
+    }
+
+    if (len > 1 && src[1] == '{') {
+        /* Up to the matching brace, defaults may contain nested ${...} */
+        size_t j = 2;
+        int depth = 1;
+        while (j < len && depth > 0) {
+            if (src[j] == '{') depth++;
+            else if (src[j] == '}') depth--;
+            j++;
+        }
+        return (depth == 0) ? j : 1;
+    }
 
-    /* Replace the original file with the updated file */
-    unlink(VAR_FILE);
-    rename("temp.txt", VAR_FILE);
+    size_t name_len = 0;
+    while (1 + name_len < len && is_name_char(src[1 + name_len])) {
+        name_len++;
+    }
+    return 1 + name_len;
 }
 
-// Function to get the value of a variable
-int get_variable(const char *name, char *variable_value) {
-    int fd = open(VAR_FILE, O_RDONLY);
-    if (fd < 0) {
-        perror("Failed to open file");
-        return S_EXIT_OPEN_FILE_FAILED;
+int expand_variable_reference(StrBuf *out, const char *src, size_t len, size_t *consumed)
+{
+    char scratch[EXPAND_SCRATCH_SIZE];
+    size_t reference_len = variable_reference_length(src, len);
+
+    *consumed = reference_len;
+    if (reference_len == 1) {
+        return strbuf_putc(out, '$');   /* A lone '$' is kept as is */
+    }
+    if (src[1] == '{') {
+        return expand_braced(out, src + 2, reference_len - 3);
     }
 
-    /* Read the entire file content */
-    off_t file_size = lseek(fd, 0, SEEK_END);
-    lseek(fd, 0, SEEK_SET);
+    const char *value = resolve_variable(out->arena, src + 1, reference_len - 1, scratch, sizeof(scratch));
+    return value ? strbuf_append(out, value, strlen(value)) : S_EXIT_SUCCESS;
+}
 
-    char *file_content = malloc(file_size + 1);
-    if (!file_content) {
-        perror("Failed to allocate memory");
-        close(fd);
-        return S_EXIT_MEM_ALLOC;
-    }
+static int expand_braced(StrBuf *out, const char *body, size_t body_len)
+{
+    char scratch[EXPAND_SCRATCH_SIZE];
+    size_t name_len = 0;
 
-    ssize_t bytes_read = read(fd, file_content, file_size);
-    if (bytes_read < 0) {
-        perror("Failed to read file");
-        free(file_content);
-        close(fd);
-        return S_EXIT_READ_FILE_FAIL;
-    }
-    file_content[file_size] = '\0'; /* Null-terminate the file content */
-
-    char *line_start = file_content;
-    char *line_end;
-
-    while ((line_end = strchr(line_start, '\n')) != NULL) {
-        *line_end = '\0'; /* Null-terminate the current line */
-        char *eq_pos = strchr(line_start, '=');
-        if (eq_pos) {
-            *eq_pos = '\0'; /* Split the line into name and value */
-            if (strcmp(line_start, name) == 0) {
-                strncpy(variable_value, eq_pos + 1, MAX_VAR_SIZE - 1);
-                variable_value[MAX_VAR_SIZE - 1] = '\0'; /* Null-terminate the variable value */
-                free(file_content);
-                close(fd);
-                return S_EXIT_SUCCESS; /* Variable found */
-            }
+    if (body_len > 0 && (body[0] == '?' || body[0] == '$')) {
+        name_len = 1;
+    } else {
+        while (name_len < body_len && is_name_char(body[name_len])) {
+            name_len++;
         }
-        line_start = line_end + 1;
     }
 
-    free(file_content);
-    close(fd);
-    return S_EXIT_FAILURE; /* Variable not found */
-}
+    if (name_len == 0) {
+        return S_EXIT_SUCCESS;          /* ${} expands to nothing */
+    }
 
+    const char *value = resolve_variable(out->arena, body, name_len, scratch, sizeof(scratch));
+    size_t value_len = value ? strlen(value) : 0;
+    const char *op = body + name_len;
+    size_t rest = body_len - name_len;
 
-// Function to substitute variables in a command string
-int substitute_variables(char *command) {
-    char *result = malloc(strlen(command) + 1);
-    if (!result) {
-        perror("Failed to allocate memory");
-        return S_EXIT_MEM_ALLOC;
+    /* ${NAME[N]} is the Nth word of the value, e.g. ${PIPESTATUS[1]} */
+    if (rest > 0 && op[0] == '[') {
+        const char *close = memchr(op, ']', rest);
+        if (close == NULL) {
+            return S_EXIT_SUCCESS;
+        }
+        value = select_word(value, strtol(op + 1, NULL, 10), &value_len);
+        rest -= close + 1 - op;
+        op = close + 1;
     }
-    strcpy(result, command);
 
-    char *var_start = NULL;
-    while ((var_start = strchr(result, '$')) != NULL) {
-        char *var_end = var_start + 1;
-        while (*var_end && (isalnum(*var_end) || *var_end == '_')) {
-            var_end++;
-        }
+    int check_empty = (rest > 0 && op[0] == ':');
+    if (check_empty) {
+        op++;
+        rest--;
+    }
 
-        size_t var_name_len = var_end - (var_start + 1);
-        char var_name[var_name_len + 1];
-        strncpy(var_name, var_start + 1, var_name_len);
-        var_name[var_name_len] = '\0'; /* Null-terminate the variable name */
-
-        char var_value[MAX_VAR_SIZE];
-        if (get_variable(var_name, var_value) != S_EXIT_SUCCESS) {
-            const char *tempChar = getenv(var_name);
-            if(tempChar != NULL)
-            {
-                strcpy(var_value, tempChar);
-            }
-            else
-            {
-                var_value[0] = '\0'; /* Use empty string if variable not found */
-            }
-        }
+    int use_default = (rest > 0 && (op[0] == '-' || op[0] == '='))
+                      && (value == NULL || (check_empty && value_len == 0));
 
-        size_t result_len = strlen(result);
-        size_t var_value_len = strlen(var_value);
-        size_t new_result_len = result_len - var_name_len - 1 + var_value_len;
+    if (!use_default) {
+        return value ? strbuf_append(out, value, value_len) : S_EXIT_SUCCESS;
+    }
+
+    /* The default word is itself expanded */
+    size_t start = out->len;
+    if (expand_into(out, op + 1, rest - 1) != S_EXIT_SUCCESS) {
+        return S_EXIT_MEM_ALLOC;
+    }
 
-        char *new_result = malloc(new_result_len + 1);
-        if (!new_result) {
-            perror("Failed to allocate memory");
-            free(result);
+    /* ${NAME:=word} also assigns the default to the variable */
+    if (op[0] == '=' && is_name_char(body[0])) {
+        char *variable_name = arena_strndup(out->arena, body, name_len);
+        if (variable_name == NULL) {
             return S_EXIT_MEM_ALLOC;
         }
+        set_variable(variable_name, out->data + start);
+    }
 
-        size_t prefix_len = var_start - result;
-        strncpy(new_result, result, prefix_len);
-        strncpy(new_result + prefix_len, var_value, var_value_len);
-        strcpy(new_result + prefix_len + var_value_len, var_start + var_name_len + 1);
+    return S_EXIT_SUCCESS;
+}
 
-        free(result);
-        result = new_result;
-    }
+char *substitute_variables(Arena *arena, const char *command)
+{
+    StrBuf out;
+    strbuf_init(&out, arena);
 
-    strcpy(command, result);
-    free(result);
+    /* The empty append makes sure an empty expansion still returns a valid string */
+    if (strbuf_append(&out, "", 0) != S_EXIT_SUCCESS || expand_into(&out, command, strlen(command)) != S_EXIT_SUCCESS) {
+        perror("Failed to allocate memory");
+        return NULL;
+    }
 
-    return S_EXIT_SUCCESS; /* Successfully substituted variables */
-}
\ No newline at end of file
+    return out.data;
+}
@@ -12,44 +12,30 @@
 #ifndef HELPERS_H
 #define HELPERS_H
 
+#include <stddef.h>
+
+#include "../arena/arena.h"
+
 /* Important File Dexription */
 #define STDIN               0
 #define STDOUT              1
 #define STDERR              2
 
-#define STDIN_REDIRECT      0b001
-#define STDOUT_REDIRECT     0b010
-#define STDERR_REDIRECT     0b100
-
 /* Text Colors */
 #define green               "\033[1;32m"
 #define red                 "\033[1;31m"
 #define blue                "\033[1;34m"
 #define white               "\033[0m"
 
-/* Size of array which will carry the most recently used commands*/
+/* Number of the most recently used commands printed by sphist by default */
 #define HISTORY_SIZE        10
 
 
 /* Size of strings */
 #define BUFFER_SIZE         1024
 
-/* Size of the tokens array*/
-#define MAX_TOKENS          10
-
-#define MAX_VAR_SIZE        256
-#define MAX_LINE_SIZE       512
-#define VAR_FILE            "variables.txt"
-
-#define NUM_OF_STREAMS      3
-#define MAX_FILE_NAME_SIZE  100
-
-/* Structure used to store a command's name and exit status. 
- * An array of this structure represents the history of the most recently used commands. */
-typedef struct {
-    char command[256];
-    int exit_status;
-} ProcessHistory;
+/* Room for the special parameters ($?, $$) and short environment names during expansion */
+#define EXPAND_SCRATCH_SIZE 64
 
 
 
@@ -61,6 +47,19 @@ typedef struct {
  */
 int is_internal_command(const char* command);
 
+/**
+ * @brief Finds the executable that runs the given command.
+ * 
+ * Names containing a '/' are used as is, other names are looked up in the command path
+ * cache and, on a miss, searched in the PATH directories and added to the cache.
+ * 
+ * @param command The command name.
+ * @param full_path Buffer to store the path of the executable.
+ * @param size Size of full_path.
+ * @return int Returns S_EXIT_SUCCESS if found, otherwise S_EXIT_COMMAND_NOT_FOUND.
+ */
+int resolve_command_path(const char* command, char* full_path, size_t size);
+
 /**
  * @brief Checks if the given command is an external command by searching through the PATH environment variable.
  * 
@@ -72,6 +71,10 @@ int is_external_command(const char* command);
 /**
  * @brief Writes a message to a specified stream with a given color code.
  * 
+ * The message goes through the console buffer of the stream (see console_write()), so
+ * the color codes are only emitted on terminals and nothing is written before the
+ * buffer is flushed (newline on a terminal, full buffer or end of the command).
+ * 
  * @param stream The file descriptor of the stream to write to (e.g., STDOUT or STDERR).
  * @param msg The message to write.
  * @param color_code The color code for the message.
@@ -104,22 +107,6 @@ int is_file(const char *path);
  */
 int is_directory(const char *path);
 
-/**
- * @brief Trims leading and trailing spaces from a string.
- * 
- * @param str The string to trim.
- * @return int Returns EXIT_SUCCESS if the path is a directory, otherwise returns S_EXIT_FAILURE.
-
- */
-void trim_spaces(char *str);
-
-/**
- * @brief Reduces multiple spaces between words in a string to a single space.
- * 
- * @param str The string to process.
- */
-void reduce_spaces(char *str);
-
 /**
  * @brief Prints the current working directory to STDOUT.
  * 
@@ -127,14 +114,6 @@ void reduce_spaces(char *str);
  */
 int Print_Current_Directory();
 
-/**
- * @brief Parses a full command into tokens.
- * 
- * @param full_command The command string to parse.
- * @param Command_tokens Array of strings to store the parsed tokens.
- */
-void Parse_Commands(char* full_command, char** Command_tokens);
-
 /**
  * @brief Processes command-line options and extracts source and target paths.
  * 
@@ -149,46 +128,61 @@ int Process_Options(char** Command_tokens, char** source_path, char** target_pat
 /**
  * @brief Detects variable declarations in the format VAR_NAME=value and extracts the variable name and value.
  * 
- * @param command The command string to check.
- * @param var_name Buffer to store the extracted variable name.
- * @param var_value Buffer to store the extracted variable value.
- * @return int Returns S_EXIT_SUCCESS if a variable declaration is found, otherwise returns S_EXIT_FAILURE.
+ * The word is split in place (the '=' is replaced by '\0'), so names and values of any
+ * length are returned without copying them.
+ * 
+ * @param command The command word to check (modified on success).
+ * @param var_name Set to the variable name inside command.
+ * @param var_value Set to the variable value inside command.
+ * @return int Returns S_EXIT_SUCCESS if a variable declaration is found, S_EXIT_INVALID_VARIABLE_NAME
+ *             if the text before '=' is not a valid name, otherwise returns S_EXIT_FAILURE.
  */
-int contains_variable_declaration(const char *command, char *var_name, char *var_value);
+int contains_variable_declaration(char *command, char **var_name, char **var_value);
+
 
 /**
- * @brief Adds or updates a variable in the variables file.
- * 
- * @param name The variable name.
- * @param value The variable value.
+ * @brief Returns the length of the variable reference at the start of src.
+ *
+ * src[0] is a '$'. The reference is $NAME, $?, $$ or ${...} up to its matching brace,
+ * a '$' followed by none of them is a lone '$' of length 1. Nothing is expanded.
+ *
+ * @param src The text starting with '$'.
+ * @param len Number of characters available in src.
+ * @return size_t Number of characters of the reference.
  */
-void set_variable(const char *name, const char *value);
+size_t variable_reference_length(const char *src, size_t len);
 
 /**
- * @brief Retrieves the value of a variable from the variables file.
- * 
- * @param name The variable name.
- * @param variable_value Buffer to store the variable value.
- * @return int Returns S_EXIT_SUCCESS if the variable is found, otherwise returns S_EXIT_FAILURE.
+ * @brief Appends the value of the variable reference at the start of src to out.
+ *
+ * Accepts the same forms as substitute_variables(), a lone '$' is appended as is.
+ *
+ * @param out Buffer the value is appended to.
+ * @param src The text starting with '$'.
+ * @param len Number of characters available in src.
+ * @param consumed Set to the length of the reference (see variable_reference_length()).
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_MEM_ALLOC.
  */
-int get_variable(const char *name, char *variable_value);
-
+int expand_variable_reference(StrBuf *out, const char *src, size_t len, size_t *consumed);
 
 /**
- * @brief Substitutes variables in the given command string.
+ * @brief Expands the variable references of a text in a single pass.
  *
- * This function replaces all instances of variables in the form of `$VAR_NAME` within the
- * provided command string with their corresponding values. Variables are replaced by their
- * values obtained from the `get_variable` function. If a variable is not found, it is replaced
- * with an empty string.
+ * Used for the body of a here-document. The input is walked once and the result is
+ * appended to a buffer allocated from the line arena, so the expansion can be longer
+ * than the input without overflowing it.
+ * Supported forms are `$NAME`, `${NAME}`, `$?` (exit status of the last command), `$$`,
+ * `$PIPESTATUS` (exit status of every stage of the last pipeline), `${NAME[N]}` (Nth word),
+ * `${NAME:-word}` / `${NAME-word}` (use word if NAME is empty / unset) and `${NAME:=word}`
+ * (also assign word). Text between single quotes is copied unchanged, and values are
+ * looked up in the shell variables table first, then in the environment.
  *
- * @param command A pointer to a string containing the command with variables to be substituted.
- *                The string is modified in place to reflect the substitutions.
+ * @param arena Arena that owns the returned string.
+ * @param command The text containing the variables to be substituted.
  *
- * @return int Returns `S_EXIT_SUCCESS` on successful substitution of variables. If memory
- *         allocation fails, it returns `S_EXIT_MEM_ALLOC`.
+ * @return char* The expanded text, or NULL if memory allocation fails.
  */
-int substitute_variables(char *command);
+char *substitute_variables(Arena *arena, const char *command);
 
 
 #endif
@@ -0,0 +1,392 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        history.c              *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pwd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "history.h"
+#include "../console/console.h"
+#include "../helper_functions/helpers.h"
+#include "../exit_status.h"
+
+/*****************************            Types                  ********************************/
+
+/* First bytes of the journal, identifies the format */
+#define JOURNAL_MAGIC       "SSHHIST1"
+#define JOURNAL_MAGIC_SIZE  8
+
+/* Header of a journal record, followed by the command text (not null-terminated).
+ * header_size lets a newer shell append fields that older ones simply skip. */
+typedef struct {
+    uint16_t header_size;
+    uint16_t reserved;
+    uint32_t command_len;
+    int32_t exit_status;
+    uint32_t reserved2;
+    int64_t start_sec;
+    int64_t start_nsec;
+    int64_t duration_ns;
+    int64_t user_ns;                /* Added with the resource accounting */
+    int64_t sys_ns;
+    int64_t max_rss_kb;
+} JournalRecord;
+
+/* Size of the records written before the resource accounting fields were added */
+#define JOURNAL_RECORD_MIN_SIZE     offsetof(JournalRecord, user_ns)
+
+/*****************************        Global Variables           ********************************/
+
+static HistoryEntry ring[HISTORY_RING_SIZE];
+static size_t ring_next = 0;                /* Slot of the next command */
+static size_t ring_count = 0;               /* Number of used slots */
+static unsigned long long total_commands = 0;   /* Commands ever recorded, numbers the entries */
+static unsigned long long summarized_commands = 0;  /* Value of total_commands at the last summary */
+static int summary_enabled = 0;
+
+static int journal_fd = -1;
+static char journal_path[BUFFER_SIZE];
+
+/*****************************        Static Functions           ********************************/
+
+static long long timeval_ns(const struct timeval *tv)
+{
+    return tv->tv_sec * 1000000000LL + tv->tv_usec * 1000LL;
+}
+
+/* Stores a copy of the command with the other fields of values */
+static void ring_push(const char *command, size_t command_len, const HistoryEntry *values)
+{
+    char *copy = strndup(command, command_len);
+    if (copy == NULL) {
+        return;
+    }
+
+    HistoryEntry *entry = &ring[ring_next];
+    free(entry->command);                   /* Oldest command when the ring is full */
+
+    *entry = *values;
+    entry->command = copy;
+
+    ring_next = (ring_next + 1) % HISTORY_RING_SIZE;
+    if (ring_count < HISTORY_RING_SIZE) {
+        ring_count++;
+    }
+    total_commands++;
+}
+
+static void fill_record(JournalRecord *record, const HistoryEntry *entry, size_t command_len)
+{
+    memset(record, 0, sizeof(*record));
+    record->header_size = sizeof(*record);
+    record->command_len = command_len;
+    record->exit_status = entry->exit_status;
+    record->start_sec = entry->start.tv_sec;
+    record->start_nsec = entry->start.tv_nsec;
+    record->duration_ns = entry->duration_ns;
+    record->user_ns = entry->user_ns;
+    record->sys_ns = entry->sys_ns;
+    record->max_rss_kb = entry->max_rss_kb;
+}
+
+/* Appends one command with a single writev(), O_APPEND keeps concurrent shells from mixing records */
+static void journal_append(int fd, const HistoryEntry *entry)
+{
+    JournalRecord record;
+    size_t command_len = strlen(entry->command);
+    fill_record(&record, entry, command_len);
+
+    struct iovec iov[2] = {
+        { &record, sizeof(record) },
+        { entry->command, command_len },
+    };
+    if (writev(fd, iov, 2) != (ssize_t)(sizeof(record) + command_len)) {
+        perror("Failed to write history file");
+    }
+}
+
+static int open_journal(void)
+{
+    return open(journal_path, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+}
+
+/* Rewrites the journal with the commands of the ring only (temp file + rename) */
+static void compact_journal(void)
+{
+    char temp_path[BUFFER_SIZE + 8];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", journal_path);
+
+    int temp_fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+    if (temp_fd < 0) {
+        return;                             /* Keep the big journal, it is still valid */
+    }
+
+    if (write(temp_fd, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE) != JOURNAL_MAGIC_SIZE) {
+        close(temp_fd);
+        unlink(temp_path);
+        return;
+    }
+    for (size_t age = ring_count; age-- > 0; ) {
+        journal_append(temp_fd, cmd_history_get(age));
+    }
+
+    if (rename(temp_path, journal_path) < 0) {
+        close(temp_fd);
+        unlink(temp_path);
+        return;
+    }
+
+    close(journal_fd);
+    journal_fd = temp_fd;
+}
+
+/* Loads the records of the journal content, returns the offset of the end of the last valid record */
+static size_t load_records(const char *content, size_t size, size_t *num_records)
+{
+    size_t offset = JOURNAL_MAGIC_SIZE;
+    *num_records = 0;
+
+    while (size - offset >= sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint32_t)) {
+        JournalRecord record;
+        memset(&record, 0, sizeof(record));
+        memcpy(&record, content + offset, sizeof(uint16_t));
+
+        /* Older records lack the last fields (left at 0), newer ones carry extra fields to skip */
+        if (record.header_size < JOURNAL_RECORD_MIN_SIZE || size - offset < record.header_size) {
+            break;
+        }
+        memcpy(&record, content + offset, record.header_size < sizeof(record) ? record.header_size : sizeof(record));
+        if (size - offset - record.header_size < record.command_len) {
+            break;                          /* Cut by a crash in the middle of a write */
+        }
+
+        HistoryEntry values = {
+            .exit_status = record.exit_status,
+            .start = { record.start_sec, record.start_nsec },
+            .duration_ns = record.duration_ns,
+            .user_ns = record.user_ns,
+            .sys_ns = record.sys_ns,
+            .max_rss_kb = record.max_rss_kb,
+        };
+        ring_push(content + offset + record.header_size, record.command_len, &values);
+
+        offset += record.header_size + record.command_len;
+        (*num_records)++;
+    }
+
+    return offset;
+}
+
+/*****************************        Public Functions           ********************************/
+
+int cmd_history_load(void)
+{
+    const char *home = getenv("HOME");
+    if (home == NULL || *home == '\0') {
+        struct passwd *pw = getpwuid(getuid());
+        home = pw ? pw->pw_dir : NULL;
+    }
+    if (home == NULL) {
+        return S_EXIT_OPEN_FILE_FAILED;
+    }
+    snprintf(journal_path, sizeof(journal_path), "%s/%s", home, HISTORY_FILE);
+
+    journal_fd = open_journal();
+    if (journal_fd < 0) {
+        perror("Failed to open history file");
+        return S_EXIT_OPEN_FILE_FAILED;
+    }
+
+    struct stat file_stat;
+    if (fstat(journal_fd, &file_stat) < 0) {
+        perror("Failed to read history file");
+        close(journal_fd);
+        journal_fd = -1;
+        return S_EXIT_OPEN_FILE_FAILED;
+    }
+
+    size_t size = file_stat.st_size;
+    char *content = malloc(size ? size : 1);
+    if (content == NULL) {
+        perror("Failed to allocate memory");
+        close(journal_fd);
+        journal_fd = -1;
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    ssize_t bytes_read = pread(journal_fd, content, size, 0);
+    if (bytes_read < 0) {
+        bytes_read = 0;
+    }
+    size = bytes_read;
+
+    size_t valid_end = 0;
+    size_t num_records = 0;
+    if (size >= JOURNAL_MAGIC_SIZE && memcmp(content, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE) == 0) {
+        valid_end = load_records(content, size, &num_records);
+    } else if (size != 0) {
+        Write_syscall(STDERR, "sphist: unknown history file format, starting a new history\n", red);
+    }
+    free(content);
+
+    /* Drop what cannot be read, so the next records are appended right after the valid ones */
+    if (valid_end < size || size < JOURNAL_MAGIC_SIZE) {
+        if (ftruncate(journal_fd, valid_end) < 0) {
+            perror("Failed to repair history file");
+        }
+        if (valid_end == 0 && write(journal_fd, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE) != JOURNAL_MAGIC_SIZE) {
+            perror("Failed to write history file");
+        }
+    }
+
+    if (num_records > (size_t)HISTORY_RING_SIZE * HISTORY_COMPACT_FACTOR) {
+        compact_journal();
+    }
+
+    summarized_commands = total_commands;   /* The summary only covers this session */
+
+    return S_EXIT_SUCCESS;
+}
+
+void cmd_history_timer_start(HistoryTimer *timer)
+{
+    clock_gettime(CLOCK_REALTIME, &timer->wall);
+    clock_gettime(CLOCK_MONOTONIC, &timer->monotonic);
+    getrusage(RUSAGE_SELF, &timer->self);
+}
+
+void cmd_history_add(const char *command, int exit_status, const HistoryTimer *timer,
+                     const struct rusage *usage)
+{
+    struct timespec now;
+    HistoryEntry values = {
+        .exit_status = exit_status,
+        .start = timer->wall,
+    };
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    values.duration_ns = (now.tv_sec - timer->monotonic.tv_sec) * 1000000000LL +
+                         (now.tv_nsec - timer->monotonic.tv_nsec);
+
+    if (usage != NULL) {
+        values.user_ns = timeval_ns(&usage->ru_utime);
+        values.sys_ns = timeval_ns(&usage->ru_stime);
+        values.max_rss_kb = usage->ru_maxrss;
+    } else {
+        struct rusage self;
+        getrusage(RUSAGE_SELF, &self);
+        values.user_ns = timeval_ns(&self.ru_utime) - timeval_ns(&timer->self.ru_utime);
+        values.sys_ns = timeval_ns(&self.ru_stime) - timeval_ns(&timer->self.ru_stime);
+        /* The shell's peak covers its whole life, only the growth belongs to the command */
+        values.max_rss_kb = self.ru_maxrss - timer->self.ru_maxrss;
+    }
+
+    ring_push(command, strlen(command), &values);
+
+    if (journal_fd >= 0) {
+        journal_append(journal_fd, cmd_history_get(0));
+    }
+}
+
+const HistoryEntry *cmd_history_get(size_t age)
+{
+    if (age >= ring_count) {
+        return NULL;
+    }
+    return &ring[(ring_next + HISTORY_RING_SIZE - 1 - age) % HISTORY_RING_SIZE];
+}
+
+void cmd_history_print(size_t count)
+{
+    if (count > ring_count) {
+        count = ring_count;
+    }
+
+    /* Oldest first, like the history of other shells */
+    for (size_t age = count; age-- > 0; ) {
+        const HistoryEntry *entry = cmd_history_get(age);
+        char start[16];
+        struct tm start_tm;
+
+        localtime_r(&entry->start.tv_sec, &start_tm);
+        strftime(start, sizeof(start), "%H:%M:%S", &start_tm);
+
+        console_printf(STDOUT, NULL, "%5llu  %s  %3d  %9.3fs  %s\n", total_commands - age, start,
+                       entry->exit_status, entry->duration_ns / 1e9, entry->command);
+    }
+}
+
+void cmd_history_print_times(size_t count)
+{
+    if (count > ring_count) {
+        count = ring_count;
+    }
+
+    console_printf(STDOUT, NULL, "%5s  %9s  %9s  %9s  %10s  %s\n", "#", "real", "user", "sys", "maxrss", "command");
+    for (size_t age = count; age-- > 0; ) {
+        const HistoryEntry *entry = cmd_history_get(age);
+        console_printf(STDOUT, NULL, "%5llu  %8.3fs  %8.3fs  %8.3fs  %7ld KB  %s\n", total_commands - age,
+                       entry->duration_ns / 1e9, entry->user_ns / 1e9, entry->sys_ns / 1e9,
+                       entry->max_rss_kb, entry->command);
+    }
+}
+
+void cmd_history_set_summary(int enabled)
+{
+    summary_enabled = enabled;
+    summarized_commands = total_commands;
+}
+
+void cmd_history_print_summary(void)
+{
+    size_t count = total_commands - summarized_commands;
+    summarized_commands = total_commands;
+
+    if (!summary_enabled || count == 0) {
+        return;
+    }
+    if (count > ring_count) {
+        count = ring_count;
+    }
+
+    long long first_start = 0, last_end = 0, user_ns = 0, sys_ns = 0;
+    long max_rss_kb = 0;
+    for (size_t age = 0; age < count; age++) {
+        const HistoryEntry *entry = cmd_history_get(age);
+        long long start = entry->start.tv_sec * 1000000000LL + entry->start.tv_nsec;
+        long long end = start + entry->duration_ns;
+
+        if (age == 0 || start < first_start) {
+            first_start = start;
+        }
+        if (end > last_end) {
+            last_end = end;
+        }
+        user_ns += entry->user_ns;
+        sys_ns += entry->sys_ns;
+        if (entry->max_rss_kb > max_rss_kb) {
+            max_rss_kb = entry->max_rss_kb;
+        }
+    }
+
+    console_printf(STDOUT, white, "[real %.3fs  user %.3fs  sys %.3fs  maxrss %ld KB]\n",
+                   (last_end - first_start) / 1e9, user_ns / 1e9, sys_ns / 1e9, max_rss_kb);
+}
@@ -0,0 +1,113 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        history.h              *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+#include <time.h>
+#include <sys/resource.h>
+
+/* Journal of the executed commands, created in the home directory */
+#define HISTORY_FILE                ".sshell_history"
+
+/* Number of commands kept in memory (and printed at most by sphist) */
+#define HISTORY_RING_SIZE           1024
+
+/* The journal is compacted at startup when it holds more than this many ring sizes of records */
+#define HISTORY_COMPACT_FACTOR      4
+
+/* One executed command */
+typedef struct {
+    char *command;
+    int exit_status;
+    struct timespec start;          /* Wall-clock time the command started */
+    long long duration_ns;          /* Time it took to run */
+    long long user_ns;              /* CPU time spent in user mode */
+    long long sys_ns;               /* CPU time spent in the kernel */
+    long max_rss_kb;                /* Peak resident set size, growth of the shell's peak for a builtin run in the shell */
+} HistoryEntry;
+
+/* Start time of a command, taken before it runs and passed to cmd_history_add() */
+typedef struct {
+    struct timespec wall;
+    struct timespec monotonic;
+    struct rusage self;             /* Usage of the shell, for the commands it runs itself */
+} HistoryTimer;
+
+/**
+ * @brief Opens the history journal and loads its last HISTORY_RING_SIZE commands in memory.
+ *
+ * The journal ($HOME/HISTORY_FILE) stays open for the whole session and every command is
+ * appended to it with a single write. A record left incomplete by a crash is cut off, and
+ * a journal that grew too large is rewritten with the in-memory commands only. If the
+ * journal cannot be opened the history still works, but only for the current session.
+ *
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_OPEN_FILE_FAILED if the journal is not available.
+ */
+int cmd_history_load(void);
+
+/**
+ * @brief Records the start time of a command.
+ */
+void cmd_history_timer_start(HistoryTimer *timer);
+
+/**
+ * @brief Adds a finished command to the history and appends it to the journal.
+ *
+ * When the ring is full the oldest command is dropped from memory (it stays in the journal).
+ *
+ * @param command The command text.
+ * @param exit_status The exit status of the command.
+ * @param timer The start time recorded with cmd_history_timer_start().
+ * @param usage Resource usage of the command's process as returned by wait4(), or NULL for
+ *        a command run by the shell itself (the shell's CPU time since the timer started, and
+ *        how much its peak resident set size grew meanwhile).
+ */
+void cmd_history_add(const char *command, int exit_status, const HistoryTimer *timer,
+                     const struct rusage *usage);
+
+/**
+ * @brief Returns a command of the in-memory history.
+ *
+ * @param age 0 for the most recent command, 1 for the one before it, etc.
+ * @return const HistoryEntry* The entry, or NULL if age is not in the ring.
+ */
+const HistoryEntry *cmd_history_get(size_t age);
+
+/**
+ * @brief Prints the last commands with their number, start time, exit status and duration.
+ *
+ * @param count Number of commands to print (capped to the number of commands in memory).
+ */
+void cmd_history_print(size_t count);
+
+/**
+ * @brief Prints the wall time, CPU times and peak memory of the last commands.
+ *
+ * @param count Number of commands (capped to the number of commands in memory).
+ */
+void cmd_history_print_times(size_t count);
+
+/**
+ * @brief Enables or disables the resource summary printed before each prompt.
+ */
+void cmd_history_set_summary(int enabled);
+
+/**
+ * @brief Prints one line with the cost of the commands added since the previous call.
+ *
+ * The real time covers all of them (pipeline stages overlap), CPU times are summed and the
+ * memory is the largest peak. Nothing is printed if the summary is disabled.
+ */
+void cmd_history_print_summary(void);
+
+#endif
@@ -0,0 +1,581 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        jobs.c                 *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "jobs.h"
+#include "../console/console.h"
+#include "../helper_functions/helpers.h"
+#include "../exit_status.h"
+
+/*****************************        Global Variables           ********************************/
+
+static Job **table = NULL;                  /* Slot i holds job i + 1, NULL if free */
+static int table_size = 0;
+
+static int job_control = 0;
+static pid_t shell_pgid = 0;
+static int sigchld_pipe[2] = { -1, -1 };    /* Self-pipe written by the SIGCHLD handler */
+static int child_changed = 0;               /* SIGCHLD read from elsewhere (jobs_child_changed()) */
+
+static int *foreground_statuses = NULL;     /* Status of every process of the last foreground job */
+static int foreground_count = 0;
+static int foreground_capacity = 0;
+
+/*****************************        Static Functions           ********************************/
+
+static void sigchld_handler(int sig)
+{
+    int saved_errno = errno;
+    char byte = (char)sig;
+
+    /* The pipe is non-blocking: when it is full a wake-up is already pending */
+    if (write(sigchld_pipe[1], &byte, 1) < 0) {
+        /* Nothing to do */
+    }
+    errno = saved_errno;
+}
+
+/* Same convention as other shells: 128 + signal number for killed or stopped processes */
+static int wait_status_to_exit_status(int status)
+{
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    if (WIFSIGNALED(status)) {
+        return 128 + WTERMSIG(status);
+    }
+    return 128 + WSTOPSIG(status);
+}
+
+static void signal_job(const Job *job, int sig)
+{
+    if (job->pgid > 0) {
+        kill(-job->pgid, sig);
+        return;
+    }
+    for (int i = 0; i < job->num_processes; i++) {
+        if (job->processes[i].state != PROCESS_DONE) {
+            kill(job->processes[i].pid, sig);
+        }
+    }
+}
+
+static ProcessState job_state(const Job *job)
+{
+    ProcessState state = PROCESS_DONE;
+
+    for (int i = 0; i < job->num_processes; i++) {
+        if (job->processes[i].state == PROCESS_RUNNING) {
+            return PROCESS_RUNNING;
+        }
+        if (job->processes[i].state == PROCESS_STOPPED) {
+            state = PROCESS_STOPPED;
+        }
+    }
+    return state;
+}
+
+/* Exit status of a job: the status of its last process, or the stop signal */
+static int job_exit_status(const Job *job)
+{
+    for (int i = 0; i < job->num_processes; i++) {
+        if (job->processes[i].state == PROCESS_STOPPED) {
+            return job->processes[i].exit_status;
+        }
+    }
+    return job->num_processes ? job->processes[job->num_processes - 1].exit_status : S_EXIT_SUCCESS;
+}
+
+static void update_process(Job *job, JobProcess *process, int status, const struct rusage *usage)
+{
+    if (WIFSTOPPED(status)) {
+        process->state = PROCESS_STOPPED;
+        process->exit_status = wait_status_to_exit_status(status);
+    } else if (WIFCONTINUED(status)) {
+        process->state = PROCESS_RUNNING;
+    } else {
+        process->state = PROCESS_DONE;
+        process->exit_status = wait_status_to_exit_status(status);
+        cmd_history_add(process->text, process->exit_status, &job->timer, usage);
+    }
+    job->changed = 1;
+}
+
+/* Keeps the status of every process of a foreground job that finished or stopped */
+static void save_foreground_statuses(const Job *job)
+{
+    if (job->num_processes > foreground_capacity) {
+        int *statuses = realloc(foreground_statuses, job->num_processes * sizeof(int));
+        if (statuses == NULL) {
+            foreground_count = 0;
+            return;
+        }
+        foreground_statuses = statuses;
+        foreground_capacity = job->num_processes;
+    }
+
+    for (int i = 0; i < job->num_processes; i++) {
+        foreground_statuses[i] = job->processes[i].exit_status;
+    }
+    foreground_count = job->num_processes;
+}
+
+/* Appends a process slot to the job, NULL if the memory ran out */
+static JobProcess *append_process(Job *job, pid_t pid, const char *text)
+{
+    if (job->num_processes == job->capacity) {
+        int new_capacity = job->capacity ? job->capacity * 2 : 4;
+        JobProcess *processes = realloc(job->processes, new_capacity * sizeof(JobProcess));
+        if (processes == NULL) {
+            return NULL;
+        }
+        job->processes = processes;
+        job->capacity = new_capacity;
+    }
+
+    JobProcess *process = &job->processes[job->num_processes];
+    process->text = strdup(text);
+    if (process->text == NULL) {
+        return NULL;
+    }
+    process->pid = pid;
+    process->state = PROCESS_RUNNING;
+    process->exit_status = S_EXIT_SUCCESS;
+    job->num_processes++;
+    return process;
+}
+
+static int table_add(Job *job)
+{
+    int slot = 0;
+    while (slot < table_size && table[slot] != NULL) {
+        slot++;
+    }
+
+    if (slot == table_size) {
+        int new_size = table_size ? table_size * 2 : JOB_TABLE_INITIAL_SIZE;
+        Job **new_table = realloc(table, new_size * sizeof(Job *));
+        if (new_table == NULL) {
+            return S_EXIT_MEM_ALLOC;
+        }
+        memset(new_table + table_size, 0, (new_size - table_size) * sizeof(Job *));
+        table = new_table;
+        table_size = new_size;
+    }
+
+    table[slot] = job;
+    job->id = slot + 1;
+    return S_EXIT_SUCCESS;
+}
+
+static void free_job(Job *job)
+{
+    if (job->id > 0) {
+        table[job->id - 1] = NULL;
+    }
+    for (int i = 0; i < job->num_processes; i++) {
+        free(job->processes[i].text);
+    }
+    free(job->processes);
+    free(job->text);
+    free(job);
+}
+
+/* Blocks until every process of the job finished or stopped (Ctrl+Z stops the whole group) */
+static void wait_for_job(Job *job, int foreground)
+{
+    for (int i = 0; i < job->num_processes; i++) {
+        JobProcess *process = &job->processes[i];
+
+        while (process->state == PROCESS_RUNNING) {
+            int status;
+            struct rusage usage;
+
+            if (wait4(process->pid, &status, WUNTRACED, &usage) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                process->state = PROCESS_DONE;  /* Already reaped, nothing left to wait for */
+                process->exit_status = S_EXIT_FAILURE;
+                break;
+            }
+
+            /* A process that read the terminal before it was handed over is simply resumed */
+            if (foreground && job_control && WIFSTOPPED(status) &&
+                (WSTOPSIG(status) == SIGTTIN || WSTOPSIG(status) == SIGTTOU)) {
+                signal_job(job, SIGCONT);
+                continue;
+            }
+
+            update_process(job, process, status, &usage);
+        }
+    }
+}
+
+static const char *state_name(const Job *job, char *buffer, size_t size)
+{
+    switch (job_state(job)) {
+    case PROCESS_RUNNING:
+        return "Running";
+    case PROCESS_STOPPED:
+        return "Stopped";
+    default:
+        if (job_exit_status(job) == S_EXIT_SUCCESS) {
+            return "Done";
+        }
+        snprintf(buffer, size, "Exit %d", job_exit_status(job));
+        return buffer;
+    }
+}
+
+/*****************************        Public Functions           ********************************/
+
+void jobs_init(int interactive)
+{
+    if (pipe2(sigchld_pipe, O_NONBLOCK | O_CLOEXEC) == 0) {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = sigchld_handler;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGCHLD, &action, NULL);
+    } else {
+        perror("pipe");
+    }
+
+    if (!interactive || !isatty(STDIN)) {
+        return;                             /* Scripts and pipes: no job control */
+    }
+
+    /* Wait until the shell is in the foreground if it was started in the background */
+    while (tcgetpgrp(STDIN) != (shell_pgid = getpgrp())) {
+        kill(-shell_pgid, SIGTTIN);
+    }
+
+    signal(SIGTSTP, SIG_IGN);
+    signal(SIGTTIN, SIG_IGN);
+    signal(SIGTTOU, SIG_IGN);
+
+    /* A session leader is already alone in its group */
+    if (setpgid(0, 0) == 0) {
+        shell_pgid = getpid();
+    }
+    if (tcsetpgrp(STDIN, shell_pgid) < 0) {
+        perror("tcsetpgrp");
+        return;
+    }
+
+    job_control = 1;
+}
+
+int jobs_control_enabled(void)
+{
+    return job_control;
+}
+
+Job *job_create(const char *text)
+{
+    Job *job = calloc(1, sizeof(Job));
+    if (job == NULL) {
+        return NULL;
+    }
+
+    job->text = strdup(text);
+    if (job->text == NULL) {
+        free(job);
+        return NULL;
+    }
+
+    cmd_history_timer_start(&job->timer);
+    return job;
+}
+
+int job_add_process(Job *job, pid_t pid, const char *text)
+{
+    if (append_process(job, pid, text) == NULL) {
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    if (job_control) {
+        if (job->pgid == 0) {
+            job->pgid = pid;
+        }
+        setpgid(pid, job->pgid);            /* Also done by the child, whichever runs first */
+    }
+    return S_EXIT_SUCCESS;
+}
+
+int job_add_finished_process(Job *job, const char *text, int exit_status)
+{
+    JobProcess *process = append_process(job, 0, text);
+    if (process == NULL) {
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    process->state = PROCESS_DONE;
+    process->exit_status = exit_status;
+    cmd_history_add(text, exit_status, &job->timer, NULL);
+    return S_EXIT_SUCCESS;
+}
+
+pid_t job_process_group(const Job *job)
+{
+    return job_control ? job->pgid : -1;
+}
+
+void job_child_setup(const Job *job, int foreground)
+{
+    if (job_control) {
+        pid_t pgid = job->pgid ? job->pgid : getpid();
+        setpgid(0, pgid);
+        if (foreground) {
+            tcsetpgrp(STDIN, pgid);         /* SIGTTOU is still ignored here */
+        }
+
+        signal(SIGTSTP, SIG_DFL);
+        signal(SIGTTIN, SIG_DFL);
+        signal(SIGTTOU, SIG_DFL);
+    }
+
+    signal(SIGCHLD, SIG_DFL);
+    close(sigchld_pipe[0]);
+    close(sigchld_pipe[1]);
+
+    /* The interactive shell blocks the signals it reads from a signalfd */
+    sigset_t none;
+    sigemptyset(&none);
+    sigprocmask(SIG_SETMASK, &none, NULL);
+}
+
+int job_run_foreground(Job *job)
+{
+    if (job_control && job->pgid > 0) {
+        tcsetpgrp(STDIN, job->pgid);
+    }
+
+    wait_for_job(job, 1);
+
+    if (job_control) {
+        tcsetpgrp(STDIN, shell_pgid);
+    }
+
+    int exit_status = job_exit_status(job);
+    save_foreground_statuses(job);
+
+    if (job_state(job) == PROCESS_STOPPED) {
+        /* Ctrl+Z: keep the job so it can be continued with sfg or sbg */
+        if (job->id == 0 && table_add(job) != S_EXIT_SUCCESS) {
+            signal_job(job, SIGCONT);
+            return job_run_foreground(job);
+        }
+        job->changed = 0;
+        console_printf(STDOUT, NULL, "\n[%d]  Stopped  %s\n", job->id, job->text);
+        return exit_status;
+    }
+
+    free_job(job);
+    return exit_status;
+}
+
+void job_run_background(Job *job)
+{
+    if (table_add(job) != S_EXIT_SUCCESS) {
+        perror("Failed to allocate memory");
+        job_run_foreground(job);
+        return;
+    }
+
+    if (job_control) {
+        console_printf(STDOUT, NULL, "[%d] %d\n", job->id, job->processes[job->num_processes - 1].pid);
+    }
+}
+
+void jobs_reap(void)
+{
+    char buffer[64];
+    int signaled = 0;
+
+    /* Only look at the children when SIGCHLD was received since the last call */
+    while (read(sigchld_pipe[0], buffer, sizeof(buffer)) > 0) {
+        signaled = 1;
+    }
+    if (!signaled && !child_changed && sigchld_pipe[0] >= 0) {
+        return;
+    }
+    child_changed = 0;
+
+    for (int i = 0; i < table_size; i++) {
+        Job *job = table[i];
+        if (job == NULL) {
+            continue;
+        }
+
+        for (int j = 0; j < job->num_processes; j++) {
+            JobProcess *process = &job->processes[j];
+            int status;
+            struct rusage usage;
+
+            if (process->state != PROCESS_DONE &&
+                wait4(process->pid, &status, WNOHANG | WUNTRACED | WCONTINUED, &usage) == process->pid) {
+                update_process(job, process, status, &usage);
+            }
+        }
+    }
+}
+
+void jobs_notify(void)
+{
+    char state[32];
+
+    for (int i = 0; i < table_size; i++) {
+        Job *job = table[i];
+        if (job == NULL || !job->changed) {
+            continue;
+        }
+
+        ProcessState job_current_state = job_state(job);
+        if (job_current_state != PROCESS_RUNNING && job_control) {
+            console_printf(STDOUT, NULL, "[%d]  %s  %s\n", job->id, state_name(job, state, sizeof(state)), job->text);
+        }
+
+        job->changed = 0;
+        if (job_current_state == PROCESS_DONE) {
+            free_job(job);
+        }
+    }
+}
+
+int jobs_last_statuses(const int **statuses)
+{
+    *statuses = foreground_statuses;
+    return foreground_count;
+}
+
+int jobs_notify_pending(void)
+{
+    for (int i = 0; i < table_size; i++) {
+        if (table[i] != NULL && table[i]->changed && job_control && job_state(table[i]) != PROCESS_RUNNING) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void jobs_child_changed(void)
+{
+    child_changed = 1;
+}
+
+void jobs_print(int show_pids)
+{
+    char state[32];
+
+    for (int i = 0; i < table_size; i++) {
+        Job *job = table[i];
+        if (job == NULL) {
+            continue;
+        }
+
+        console_printf(STDOUT, NULL, "[%d]  %-8s  %s\n", job->id, state_name(job, state, sizeof(state)), job->text);
+        if (show_pids) {
+            for (int j = 0; j < job->num_processes; j++) {
+                console_printf(STDOUT, NULL, "      %d  %s\n", job->processes[j].pid, job->processes[j].text);
+            }
+        }
+
+        /* A finished job is reported once */
+        job->changed = 0;
+        if (job_state(job) == PROCESS_DONE) {
+            free_job(job);
+        }
+    }
+}
+
+Job *job_find(const char *spec)
+{
+    if (spec == NULL) {
+        for (int i = table_size - 1; i >= 0; i--) {
+            if (table[i] != NULL) {
+                return table[i];
+            }
+        }
+        return NULL;
+    }
+
+    if (*spec == '%') {
+        spec++;
+    }
+    char *end;
+    long id = strtol(spec, &end, 10);
+    if (*spec == '\0' || *end != '\0' || id < 1 || id > table_size) {
+        return NULL;
+    }
+    return table[id - 1];
+}
+
+int job_continue(Job *job, int foreground)
+{
+    for (int i = 0; i < job->num_processes; i++) {
+        if (job->processes[i].state == PROCESS_STOPPED) {
+            job->processes[i].state = PROCESS_RUNNING;
+        }
+    }
+
+    if (foreground) {
+        console_printf(STDOUT, NULL, "%s\n", job->text);
+        console_flush_all();
+        if (job_control && job->pgid > 0) {
+            tcsetpgrp(STDIN, job->pgid);    /* Before SIGCONT, so it does not stop again on the terminal */
+        }
+        signal_job(job, SIGCONT);
+        return job_run_foreground(job);
+    }
+
+    signal_job(job, SIGCONT);
+    console_printf(STDOUT, NULL, "[%d]  %s &\n", job->id, job->text);
+    return S_EXIT_SUCCESS;
+}
+
+int job_wait(Job *job)
+{
+    wait_for_job(job, 0);
+
+    int exit_status = job_exit_status(job);
+    if (job_state(job) == PROCESS_DONE) {
+        free_job(job);
+    }
+    return exit_status;
+}
+
+int jobs_wait_all(void)
+{
+    int exit_status = S_EXIT_SUCCESS;
+
+    for (int i = 0; i < table_size; i++) {
+        if (table[i] != NULL && job_state(table[i]) == PROCESS_RUNNING) {
+            exit_status = job_wait(table[i]);
+        }
+    }
+    return exit_status;
+}
@@ -0,0 +1,187 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        jobs.h                 *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <sys/types.h>
+
+#include "../history/history.h"
+
+/* Initial number of slots of the job table */
+#define JOB_TABLE_INITIAL_SIZE      8
+
+typedef enum {
+    PROCESS_RUNNING,
+    PROCESS_STOPPED,
+    PROCESS_DONE
+} ProcessState;
+
+/* One process of a job (a stage of its pipeline) */
+typedef struct {
+    pid_t pid;
+    char *text;                     /* Source text of the stage (used for history) */
+    ProcessState state;
+    int exit_status;                /* Valid once the process is done */
+} JobProcess;
+
+/* A pipeline started by the shell. Foreground jobs only enter the job table when they stop. */
+typedef struct {
+    int id;                         /* Number shown by sjobs (%id), 0 while not in the table */
+    pid_t pgid;                     /* Process group, 0 until the first process is added */
+    char *text;
+    JobProcess *processes;
+    int num_processes;
+    int capacity;
+    HistoryTimer timer;
+    int changed;                    /* State change not reported yet */
+} Job;
+
+/**
+ * @brief Prepares job control.
+ *
+ * When the shell is interactive and reads from a terminal it moves to its own process group, takes the
+ * terminal and ignores the stop signals (SIGTSTP, SIGTTIN and SIGTTOU), so every job
+ * gets its own process group and the terminal is handed to the foreground one.
+ * A SIGCHLD handler writes to a self-pipe so finished background processes are only
+ * reaped when one of them actually changed state.
+ */
+void jobs_init(int interactive);
+
+/**
+ * @brief Returns 1 if jobs get their own process group and the terminal, 0 otherwise.
+ */
+int jobs_control_enabled(void);
+
+/**
+ * @brief Allocates a new job with no process and starts its timer.
+ *
+ * @param text Source text of the pipeline.
+ * @return Job* The job, or NULL if the allocation failed.
+ */
+Job *job_create(const char *text);
+
+/**
+ * @brief Adds a started process to a job, the first one gives its pid to the process group.
+ *
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_MEM_ALLOC.
+ */
+int job_add_process(Job *job, pid_t pid, const char *text);
+
+/**
+ * @brief Adds a stage that has no process, so the statuses still match the stages.
+ *
+ * Used for a stage that could not be started or a builtin that ran in the shell: it is
+ * recorded as already finished with the given status and added to the history.
+ *
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_MEM_ALLOC.
+ */
+int job_add_finished_process(Job *job, const char *text, int exit_status);
+
+/**
+ * @brief Returns the process group a new process of the job must join.
+ *
+ * @return pid_t -1 without job control, 0 for the first process (new group), else the job's group.
+ */
+pid_t job_process_group(const Job *job);
+
+/**
+ * @brief Puts a forked child in the job's process group and restores the default signals.
+ *
+ * @param job The job the child belongs to.
+ * @param foreground 1 if the job gets the terminal.
+ */
+void job_child_setup(const Job *job, int foreground);
+
+/**
+ * @brief Gives the terminal to a job and waits until all its processes finish or it stops.
+ *
+ * Finished processes are added to the history. A stopped job (Ctrl+Z) is kept in the job
+ * table, otherwise the job is freed.
+ *
+ * @return int Exit status of the last process, 128 + signal if it was killed or stopped.
+ */
+int job_run_foreground(Job *job);
+
+/**
+ * @brief Adds a job to the job table without waiting for it.
+ */
+void job_run_background(Job *job);
+
+/**
+ * @brief Collects the status of the background processes that changed state.
+ *
+ * Never blocks: it only calls wait4(WNOHANG) after SIGCHLD was received.
+ */
+void jobs_reap(void);
+
+/**
+ * @brief Reports the jobs that finished or stopped since the last call and forgets finished ones.
+ */
+void jobs_notify(void);
+
+/**
+ * @brief Returns the status of every process of the last job run in the foreground.
+ *
+ * @param statuses Set to the statuses, in pipeline order (valid until the next foreground job).
+ * @return int The number of statuses.
+ */
+int jobs_last_statuses(const int **statuses);
+
+/**
+ * @brief Tells if jobs_notify() has something to print.
+ *
+ * @return int 1 when a job finished or stopped since the last report, 0 otherwise.
+ */
+int jobs_notify_pending(void);
+
+/**
+ * @brief Makes the next jobs_reap() look at the children, for callers reading SIGCHLD themselves.
+ */
+void jobs_child_changed(void);
+
+/**
+ * @brief Prints the job table.
+ *
+ * @param show_pids 1 to also print the pid of every process.
+ */
+void jobs_print(int show_pids);
+
+/**
+ * @brief Finds a job of the table.
+ *
+ * @param spec "%N" or "N" for job N, or NULL for the most recent job.
+ * @return Job* The job, or NULL if there is no such job.
+ */
+Job *job_find(const char *spec);
+
+/**
+ * @brief Continues a job (SIGCONT) in the foreground or in the background.
+ *
+ * @return int In the foreground the exit status of the job, otherwise S_EXIT_SUCCESS.
+ */
+int job_continue(Job *job, int foreground);
+
+/**
+ * @brief Waits until a job of the table finishes or stops, without giving it the terminal.
+ *
+ * @return int Exit status of its last process, 128 + signal if it was killed or stopped.
+ */
+int job_wait(Job *job);
+
+/**
+ * @brief Waits for all the running jobs of the table (stopped jobs are left alone).
+ *
+ * @return int Exit status of the last job waited for, S_EXIT_SUCCESS if there was none.
+ */
+int jobs_wait_all(void);
+
+#endif
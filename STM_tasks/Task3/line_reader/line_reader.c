@@ -0,0 +1,110 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        line_reader.c          *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "line_reader.h"
+#include "../exit_status.h"
+
+/*****************************        Static Functions           ********************************/
+
+/* Makes room for at least LINE_READER_BUFFER_SIZE more bytes after the pending ones */
+static int make_room(LineReader *reader)
+{
+    /* Move the unread part to the front, a pending partial line is usually short */
+    if (reader->start > 0) {
+        memmove(reader->data, reader->data + reader->start, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+
+    /* One byte is kept for the terminator of a last line without newline */
+    if (reader->size - reader->end < LINE_READER_BUFFER_SIZE + 1) {
+        size_t new_size = reader->size * 2;
+        char *data = realloc(reader->data, new_size);
+        if (data == NULL) {
+            return S_EXIT_MEM_ALLOC;
+        }
+        reader->data = data;
+        reader->size = new_size;
+    }
+    return S_EXIT_SUCCESS;
+}
+
+/*****************************        Public Functions           ********************************/
+
+int line_reader_init(LineReader *reader, int fd)
+{
+    reader->fd = fd;
+    reader->size = 2 * LINE_READER_BUFFER_SIZE;
+    reader->start = 0;
+    reader->end = 0;
+    reader->eof = 0;
+    reader->data = malloc(reader->size);
+    return reader->data ? S_EXIT_SUCCESS : S_EXIT_MEM_ALLOC;
+}
+
+char *line_reader_next(LineReader *reader)
+{
+    size_t scanned = reader->start;
+
+    while (1) {
+        char *newline = memchr(reader->data + scanned, '\n', reader->end - scanned);
+        if (newline != NULL) {
+            char *line = reader->data + reader->start;
+            *newline = '\0';
+            reader->start = newline + 1 - reader->data;
+            return line;
+        }
+
+        if (reader->eof) {
+            if (reader->start == reader->end) {
+                return NULL;
+            }
+            /* Last line without a newline, make_room() kept a byte for its terminator */
+            char *line = reader->data + reader->start;
+            reader->data[reader->end] = '\0';
+            reader->start = reader->end;
+            return line;
+        }
+
+        scanned = reader->end - reader->start;      /* Offset after make_room() moved the data */
+        if (make_room(reader) != S_EXIT_SUCCESS) {
+            perror("Failed to allocate memory");
+            return NULL;
+        }
+
+        ssize_t count = read(reader->fd, reader->data + reader->end, reader->size - reader->end - 1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("read");
+            return NULL;
+        }
+        if (count == 0) {
+            reader->eof = 1;
+        }
+        reader->end += count;
+    }
+}
+
+void line_reader_free(LineReader *reader)
+{
+    free(reader->data);
+    reader->data = NULL;
+}
@@ -0,0 +1,55 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        line_reader.h          *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef LINE_READER_H
+#define LINE_READER_H
+
+#include <stddef.h>
+
+/* Bytes read from the file with each read() call */
+#define LINE_READER_BUFFER_SIZE     (64 * 1024)
+
+/* Reads the lines of a script (or of a non-terminal stdin) through one large buffer */
+typedef struct {
+    int fd;
+    char *data;
+    size_t size;                    /* Capacity of data, grows for lines longer than it */
+    size_t start;                   /* First byte not returned yet */
+    size_t end;                     /* End of the bytes read so far */
+    int eof;
+} LineReader;
+
+/**
+ * @brief Prepares a reader for an open file descriptor.
+ *
+ * @param reader The reader to initialize.
+ * @param fd The descriptor to read from (not closed by the reader).
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_MEM_ALLOC if the buffer could not be allocated.
+ */
+int line_reader_init(LineReader *reader, int fd);
+
+/**
+ * @brief Returns the next line without its newline.
+ *
+ * The line points into the reader's buffer and stays valid until the next call. A last
+ * line without a newline is still returned.
+ *
+ * @param reader The reader.
+ * @return char* The null-terminated line, or NULL at the end of the input or on a read error.
+ */
+char *line_reader_next(LineReader *reader);
+
+/**
+ * @brief Frees the reader's buffer.
+ */
+void line_reader_free(LineReader *reader);
+
+#endif
@@ -17,6 +17,7 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <readline/readline.h>
 #include <readline/history.h>
 
@@ -24,72 +25,263 @@
 #include "utilities/utils.h"
 #include "helper_functions/helpers.h"
 #include "cmds_implementations/cmds.h"
+#include "variables/variables.h"
+#include "arena/arena.h"
+#include "parser/parser.h"
+#include "console/console.h"
+#include "history/history.h"
+#include "jobs/jobs.h"
+#include "line_reader/line_reader.h"
+#include "prompt/prompt.h"
+#include "event_loop/event_loop.h"
 
+static Arena *interactive_arena = NULL;     /* Line arena of the readline callbacks */
 
-int main()
+
+/* Parses and executes one line of input, here-documents read the next lines */
+static void run_line(Arena *line_arena, const char *line, NextLineFunction next_line, void *context)
+{
+    /* Release the previous line's allocations at once */
+    arena_reset(line_arena);
+
+    /* Tokenize and parse the whole line (pipes, redirections, quotes, && || ;) in one pass.
+     * Variables are expanded word by word when each pipeline runs. */
+    CommandList *list = Parse_Command_Line(line_arena, line);
+    if (list == NULL) {
+        set_last_exit_status(S_EXIT_INVALID_COMMAND);
+        if (get_shell_option(SHELL_OPTION_ERREXIT)) {
+            exit(S_EXIT_INVALID_COMMAND);
+        }
+        return;
+    }
+
+    /* If enter is pressed => Do nothing */
+    if (list->count == 0) {
+        return;  
+    }
+
+    /* The bodies of <<WORD come from the lines after the command */
+    if (list->here_documents != NULL &&
+        Read_Here_Documents(line_arena, list, next_line, context) != S_EXIT_SUCCESS) {
+        perror("Failed to allocate memory");
+        return;
+    }
+
+    Execute_Command_List(list);
+}
+
+/* Next line of the -c string, context points to the rest of the string */
+static char *next_string_line(void *context)
+{
+    char **rest = context;
+    char *line = *rest;
+
+    if (line == NULL) {
+        return NULL;
+    }
+
+    char *newline = strchr(line, '\n');
+    if (newline != NULL) {
+        *newline = '\0';
+    }
+    *rest = newline ? newline + 1 : NULL;
+    return line;
+}
+
+/* Runs the commands of -c, one line at a time */
+static int run_string(Arena *line_arena, char *commands)
+{
+    char *line;
+
+    while ((line = next_string_line(&commands)) != NULL) {
+        jobs_reap();
+        run_line(line_arena, line, next_string_line, &commands);
+    }
+
+    return get_last_exit_status();
+}
+
+static char *next_script_line(void *context)
+{
+    return line_reader_next(context);
+}
+
+/* Next line typed at the "> " prompt of a here-document, context holds the previous one to free */
+static char *next_typed_line(void *context)
+{
+    char **previous = context;
+
+    free(*previous);
+    console_flush_all();
+    *previous = readline("> ");
+    return *previous;
+}
+
+/* Runs a script (or a non-terminal stdin) without prompt, readline or history journal */
+static int run_script(Arena *line_arena, int fd)
+{
+    LineReader reader;
+    char *line;
+
+    if (line_reader_init(&reader, fd) != S_EXIT_SUCCESS) {
+        perror("Failed to allocate memory");
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    while ((line = line_reader_next(&reader)) != NULL) {
+        jobs_reap();
+        run_line(line_arena, line, next_script_line, &reader);
+    }
+
+    line_reader_free(&reader);
+    return get_last_exit_status();
+}
+
+/* Work done before every prompt, then the prompt is shown again */
+static void show_prompt(void (*line_handler)(char *))
+{
+    /* Collect the background jobs that finished and report them */
+    jobs_child_changed();
+    jobs_reap();
+    jobs_notify();
+
+    /* Print what the previous line cost (enabled with stime -s on) */
+    cmd_history_print_summary();
+
+    /* The prompt (rendered again only when user, host or directory changed) must follow the output */
+    console_flush_all();
+    rl_callback_handler_install(prompt_get(), line_handler);
+}
+
+/* Called by readline with a complete line, NULL on Ctrl+D */
+static void handle_line(char *full_command)
 {
-    char variable_name[MAX_VAR_SIZE]; 
-    char variable_value[MAX_VAR_SIZE]; 
-    char *commands[MAX_PIPES + 1];
+    /* The command owns the terminal while it runs */
+    rl_callback_handler_remove();
+
+    /* Ctrl+D on an empty line ends the shell like sexit */
+    if (full_command == NULL) {
+        Write_syscall(STDOUT, "\n", NULL);
+        event_loop_stop();
+        return;
+    }
 
-    char* shell_msg = " $ Go Ahead! > ";
-    char* full_command;     
-    int Exit_Status = 0;
-    char Target_files[NUM_OF_STREAMS][MAX_FILE_NAME_SIZE];
-    
+    add_history(full_command);
+    char *document_line = NULL;
+    run_line(interactive_arena, full_command, next_typed_line, &document_line);
+    free(document_line);
+    free(full_command);
+
+    show_prompt(handle_line);
+}
 
+static void read_terminal(void *context)
+{
+    (void)context;
+    rl_callback_read_char();
+}
+
+/* A background job changed state: report it above the line being typed */
+static void child_changed(void *context)
+{
+    (void)context;
+    jobs_child_changed();
+    jobs_reap();
+
+    if (jobs_notify_pending()) {
+        event_loop_output_begin();
+        jobs_notify();
+        event_loop_output_end();
+    }
+}
+
+static void terminal_resized(void *context)
+{
+    (void)context;
+    rl_resize_terminal();
+}
+
+/* Reads the commands typed at the prompt until sexit or Ctrl+D */
+static int run_interactive(Arena *line_arena)
+{
     WelcomeMessage(); 
 
-    while(1)
-    {
-        char *Command_tokens[MAX_TOKENS] = {NULL}; 
+    /* Load the recent commands, the journal stays open to record the new ones */
+    cmd_history_load();
 
-        /* Print username and host name */
-        print_prompt();
+    /* The terminal, SIGCHLD and SIGWINCH are multiplexed so job reports do not wait for enter */
+    interactive_arena = line_arena;
+    rl_catch_sigwinch = 0;
+    if (event_loop_init() != S_EXIT_SUCCESS ||
+        event_loop_watch_signal(SIGCHLD, child_changed, NULL) != S_EXIT_SUCCESS ||
+        event_loop_watch_signal(SIGWINCH, terminal_resized, NULL) != S_EXIT_SUCCESS ||
+        event_loop_add_fd(STDIN, read_terminal, NULL) != S_EXIT_SUCCESS) {
+        return S_EXIT_FAILURE;
+    }
 
-        /* Print the current working directory */
-        Print_Current_Directory(); 
+    show_prompt(handle_line);
+    event_loop_run();
+    rl_callback_handler_remove();
 
-        /* Read the command from user */
-        full_command = readline(shell_msg);
-        add_history(full_command);
-        
-        /* Remove leading and trailing spaces from the command */
-        trim_spaces(full_command);
+    return get_last_exit_status();
+}
+
+static void print_usage(void)
+{
+    Write_syscall(STDERR, "Usage: output [-e] [-c COMMANDS | SCRIPT]\n", red);
+    Write_syscall(STDERR, "    -e           exit as soon as a command fails\n", NULL);
+    Write_syscall(STDERR, "    -c COMMANDS  run COMMANDS instead of reading them\n", NULL);
+    Write_syscall(STDERR, "    SCRIPT       run the commands of a file (stdin when it is not a terminal)\n", NULL);
+}
 
-        /* Reduce number of spaces between words to 1 space */
-        reduce_spaces(full_command);
+int main(int argc, char **argv)
+{
+    Arena line_arena = {0};     /* Owns everything allocated for the current line */
+    char *commands = NULL;
+    int opt;
 
-        /* If enter is pressed => Do nothing */
-        if (strlen(full_command) == 0) {
-            continue;  
+    while ((opt = getopt(argc, argv, "+ec:")) != -1) {
+        switch (opt) {
+        case 'e':
+            set_shell_option(SHELL_OPTION_ERREXIT, 1);
+            break;
+        case 'c':
+            commands = optarg;
+            break;
+        default:
+            print_usage();
+            return S_EXIT_INVALID_COMMAND;
         }
+    }
 
-        /* If the command was variable declaration (contains =) */
-        if(contains_variable_declaration(full_command,variable_name,variable_value) == S_EXIT_SUCCESS)
-        {
-            /* Add the variable to the variables file */
-            set_variable(variable_name,variable_value);
+    const char *script = (optind < argc) ? argv[optind] : NULL;
+    int script_fd = STDIN;
+    if (commands == NULL && script != NULL) {
+        script_fd = open(script, O_RDONLY | O_CLOEXEC);
+        if (script_fd < 0) {
+            perror(script);
+            return S_EXIT_OPEN_FILE_FAILED;
         }
+    }
 
-        /* If the command contains variable usage (contains $) => substitute by the its value */
-        substitute_variables(full_command);
+    int interactive = (commands == NULL && script == NULL && isatty(STDIN));
+    set_shell_option(SHELL_OPTION_INTERACTIVE, interactive);
 
-        /* Check if redirection is used */
-        int redirections = SearchForRedirections(full_command, Target_files);
+    /* Load the saved shell variables once, they are kept in memory afterwards */
+    load_variables();
 
-        /* Convert command into tokens */
-        Parse_Commands(full_command, Command_tokens); 
-        
-        /* Check if piping is used (contain |) */
-        int num_pipes = Parse_Pipes(full_command, commands);
+    /* Own process group and terminal (interactive only), SIGCHLD reaper for the background jobs */
+    jobs_init(interactive);
 
-        if (num_pipes == 0) {
-            Execute_Single_Command(full_command, Command_tokens, redirections, Target_files);
-        } else {
-            Exit_Status = Execute_Piped_Commands(commands, num_pipes, redirections, Target_files);
-        }
+    int Exit_Status;
+    if (interactive) {
+        Exit_Status = run_interactive(&line_arena);
+    } else if (commands != NULL) {
+        Exit_Status = run_string(&line_arena, commands);
+    } else {
+        Exit_Status = run_script(&line_arena, script_fd);
     }
 
-    return 0;
+    arena_free(&line_arena);
+    return Exit_Status;
 }
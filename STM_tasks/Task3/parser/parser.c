@@ -0,0 +1,826 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        parser.c               *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <glob.h>
+#include <limits.h>
+
+#include "parser.h"
+#include "../helper_functions/helpers.h"
+#include "../exit_status.h"
+#include "../console/console.h"
+
+/*****************************            Types                  ********************************/
+
+typedef enum {
+    TOKEN_WORD,
+    TOKEN_PIPE,                     /* |  */
+    TOKEN_AND,                      /* && */
+    TOKEN_OR,                       /* || */
+    TOKEN_SEMICOLON,                /* ;  */
+    TOKEN_AMPERSAND,                /* &  */
+    TOKEN_REDIRECTION,              /* One of the RedirectionOperator */
+    TOKEN_END,
+    TOKEN_ERROR
+} TokenType;
+
+typedef enum {
+    OP_LESS,                        /* <   */
+    OP_GREAT,                       /* >   */
+    OP_DGREAT,                      /* >>  */
+    OP_LESS_AND,                    /* <&  */
+    OP_GREAT_AND,                   /* >&  */
+    OP_AND_GREAT,                   /* &>  */
+    OP_AND_DGREAT,                  /* &>> */
+    OP_DLESS,                       /* <<  */
+    OP_DLESS_DASH,                  /* <<- */
+    OP_TLESS                        /* <<< */
+} RedirectionOperator;
+
+/* Longest operators first so that the first match is the right one */
+static const struct {
+    const char *text;
+    size_t len;
+    RedirectionOperator op;
+} redirection_operators[] = {
+    { "&>>", 3, OP_AND_DGREAT },
+    { "<<<", 3, OP_TLESS },
+    { "<<-", 3, OP_DLESS_DASH },
+    { "&>",  2, OP_AND_GREAT },
+    { ">>",  2, OP_DGREAT },
+    { "<<",  2, OP_DLESS },
+    { "<&",  2, OP_LESS_AND },
+    { ">&",  2, OP_GREAT_AND },
+    { "<",   1, OP_LESS },
+    { ">",   1, OP_GREAT },
+};
+
+typedef struct {
+    TokenType type;
+    RedirectionOperator redirection; /* Operator of a TOKEN_REDIRECTION */
+    char *word;                     /* Unquoted value of a TOKEN_WORD, variables not expanded */
+    int io_number;                  /* fd written before a redirection operator, -1 if none */
+    size_t start;                   /* Offsets of the token in the line */
+    size_t end;
+} Token;
+
+/* State shared by the tokenizer and the parser */
+typedef struct {
+    Arena *arena;
+    const char *line;
+    size_t pos;
+    Token current;                  /* One token of look-ahead */
+    Redirection **here_document_tail;   /* Where the next here-document of the line is linked */
+} Parser;
+
+/*****************************        Tokenizer                  ********************************/
+
+static int is_operator_char(char c)
+{
+    return c == '|' || c == '&' || c == ';' || c == '<' || c == '>';
+}
+
+static int is_glob_char(char c)
+{
+    return c == '*' || c == '?' || c == '[';
+}
+
+/* Appends a quoted character to the word, and escaped to the glob pattern */
+static int append_quoted(StrBuf *word, StrBuf *pattern, char c)
+{
+    if ((is_glob_char(c) || c == '\\') && strbuf_putc(pattern, '\\') != S_EXIT_SUCCESS) {
+        return S_EXIT_MEM_ALLOC;
+    }
+    if (strbuf_putc(pattern, c) != S_EXIT_SUCCESS || strbuf_putc(word, c) != S_EXIT_SUCCESS) {
+        return S_EXIT_MEM_ALLOC;
+    }
+    return S_EXIT_SUCCESS;
+}
+
+/* Appends the value of the variable reference at src, or the reference as written without expand.
+ * The value is taken literally: it is never split into words nor used as a glob pattern. */
+static int append_reference(StrBuf *word, StrBuf *pattern, const char *src, int expand, size_t *consumed)
+{
+    size_t len = strlen(src);
+
+    if (!expand) {
+        *consumed = variable_reference_length(src, len);
+        if (strbuf_append(word, src, *consumed) != S_EXIT_SUCCESS ||
+            strbuf_append(pattern, src, *consumed) != S_EXIT_SUCCESS) {
+            return S_EXIT_MEM_ALLOC;
+        }
+        return S_EXIT_SUCCESS;
+    }
+
+    StrBuf value;
+    strbuf_init(&value, word->arena);
+    if (strbuf_append(&value, "", 0) != S_EXIT_SUCCESS ||
+        expand_variable_reference(&value, src, len, consumed) != S_EXIT_SUCCESS) {
+        return S_EXIT_MEM_ALLOC;
+    }
+    for (size_t i = 0; i < value.len; i++) {
+        if (append_quoted(word, pattern, value.data[i]) != S_EXIT_SUCCESS) {
+            return S_EXIT_MEM_ALLOC;
+        }
+    }
+    return S_EXIT_SUCCESS;
+}
+
+/* Reads the word starting at line[*pos], removing the quotes and escapes. With expand, a leading ~
+ * and the variable references outside single quotes are replaced by their value, otherwise they are
+ * kept as written. A glob pattern (with the quoted characters escaped) is kept in *pattern if the
+ * word has unquoted wildcards, and *empty is set when an unquoted word expanded to nothing. */
+static int scan_word(Arena *arena, const char *line, size_t *pos, int expand, char **word_out, char **pattern_out, int *empty)
+{
+    size_t i = *pos;
+    size_t consumed;
+    int has_glob = 0;
+    int quoted = 0;
+    int referenced = 0;
+    StrBuf word;
+    StrBuf pattern;
+    strbuf_init(&word, arena);
+    strbuf_init(&pattern, arena);
+
+    if (strbuf_append(&word, "", 0) != S_EXIT_SUCCESS || strbuf_append(&pattern, "", 0) != S_EXIT_SUCCESS) {
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    /* An unquoted ~ at the start of a word is the home directory */
+    const char *home = getenv("HOME");
+    if (expand && line[i] == '~' && home != NULL && (line[i + 1] == '/' || line[i + 1] == '\0' ||
+        isspace((unsigned char)line[i + 1]) || is_operator_char(line[i + 1]))) {
+        for (const char *c = home; *c != '\0'; c++) {
+            if (append_quoted(&word, &pattern, *c) != S_EXIT_SUCCESS) {
+                return S_EXIT_MEM_ALLOC;
+            }
+        }
+        i++;
+    }
+
+    while (line[i] != '\0' && !isspace((unsigned char)line[i]) && !is_operator_char(line[i])) {
+        if (line[i] == '\'') {
+            /* Everything up to the closing quote is literal */
+            const char *close = strchr(line + i + 1, '\'');
+            if (close == NULL) {
+                Write_syscall(STDERR, "Syntax error: unterminated quote\n", red);
+                return S_EXIT_INVALID_COMMAND;
+            }
+            for (i++; line + i < close; i++) {
+                if (append_quoted(&word, &pattern, line[i]) != S_EXIT_SUCCESS) {
+                    return S_EXIT_MEM_ALLOC;
+                }
+            }
+            i++;
+            quoted = 1;
+        } else if (line[i] == '"') {
+            i++;
+            while (line[i] != '\0' && line[i] != '"') {
+                if (line[i] == '$') {
+                    if (append_reference(&word, &pattern, line + i, expand, &consumed) != S_EXIT_SUCCESS) {
+                        return S_EXIT_MEM_ALLOC;
+                    }
+                    i += consumed;
+                    continue;
+                }
+                /* Inside double quotes a backslash only escapes " \ and $ */
+                if (line[i] == '\\' && (line[i + 1] == '"' || line[i + 1] == '\\' || line[i + 1] == '$')) {
+                    i++;
+                }
+                if (append_quoted(&word, &pattern, line[i]) != S_EXIT_SUCCESS) {
+                    return S_EXIT_MEM_ALLOC;
+                }
+                i++;
+            }
+            if (line[i] != '"') {
+                Write_syscall(STDERR, "Syntax error: unterminated quote\n", red);
+                return S_EXIT_INVALID_COMMAND;
+            }
+            i++;
+            quoted = 1;
+        } else if (line[i] == '\\' && line[i + 1] != '\0') {
+            if (append_quoted(&word, &pattern, line[i + 1]) != S_EXIT_SUCCESS) {
+                return S_EXIT_MEM_ALLOC;
+            }
+            i += 2;
+            quoted = 1;
+        } else if (line[i] == '$') {
+            if (append_reference(&word, &pattern, line + i, expand, &consumed) != S_EXIT_SUCCESS) {
+                return S_EXIT_MEM_ALLOC;
+            }
+            i += consumed;
+            referenced |= (consumed > 1);
+        } else {
+            has_glob |= is_glob_char(line[i]);
+            if (strbuf_putc(&word, line[i]) != S_EXIT_SUCCESS || strbuf_putc(&pattern, line[i]) != S_EXIT_SUCCESS) {
+                return S_EXIT_MEM_ALLOC;
+            }
+            i++;
+        }
+    }
+
+    *word_out = word.data;
+    *pattern_out = has_glob ? pattern.data : NULL;
+    *empty = (expand && referenced && !quoted && word.len == 0);
+    *pos = i;
+    return S_EXIT_SUCCESS;
+}
+
+/* Reads a word starting at parser->pos. The variables are not expanded yet, token->word is only
+ * used where the parser needs the text of a word (file descriptors, here-document delimiters). */
+static int read_word(Parser *parser, Token *token)
+{
+    char *pattern;
+    int empty;
+
+    token->type = TOKEN_WORD;
+    return scan_word(parser->arena, parser->line, &parser->pos, 0, &token->word, &pattern, &empty);
+}
+
+/* Reads the next token into parser->current */
+static void next_token(Parser *parser)
+{
+    const char *line = parser->line;
+    Token *token = &parser->current;
+
+    /* Skip the blanks and a comment up to the end of the line */
+    while (isspace((unsigned char)line[parser->pos])) {
+        parser->pos++;
+    }
+    if (line[parser->pos] == '#') {
+        parser->pos += strlen(line + parser->pos);
+    }
+
+    token->start = parser->pos;
+    token->word = NULL;
+    token->io_number = -1;
+
+    const char *p = line + parser->pos;
+
+    /* A number directly followed by '<' or '>' is the fd to redirect (e.g. 2>) */
+    size_t digits = 0;
+    while (isdigit((unsigned char)p[digits])) {
+        digits++;
+    }
+    if (digits > 0 && digits < 4 && (p[digits] == '<' || p[digits] == '>')) {
+        token->io_number = atoi(p);
+        p += digits;
+    }
+
+    /* Redirection operators, &> and &>> take no fd number */
+    for (size_t i = 0; i < sizeof(redirection_operators) / sizeof(redirection_operators[0]); i++) {
+        if (strncmp(p, redirection_operators[i].text, redirection_operators[i].len) == 0 &&
+            !(p[0] == '&' && token->io_number >= 0)) {
+            token->type = TOKEN_REDIRECTION;
+            token->redirection = redirection_operators[i].op;
+            parser->pos = p + redirection_operators[i].len - line;
+            token->end = parser->pos;
+            return;
+        }
+    }
+
+    if (*p == '\0') {
+        token->type = TOKEN_END;
+    } else if (p[0] == '|' && p[1] == '|') {
+        token->type = TOKEN_OR;
+        p += 2;
+    } else if (p[0] == '&' && p[1] == '&') {
+        token->type = TOKEN_AND;
+        p += 2;
+    } else if (p[0] == '|') {
+        token->type = TOKEN_PIPE;
+        p++;
+    } else if (p[0] == ';') {
+        token->type = TOKEN_SEMICOLON;
+        p++;
+    } else if (p[0] == '&') {
+        token->type = TOKEN_AMPERSAND;
+        p++;
+    } else {
+        if (read_word(parser, token) != S_EXIT_SUCCESS) {
+            token->type = TOKEN_ERROR;
+            return;
+        }
+        token->end = parser->pos;
+        return;
+    }
+
+    parser->pos = p - line;
+    token->end = parser->pos;
+}
+
+/*****************************        Parser                     ********************************/
+
+static void syntax_error(Parser *parser)
+{
+    if (parser->current.type == TOKEN_ERROR) {
+        return;                     /* The tokenizer already reported it */
+    }
+
+    char message[64];
+    if (parser->current.type == TOKEN_END) {
+        snprintf(message, sizeof(message), "Syntax error: unexpected end of line\n");
+    } else {
+        snprintf(message, sizeof(message), "Syntax error: unexpected token '%.*s'\n",
+                 (int)(parser->current.end - parser->current.start), parser->line + parser->current.start);
+    }
+    Write_syscall(STDERR, message, red);
+}
+
+/* Makes sure an arena array has room for needed elements, doubling its capacity when full */
+static void *reserve(Arena *arena, void *array, int needed, int *capacity, size_t elem_size)
+{
+    if (needed > *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 4;
+        while (new_capacity < needed) {
+            new_capacity *= 2;
+        }
+        array = arena_realloc(arena, array, *capacity * elem_size, new_capacity * elem_size);
+        if (array == NULL) {
+            return NULL;
+        }
+        *capacity = new_capacity;
+    }
+    return array;
+}
+
+/* Appends a word to the arguments, replaced by the matching file names if it is a glob pattern */
+static int add_word(Arena *arena, SimpleCommand *command, char *word, const char *pattern, int *capacity)
+{
+    glob_t matches;
+    size_t count = 1;
+    int globbed = (pattern != NULL && glob(pattern, 0, NULL, &matches) == 0);
+
+    if (globbed) {
+        count = matches.gl_pathc;
+    }
+
+    /* Keep one spare slot for the terminating NULL */
+    command->argv = reserve(arena, command->argv, command->argc + count + 1, capacity, sizeof(char *));
+    if (command->argv == NULL) {
+        if (globbed) {
+            globfree(&matches);
+        }
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    if (!globbed) {
+        /* Like sh, a pattern that matches nothing is passed unchanged */
+        command->argv[command->argc++] = word;
+        return S_EXIT_SUCCESS;
+    }
+
+    int ret = S_EXIT_SUCCESS;
+    for (size_t i = 0; i < matches.gl_pathc; i++) {
+        command->argv[command->argc] = arena_strndup(arena, matches.gl_pathv[i], strlen(matches.gl_pathv[i]));
+        if (command->argv[command->argc++] == NULL) {
+            ret = S_EXIT_MEM_ALLOC;
+            break;
+        }
+    }
+    globfree(&matches);
+    return ret;
+}
+
+/* The current word as it was written, expanded when its command runs */
+static char *raw_word(Parser *parser)
+{
+    const Token *token = &parser->current;
+    return arena_strndup(parser->arena, parser->line + token->start, token->end - token->start);
+}
+
+/* Allocates a redirection and links it at *tail */
+static Redirection *add_redirection(Parser *parser, Redirection ***tail, RedirectionType type, int fd)
+{
+    Redirection *redirection = arena_alloc(parser->arena, sizeof(Redirection));
+    if (redirection == NULL) {
+        return NULL;
+    }
+
+    memset(redirection, 0, sizeof(Redirection));
+    redirection->type = type;
+    redirection->fd = fd;
+    **tail = redirection;
+    *tail = &redirection->next;
+    return redirection;
+}
+
+/* redirection := [n] operator WORD, the word is the current token */
+static int parse_redirection(Parser *parser, Redirection ***tail, RedirectionOperator op, int io_number)
+{
+    const Token *word = &parser->current;
+    int input = (op == OP_LESS || op == OP_LESS_AND || op == OP_DLESS || op == OP_DLESS_DASH || op == OP_TLESS);
+    int fd = (io_number >= 0) ? io_number : (input ? STDIN : STDOUT);
+    Redirection *redirection;
+
+    switch (op) {
+    case OP_LESS:
+    case OP_GREAT:
+    case OP_DGREAT:
+        redirection = add_redirection(parser, tail, (op == OP_LESS) ? REDIR_INPUT
+                                                    : (op == OP_GREAT) ? REDIR_OUTPUT : REDIR_APPEND, fd);
+        if (redirection == NULL || (redirection->word = raw_word(parser)) == NULL) {
+            return S_EXIT_MEM_ALLOC;
+        }
+        return S_EXIT_SUCCESS;
+
+    case OP_LESS_AND:
+    case OP_GREAT_AND: {
+        char *end;
+        long target_fd = strtol(word->word, &end, 10);
+
+        if (strcmp(word->word, "-") == 0) {
+            return add_redirection(parser, tail, REDIR_CLOSE, fd) ? S_EXIT_SUCCESS : S_EXIT_MEM_ALLOC;
+        }
+        if (word->word[0] != '\0' && *end == '\0' && target_fd >= 0 && target_fd <= INT_MAX) {
+            redirection = add_redirection(parser, tail, REDIR_DUP, fd);
+            if (redirection == NULL) {
+                return S_EXIT_MEM_ALLOC;
+            }
+            redirection->target_fd = (int)target_fd;
+            return S_EXIT_SUCCESS;
+        }
+        if (op == OP_LESS_AND || io_number >= 0) {
+            console_printf(STDERR, red, "Syntax error: %s: file descriptor expected\n", word->word);
+            return S_EXIT_INVALID_COMMAND;
+        }
+        /* >& file is the same as &> file */
+    }
+    /* fall through */
+    case OP_AND_GREAT:
+    case OP_AND_DGREAT:
+        redirection = add_redirection(parser, tail, (op == OP_AND_DGREAT) ? REDIR_APPEND : REDIR_OUTPUT, STDOUT);
+        if (redirection == NULL || (redirection->word = raw_word(parser)) == NULL) {
+            return S_EXIT_MEM_ALLOC;
+        }
+        redirection = add_redirection(parser, tail, REDIR_DUP, STDERR);
+        if (redirection == NULL) {
+            return S_EXIT_MEM_ALLOC;
+        }
+        redirection->target_fd = STDOUT;
+        return S_EXIT_SUCCESS;
+
+    case OP_DLESS:
+    case OP_DLESS_DASH: {
+        redirection = add_redirection(parser, tail, REDIR_HERE_DOCUMENT, fd);
+        if (redirection == NULL) {
+            return S_EXIT_MEM_ALLOC;
+        }
+        /* Any quote or backslash in the delimiter disables the expansion of the body */
+        size_t len = word->end - word->start;
+        const char *raw = parser->line + word->start;
+        redirection->target = word->word;
+        redirection->quoted = (memchr(raw, '\'', len) || memchr(raw, '"', len) || memchr(raw, '\\', len));
+        redirection->strip_tabs = (op == OP_DLESS_DASH);
+
+        /* The body comes from the next lines, read once the whole line is parsed */
+        *parser->here_document_tail = redirection;
+        parser->here_document_tail = &redirection->next_here_document;
+        return S_EXIT_SUCCESS;
+    }
+
+    case OP_TLESS: {
+        redirection = add_redirection(parser, tail, REDIR_HERE_STRING, fd);
+        if (redirection == NULL || (redirection->word = raw_word(parser)) == NULL) {
+            return S_EXIT_MEM_ALLOC;
+        }
+        return S_EXIT_SUCCESS;
+    }
+    }
+
+    return S_EXIT_INVALID_COMMAND;
+}
+
+/* command := (WORD | redirection)+ */
+static int parse_command(Parser *parser, SimpleCommand *command)
+{
+    int capacity = 0;
+    size_t start = parser->current.start;
+    size_t end = start;
+    Redirection **tail = &command->redirections;
+
+    command->words = NULL;
+    command->word_count = 0;
+    command->argv = NULL;
+    command->argc = 0;
+    command->redirections = NULL;
+
+    while (1) {
+        Token *token = &parser->current;
+
+        if (token->type == TOKEN_WORD) {
+            command->words = reserve(parser->arena, command->words, command->word_count + 1, &capacity, sizeof(char *));
+            if (command->words == NULL || (command->words[command->word_count++] = raw_word(parser)) == NULL) {
+                return S_EXIT_MEM_ALLOC;
+            }
+            end = token->end;
+            next_token(parser);
+        } else if (token->type == TOKEN_REDIRECTION) {
+            RedirectionOperator op = token->redirection;
+            int io_number = token->io_number;
+
+            next_token(parser);
+            if (parser->current.type != TOKEN_WORD) {
+                syntax_error(parser);
+                return S_EXIT_INVALID_COMMAND;
+            }
+            int ret = parse_redirection(parser, &tail, op, io_number);
+            if (ret != S_EXIT_SUCCESS) {
+                return ret;
+            }
+            end = parser->current.end;
+            next_token(parser);
+        } else {
+            break;
+        }
+    }
+
+    if (command->word_count == 0) {
+        syntax_error(parser);
+        return S_EXIT_INVALID_COMMAND;
+    }
+
+    command->text = arena_strndup(parser->arena, parser->line + start, end - start);
+    return command->text ? S_EXIT_SUCCESS : S_EXIT_MEM_ALLOC;
+}
+
+/* pipeline := command ('|' command)* */
+static int parse_pipeline(Parser *parser, Pipeline *pipeline)
+{
+    int capacity = 0;
+    size_t start = parser->current.start;
+    int ret;
+
+    pipeline->commands = NULL;
+    pipeline->num_commands = 0;
+    pipeline->background = 0;
+
+    while (1) {
+        pipeline->commands = reserve(parser->arena, pipeline->commands, pipeline->num_commands + 1,
+                                     &capacity, sizeof(SimpleCommand));
+        if (pipeline->commands == NULL) {
+            return S_EXIT_MEM_ALLOC;
+        }
+
+        ret = parse_command(parser, &pipeline->commands[pipeline->num_commands++]);
+        if (ret != S_EXIT_SUCCESS) {
+            return ret;
+        }
+
+        if (parser->current.type != TOKEN_PIPE) {
+            break;
+        }
+        next_token(parser);
+    }
+
+    /* The pipeline ends where the token that stopped it begins (without trailing blanks) */
+    size_t stop = parser->current.start;
+    while (stop > start && isspace((unsigned char)parser->line[stop - 1])) {
+        stop--;
+    }
+    pipeline->text = arena_strndup(parser->arena, parser->line + start, stop - start);
+    return pipeline->text ? S_EXIT_SUCCESS : S_EXIT_MEM_ALLOC;
+}
+
+/* list := pipeline (('&&' | '||' | ';' | '&') pipeline)* [';' | '&'] */
+static int parse_list(Parser *parser, CommandList *list)
+{
+    int capacity = 0;
+    ListOperator op = LIST_SEQUENCE;
+    int ret;
+
+    while (parser->current.type != TOKEN_END) {
+        if (parser->current.type != TOKEN_WORD && parser->current.type != TOKEN_REDIRECTION) {
+            syntax_error(parser);
+            return S_EXIT_INVALID_COMMAND;
+        }
+
+        list->items = reserve(parser->arena, list->items, list->count + 1, &capacity, sizeof(ListItem));
+        if (list->items == NULL) {
+            return S_EXIT_MEM_ALLOC;
+        }
+
+        ListItem *item = &list->items[list->count++];
+        item->op = op;
+        ret = parse_pipeline(parser, &item->pipeline);
+        if (ret != S_EXIT_SUCCESS) {
+            return ret;
+        }
+
+        if (parser->current.type == TOKEN_AND) {
+            op = LIST_AND;
+        } else if (parser->current.type == TOKEN_OR) {
+            op = LIST_OR;
+        } else if (parser->current.type == TOKEN_SEMICOLON) {
+            op = LIST_SEQUENCE;
+        } else if (parser->current.type == TOKEN_AMPERSAND) {
+            item->pipeline.background = 1;      /* Only the pipeline before '&' runs in the background */
+            op = LIST_SEQUENCE;
+        } else if (parser->current.type == TOKEN_END) {
+            break;
+        } else {
+            syntax_error(parser);
+            return S_EXIT_INVALID_COMMAND;
+        }
+        next_token(parser);
+
+        /* '&&' and '||' must be followed by a pipeline, a trailing ';' or '&' is allowed */
+        if (op != LIST_SEQUENCE && parser->current.type == TOKEN_END) {
+            syntax_error(parser);
+            return S_EXIT_INVALID_COMMAND;
+        }
+    }
+
+    return S_EXIT_SUCCESS;
+}
+
+/*****************************        Public Functions           ********************************/
+
+CommandList *Parse_Command_Line(Arena *arena, const char *line)
+{
+    Parser parser = { .arena = arena, .line = line, .pos = 0 };
+
+    CommandList *list = arena_alloc(arena, sizeof(CommandList));
+    if (list == NULL) {
+        perror("Failed to allocate memory");
+        return NULL;
+    }
+    list->arena = arena;
+    list->items = NULL;
+    list->count = 0;
+    list->here_documents = NULL;
+    parser.here_document_tail = &list->here_documents;
+
+    next_token(&parser);
+    int ret = parse_list(&parser, list);
+    if (ret == S_EXIT_MEM_ALLOC) {
+        perror("Failed to allocate memory");
+    }
+
+    return (ret == S_EXIT_SUCCESS) ? list : NULL;
+}
+
+int Read_Here_Documents(Arena *arena, CommandList *list, NextLineFunction next_line, void *context)
+{
+    for (Redirection *document = list->here_documents; document != NULL; document = document->next_here_document) {
+        StrBuf body;
+        strbuf_init(&body, arena);
+        if (strbuf_append(&body, "", 0) != S_EXIT_SUCCESS) {
+            return S_EXIT_MEM_ALLOC;
+        }
+
+        char *line;
+        while (1) {
+            line = next_line(context);
+            if (line == NULL) {
+                console_printf(STDERR, red, "Warning: here-document ended before its delimiter '%s'\n", document->target);
+                break;
+            }
+            if (document->strip_tabs) {
+                line += strspn(line, "\t");
+            }
+            if (strcmp(line, document->target) == 0) {
+                break;
+            }
+
+            if (strbuf_append(&body, line, strlen(line)) != S_EXIT_SUCCESS ||
+                strbuf_putc(&body, '\n') != S_EXIT_SUCCESS) {
+                return S_EXIT_MEM_ALLOC;
+            }
+        }
+
+        document->body = body.data;
+    }
+
+    return S_EXIT_SUCCESS;
+}
+
+/* Expands one word, *word is set to NULL when the word is dropped */
+static int expand_word(Arena *arena, const char *raw, char **word, char **pattern)
+{
+    size_t pos = 0;
+    int empty;
+
+    /* The word was checked by the parser, only the allocations can fail */
+    if (scan_word(arena, raw, &pos, 1, word, pattern, &empty) != S_EXIT_SUCCESS) {
+        return S_EXIT_MEM_ALLOC;
+    }
+    if (empty) {
+        *word = NULL;
+    }
+    return S_EXIT_SUCCESS;
+}
+
+/* Expands the variables of a here-document body line by line, like the lines of commands */
+static const char *expand_here_document(Arena *arena, const char *body)
+{
+    StrBuf out;
+    strbuf_init(&out, arena);
+    if (strbuf_append(&out, "", 0) != S_EXIT_SUCCESS) {
+        return NULL;
+    }
+
+    while (*body != '\0') {
+        size_t len = strcspn(body, "\n");
+        char *line = arena_strndup(arena, body, len);
+        char *text = line ? substitute_variables(arena, line) : NULL;
+        if (text == NULL || strbuf_append(&out, text, strlen(text)) != S_EXIT_SUCCESS ||
+            strbuf_putc(&out, '\n') != S_EXIT_SUCCESS) {
+            return NULL;
+        }
+        body += len + (body[len] == '\n');
+    }
+
+    return out.data;
+}
+
+static int expand_redirection(Arena *arena, Redirection *redirection)
+{
+    char *word;
+    char *pattern;
+
+    if (redirection->type == REDIR_HERE_DOCUMENT) {
+        if (!redirection->quoted && redirection->body != NULL) {
+            redirection->body = expand_here_document(arena, redirection->body);
+            return redirection->body ? S_EXIT_SUCCESS : S_EXIT_MEM_ALLOC;
+        }
+        return S_EXIT_SUCCESS;
+    }
+
+    if (redirection->word == NULL) {
+        return S_EXIT_SUCCESS;      /* >&m and >&- have nothing to expand */
+    }
+    if (expand_word(arena, redirection->word, &word, &pattern) != S_EXIT_SUCCESS) {
+        return S_EXIT_MEM_ALLOC;
+    }
+    if (word == NULL) {
+        word = "";
+    }
+
+    if (redirection->type != REDIR_HERE_STRING) {
+        redirection->target = word;
+        return S_EXIT_SUCCESS;
+    }
+
+    /* A here-string is the word followed by a newline */
+    size_t len = strlen(word);
+    char *body = arena_alloc(arena, len + 2);
+    if (body == NULL) {
+        return S_EXIT_MEM_ALLOC;
+    }
+    memcpy(body, word, len);
+    memcpy(body + len, "\n", 2);
+    redirection->body = body;
+    return S_EXIT_SUCCESS;
+}
+
+int Expand_Pipeline(Arena *arena, Pipeline *pipeline)
+{
+    for (int i = 0; i < pipeline->num_commands; i++) {
+        SimpleCommand *command = &pipeline->commands[i];
+        int capacity = 0;
+
+        command->argv = NULL;
+        command->argc = 0;
+        for (int w = 0; w < command->word_count; w++) {
+            char *word;
+            char *pattern;
+            if (expand_word(arena, command->words[w], &word, &pattern) != S_EXIT_SUCCESS ||
+                (word != NULL && add_word(arena, command, word, pattern, &capacity) != S_EXIT_SUCCESS)) {
+                return S_EXIT_MEM_ALLOC;
+            }
+        }
+
+        /* Room for the terminating NULL (and a stage name) when every word was dropped */
+        command->argv = reserve(arena, command->argv, command->argc + 2, &capacity, sizeof(char *));
+        if (command->argv == NULL) {
+            return S_EXIT_MEM_ALLOC;
+        }
+        /* A lone command without words does nothing, a pipeline stage still needs a name to run */
+        if (command->argc == 0 && pipeline->num_commands > 1) {
+            command->argv[command->argc++] = "";
+        }
+        command->argv[command->argc] = NULL;
+
+        for (Redirection *redirection = command->redirections; redirection != NULL; redirection = redirection->next) {
+            if (expand_redirection(arena, redirection) != S_EXIT_SUCCESS) {
+                return S_EXIT_MEM_ALLOC;
+            }
+        }
+    }
+
+    return S_EXIT_SUCCESS;
+}
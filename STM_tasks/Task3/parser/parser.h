@@ -0,0 +1,137 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        parser.h               *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef PARSER_H
+#define PARSER_H
+
+#include "../arena/arena.h"
+
+/* Kind of a redirection operator */
+typedef enum {
+    REDIR_INPUT,                    /* [n]<  file  */
+    REDIR_OUTPUT,                   /* [n]>  file  */
+    REDIR_APPEND,                   /* [n]>> file  */
+    REDIR_DUP,                      /* [n]>&m or [n]<&m : fd becomes a copy of m */
+    REDIR_CLOSE,                    /* [n]>&- or [n]<&- */
+    REDIR_HERE_DOCUMENT,            /* [n]<<WORD, the body is read from the next lines */
+    REDIR_HERE_STRING               /* [n]<<< word */
+} RedirectionType;
+
+/* One redirection of a command, in the order they were written.
+ * &> file and &>> file are stored as two redirections: 1> file (or 1>> file) then 2>&1. */
+typedef struct Redirection {
+    RedirectionType type;
+    int fd;                         /* File descriptor being redirected */
+    const char *word;               /* File name or here-string as written, expanded by Expand_Pipeline() */
+    const char *target;             /* Expanded file name, or delimiter of a here-document */
+    int target_fd;                  /* REDIR_DUP: descriptor copied to fd */
+    const char *body;               /* Text of a here-document or here-string (expanded by Expand_Pipeline()) */
+    int quoted;                     /* Here-document delimiter was quoted: body is not expanded */
+    int strip_tabs;                 /* <<- : leading tabs are removed from the body lines */
+    struct Redirection *next;
+    struct Redirection *next_here_document;     /* Next here-document of the line */
+} Redirection;
+
+/* A command with its arguments, e.g. `ls -l > out.txt` */
+typedef struct {
+    char **words;                   /* Words as written, with their quotes */
+    int word_count;
+    char **argv;                    /* NULL terminated array of expanded words, set by Expand_Pipeline() */
+    int argc;
+    Redirection *redirections;      /* NULL if the command has no redirection */
+    const char *text;               /* Source text of the command (used for history) */
+} SimpleCommand;
+
+/* Commands connected with '|' */
+typedef struct {
+    SimpleCommand *commands;
+    int num_commands;
+    int background;                 /* Followed by '&': started without waiting for it */
+    const char *text;               /* Source text of the whole pipeline */
+} Pipeline;
+
+/* How a pipeline is connected to the one before it */
+typedef enum {
+    LIST_SEQUENCE,                  /* First pipeline or after ';' : always run */
+    LIST_AND,                       /* After '&&' : run if the previous one succeeded */
+    LIST_OR                         /* After '||' : run if the previous one failed */
+} ListOperator;
+
+typedef struct {
+    Pipeline pipeline;
+    ListOperator op;
+} ListItem;
+
+/* The AST of a whole command line */
+typedef struct {
+    Arena *arena;                   /* Owns the tree and the expanded words */
+    ListItem *items;
+    int count;
+    Redirection *here_documents;    /* Here-documents waiting for their body, in order */
+} CommandList;
+
+/* Returns the next line of the input (without newline), or NULL at its end */
+typedef char *(*NextLineFunction)(void *context);
+
+/**
+ * @brief Tokenizes and parses a command line into a CommandList in a single pass.
+ *
+ * Words may be quoted with '...' (literal), "..." (backslash escapes \" \\ \$) or escaped
+ * with a backslash; '#' starts a comment. The words are kept as written, they are only
+ * expanded by Expand_Pipeline() when their command is about to run, so a value never
+ * adds operators or words to the line.
+ * Supported operators are '|', '&&', '||', ';', '&' (run the pipeline before it in the
+ * background) and the redirections '<', '>', '>>', '<&', '>&' (e.g. 2>&1, 3<&-), '&>',
+ * '&>>', '<<' / '<<-' (here-document) and '<<<' (here-string), with an optional file
+ * descriptor number before them (e.g. 2>). Every node of the tree,
+ * including the words, is allocated from arena, so the whole line is released with
+ * arena_reset() and the input string is never modified.
+ *
+ * @param arena Arena that owns the returned tree.
+ * @param line The command line to parse.
+ * @return CommandList* The parsed line (count is 0 for an empty line), or NULL on a
+ *         syntax error (a message is printed to STDERR) or allocation failure.
+ */
+CommandList *Parse_Command_Line(Arena *arena, const char *line);
+
+/**
+ * @brief Reads the bodies of the here-documents of a parsed line from the following lines.
+ *
+ * Each body ends at a line equal to its delimiter. With <<- the leading tabs are removed,
+ * the variables are expanded later by Expand_Pipeline().
+ *
+ * @param arena Arena of the line, it owns the bodies.
+ * @param list The parsed line.
+ * @param next_line Reads the next line of the input the command line came from.
+ * @param context Passed to next_line.
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_MEM_ALLOC. A missing delimiter only prints a warning.
+ */
+int Read_Here_Documents(Arena *arena, CommandList *list, NextLineFunction next_line, void *context);
+
+/**
+ * @brief Expands the words of a pipeline right before it runs.
+ *
+ * Each word gets its quotes removed, a leading unquoted ~ replaced by $HOME and its
+ * variable references outside single quotes replaced by their value. Values are taken
+ * literally: they are not split into words nor matched against file names, and an
+ * unquoted word that expands to nothing is dropped. Words with unquoted wildcards
+ * (* ? [) are then replaced by the matching file names. File names and here-strings of
+ * the redirections are expanded the same way (without wildcards), and so are the
+ * variables in the body of a here-document whose delimiter was not quoted. A command
+ * that is left without words has argc 0 (an empty name in a pipeline of several commands).
+ *
+ * @param arena Arena of the line, it owns argv and the expanded text.
+ * @param pipeline The pipeline to expand, its commands get their argv and argc.
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_MEM_ALLOC.
+ */
+int Expand_Pipeline(Arena *arena, Pipeline *pipeline);
+
+#endif
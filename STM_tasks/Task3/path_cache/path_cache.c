@@ -0,0 +1,230 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        path_cache.c           *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "path_cache.h"
+#include "../helper_functions/helpers.h"
+#include "../exit_status.h"
+
+/*****************************            Types                  ********************************/
+
+/* One slot of the open-addressing table. An empty slot has name == NULL. */
+typedef struct {
+    char *name;
+    char *path;                     /* NULL when the entry became stale */
+    size_t dir_len;                 /* Length of the directory part of path */
+    struct timespec dir_mtime;      /* Modification time of the directory when path was cached */
+    uint32_t hash;
+    unsigned long hits;
+} PathEntry;
+
+/*****************************        Global Variables           ********************************/
+
+static PathEntry *table = NULL;
+static size_t table_size = 0;       /* Number of slots (power of 2) */
+static size_t table_count = 0;      /* Number of used slots */
+static char *cached_path_env = NULL;/* Value of PATH the entries were resolved with */
+
+/*****************************        Static Functions           ********************************/
+
+/* FNV-1a hash of a command name */
+static uint32_t hash_name(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    for (; *name != '\0'; name++) {
+        hash ^= (unsigned char)*name;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* Returns the slot holding name, or the empty slot where it should be inserted */
+static PathEntry *find_slot(PathEntry *slots, size_t size, const char *name, uint32_t hash)
+{
+    size_t mask = size - 1;
+    size_t i = hash & mask;
+
+    while (slots[i].name != NULL) {
+        if (slots[i].hash == hash && strcmp(slots[i].name, name) == 0) {
+            return &slots[i];
+        }
+        i = (i + 1) & mask;         /* Linear probing */
+    }
+    return &slots[i];
+}
+
+static int grow_table(void)
+{
+    size_t new_size = table_size ? table_size * 2 : PATH_CACHE_INITIAL_SIZE;
+    PathEntry *new_table = calloc(new_size, sizeof(PathEntry));
+    if (new_table == NULL) {
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    for (size_t i = 0; i < table_size; i++) {
+        if (table[i].name != NULL) {
+            *find_slot(new_table, new_size, table[i].name, table[i].hash) = table[i];
+        }
+    }
+
+    free(table);
+    table = new_table;
+    table_size = new_size;
+    return S_EXIT_SUCCESS;
+}
+
+/* Drops the whole cache if PATH is not the one the entries were resolved with */
+static void check_path_env(void)
+{
+    const char *path_env = getenv("PATH");
+    if (path_env == NULL) {
+        path_env = "";
+    }
+
+    if (cached_path_env != NULL && strcmp(cached_path_env, path_env) == 0) {
+        return;
+    }
+
+    path_cache_clear();
+    free(cached_path_env);
+    cached_path_env = strdup(path_env);
+}
+
+static int get_dir_mtime(const char *path, size_t dir_len, struct timespec *mtime)
+{
+    char dir[BUFFER_SIZE];
+    struct stat dir_stat;
+
+    if (dir_len == 0) {
+        snprintf(dir, sizeof(dir), "/");
+    } else {
+        snprintf(dir, sizeof(dir), "%.*s", (int)dir_len, path);
+    }
+
+    if (stat(dir, &dir_stat) < 0) {
+        return S_EXIT_FILE_NOT_FOUND;
+    }
+    *mtime = dir_stat.st_mtim;
+    return S_EXIT_SUCCESS;
+}
+
+/*****************************        Public Functions           ********************************/
+
+int path_cache_lookup(const char *command, char *full_path, size_t size)
+{
+    struct timespec mtime;
+
+    check_path_env();
+    if (table == NULL) {
+        return S_EXIT_FAILURE;
+    }
+
+    PathEntry *entry = find_slot(table, table_size, command, hash_name(command));
+    if (entry->name == NULL || entry->path == NULL) {
+        return S_EXIT_FAILURE;
+    }
+
+    /* A changed directory may no longer hold the same program */
+    if (get_dir_mtime(entry->path, entry->dir_len, &mtime) != S_EXIT_SUCCESS ||
+        mtime.tv_sec != entry->dir_mtime.tv_sec || mtime.tv_nsec != entry->dir_mtime.tv_nsec) {
+        free(entry->path);
+        entry->path = NULL;
+        return S_EXIT_FAILURE;
+    }
+
+    entry->hits++;
+    snprintf(full_path, size, "%s", entry->path);
+    return S_EXIT_SUCCESS;
+}
+
+void path_cache_insert(const char *command, const char *full_path)
+{
+    struct timespec mtime;
+    const char *slash = strrchr(full_path, '/');
+    size_t dir_len = slash ? (size_t)(slash - full_path) : 0;
+
+    check_path_env();
+    if (get_dir_mtime(full_path, dir_len, &mtime) != S_EXIT_SUCCESS) {
+        return;
+    }
+
+    /* Keep the load factor under 1/2 so probe sequences stay short */
+    if ((table_count + 1) * 2 > table_size && grow_table() != S_EXIT_SUCCESS) {
+        return;
+    }
+
+    uint32_t hash = hash_name(command);
+    PathEntry *entry = find_slot(table, table_size, command, hash);
+
+    char *path = strdup(full_path);
+    if (path == NULL) {
+        return;
+    }
+
+    if (entry->name == NULL) {
+        entry->name = strdup(command);
+        if (entry->name == NULL) {
+            free(path);
+            return;
+        }
+        entry->hash = hash;
+        entry->hits = 0;
+        table_count++;
+    }
+
+    free(entry->path);
+    entry->path = path;
+    entry->dir_len = dir_len;
+    entry->dir_mtime = mtime;
+    entry->hits++;
+}
+
+void path_cache_clear(void)
+{
+    for (size_t i = 0; i < table_size; i++) {
+        free(table[i].name);
+        free(table[i].path);
+    }
+    free(table);
+
+    table = NULL;
+    table_size = 0;
+    table_count = 0;
+}
+
+void path_cache_print(void)
+{
+    char line[BUFFER_SIZE];
+    int printed = 0;
+
+    for (size_t i = 0; i < table_size; i++) {
+        if (table[i].name == NULL || table[i].path == NULL) {
+            continue;
+        }
+        if (printed++ == 0) {
+            Write_syscall(STDOUT, "hits\tcommand\n", blue);
+        }
+        snprintf(line, sizeof(line), "%4lu\t%s\n", table[i].hits, table[i].path);
+        Write_syscall(STDOUT, line, green);
+    }
+
+    if (printed == 0) {
+        Write_syscall(STDOUT, "shash: hash table empty\n", blue);
+    }
+}
@@ -0,0 +1,52 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        path_cache.h           *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef PATH_CACHE_H
+#define PATH_CACHE_H
+
+#include <stddef.h>
+
+/* Initial number of slots in the command path table (must be a power of 2) */
+#define PATH_CACHE_INITIAL_SIZE     64
+
+/**
+ * @brief Looks up the cached location of a command.
+ *
+ * The whole cache is dropped when PATH changed since the entry was stored, and the entry
+ * is dropped when the modification time of its directory changed (program added, removed
+ * or replaced).
+ *
+ * @param command The command name.
+ * @param full_path Buffer to store the path of the executable.
+ * @param size Size of full_path.
+ * @return int Returns S_EXIT_SUCCESS on a valid hit, otherwise S_EXIT_FAILURE.
+ */
+int path_cache_lookup(const char *command, char *full_path, size_t size);
+
+/**
+ * @brief Remembers where a command was found.
+ *
+ * @param command The command name.
+ * @param full_path Path of the executable, it must be inside one of the PATH directories.
+ */
+void path_cache_insert(const char *command, const char *full_path);
+
+/**
+ * @brief Forgets all the cached locations.
+ */
+void path_cache_clear(void);
+
+/**
+ * @brief Prints the cached commands with their number of hits and paths.
+ */
+void path_cache_print(void);
+
+#endif
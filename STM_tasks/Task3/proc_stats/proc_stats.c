@@ -0,0 +1,392 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        proc_stats.c           *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "proc_stats.h"
+#include "../exit_status.h"
+
+/*****************************            Types                  ********************************/
+
+/* Record returned by getdents64() */
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+typedef enum {
+    PROC_MEMINFO,
+    PROC_UPTIME,
+    PROC_STAT,
+    PROC_FILE_COUNT
+} ProcFile;
+
+/*****************************        Global Variables           ********************************/
+
+static const char *proc_paths[PROC_FILE_COUNT] = { "/proc/meminfo", "/proc/uptime", "/proc/stat" };
+static int proc_fds[PROC_FILE_COUNT] = { -1, -1, -1 };
+static int proc_dir_fd = -1;
+
+/* Lines of /proc/meminfo stored in MemoryStats, the others are skipped */
+static const struct {
+    const char *name;
+    size_t offset;
+} memory_fields[] = {
+    { "MemTotal",     offsetof(MemoryStats, total) },
+    { "MemFree",      offsetof(MemoryStats, free) },
+    { "MemAvailable", offsetof(MemoryStats, available) },
+    { "Buffers",      offsetof(MemoryStats, buffers) },
+    { "Cached",       offsetof(MemoryStats, cached) },
+    { "SReclaimable", offsetof(MemoryStats, reclaimable) },
+    { "Shmem",        offsetof(MemoryStats, shared) },
+    { "SwapTotal",    offsetof(MemoryStats, swap_total) },
+    { "SwapFree",     offsetof(MemoryStats, swap_free) },
+};
+
+/*****************************        Static Functions           ********************************/
+
+/* Reads a procfs file from its beginning into buffer (null-terminated), opening it only once */
+static int read_proc_file(ProcFile file, char *buffer, size_t size)
+{
+    if (proc_fds[file] < 0) {
+        proc_fds[file] = open(proc_paths[file], O_RDONLY | O_CLOEXEC);
+        if (proc_fds[file] < 0) {
+            perror(proc_paths[file]);
+            return S_EXIT_OPEN_FILE_FAILED;
+        }
+    }
+
+    /* procfs generates the content again on every read at offset 0 */
+    ssize_t bytes_read = pread(proc_fds[file], buffer, size - 1, 0);
+    if (bytes_read < 0) {
+        perror(proc_paths[file]);
+        return S_EXIT_READ_FILE_FAIL;
+    }
+
+    buffer[bytes_read] = '\0';
+    return S_EXIT_SUCCESS;
+}
+
+/* Reads the next unsigned number of a stat line, *cursor is moved after it */
+static unsigned long long scan_number(const char **cursor)
+{
+    const char *p = *cursor;
+    unsigned long long value = 0;
+
+    while (*p == ' ') {
+        p++;
+    }
+    if (*p == '-') {
+        p++;                                /* Only tpgid can be negative, it is not used */
+    }
+    while (*p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+
+    *cursor = p;
+    return value;
+}
+
+/* Skips count space-separated fields */
+static void skip_fields(const char **cursor, int count)
+{
+    const char *p = *cursor;
+
+    while (count-- > 0) {
+        while (*p == ' ') {
+            p++;
+        }
+        while (*p != ' ' && *p != '\0') {
+            p++;
+        }
+    }
+    *cursor = p;
+}
+
+/*
+ * Parses "pid (comm) state ppid pgrp session tty_nr tpgid flags minflt cminflt majflt cmajflt
+ * utime stime cutime cstime priority nice num_threads itrealvalue starttime vsize rss ...".
+ * comm may contain spaces and parentheses, so it ends at the last ')'.
+ */
+static int parse_process_stat(const char *line, ProcessStats *process)
+{
+    const char *open = strchr(line, '(');
+    const char *close = strrchr(line, ')');
+    if (open == NULL || close == NULL || close < open || close[1] == '\0') {
+        return S_EXIT_READ_FILE_FAIL;
+    }
+
+    size_t len = close - open - 1;
+    if (len >= sizeof(process->name)) {
+        len = sizeof(process->name) - 1;
+    }
+    memcpy(process->name, open + 1, len);
+    process->name[len] = '\0';
+
+    const char *cursor = close + 2;
+    process->state = *cursor++;
+    skip_fields(&cursor, 3);                /* ppid pgrp session */
+    process->tty = (int)scan_number(&cursor);
+    skip_fields(&cursor, 6);                /* tpgid flags minflt cminflt majflt cmajflt */
+    process->cpu_ticks = scan_number(&cursor);
+    process->cpu_ticks += scan_number(&cursor);
+    skip_fields(&cursor, 7);                /* cutime cstime priority nice num_threads itrealvalue starttime */
+    skip_fields(&cursor, 1);                /* vsize */
+    process->rss_pages = scan_number(&cursor);
+    return S_EXIT_SUCCESS;
+}
+
+/* Reads /proc/PID/stat through the open /proc descriptor, S_EXIT_FILE_NOT_FOUND if it exited */
+static int read_process(pid_t pid, char *buffer, size_t size, ProcessStats *process)
+{
+    char path[32];
+    snprintf(path, sizeof(path), "%d/stat", (int)pid);
+
+    int fd = openat(proc_dir_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return S_EXIT_FILE_NOT_FOUND;
+    }
+    ssize_t bytes_read = pread(fd, buffer, size - 1, 0);
+    close(fd);
+    if (bytes_read <= 0) {
+        return S_EXIT_FILE_NOT_FOUND;
+    }
+    buffer[bytes_read] = '\0';
+
+    process->pid = pid;
+    return parse_process_stat(buffer, process);
+}
+
+static int compare_pids(const void *a, const void *b)
+{
+    pid_t first = ((const ProcessStats *)a)->pid;
+    pid_t second = ((const ProcessStats *)b)->pid;
+    return (first > second) - (first < second);
+}
+
+/*****************************        Public Functions           ********************************/
+
+int proc_read_memory(MemoryStats *stats)
+{
+    char buffer[PROC_STATS_BUFFER_SIZE];
+    size_t num_fields = sizeof(memory_fields) / sizeof(memory_fields[0]);
+
+    int ret = read_proc_file(PROC_MEMINFO, buffer, sizeof(buffer));
+    if (ret != S_EXIT_SUCCESS) {
+        return ret;
+    }
+
+    /* "Name:   value kB" lines */
+    memset(stats, 0, sizeof(*stats));
+    for (char *line = buffer; *line != '\0'; ) {
+        char *colon = strchr(line, ':');
+        char *newline = strchr(line, '\n');
+        if (colon == NULL) {
+            break;
+        }
+
+        size_t len = colon - line;
+        for (size_t i = 0; i < num_fields; i++) {
+            if (strlen(memory_fields[i].name) == len && memcmp(line, memory_fields[i].name, len) == 0) {
+                *(unsigned long long *)((char *)stats + memory_fields[i].offset) = strtoull(colon + 1, NULL, 10);
+                break;
+            }
+        }
+
+        if (newline == NULL) {
+            break;
+        }
+        line = newline + 1;
+    }
+
+    /* Kernels older than 3.14 have no MemAvailable */
+    if (stats->available == 0) {
+        stats->available = stats->free + stats->buffers + stats->cached;
+    }
+    return S_EXIT_SUCCESS;
+}
+
+int proc_read_uptime(UptimeStats *stats)
+{
+    char buffer[128];
+
+    int ret = read_proc_file(PROC_UPTIME, buffer, sizeof(buffer));
+    if (ret != S_EXIT_SUCCESS) {
+        return ret;
+    }
+
+    if (sscanf(buffer, "%lf %lf", &stats->uptime, &stats->idle) != 2) {
+        fprintf(stderr, "Failed to parse /proc/uptime data\n");
+        return S_EXIT_READ_FILE_FAIL;
+    }
+    return S_EXIT_SUCCESS;
+}
+
+int proc_read_cpu(CpuStats *stats)
+{
+    char buffer[PROC_STATS_BUFFER_SIZE];
+
+    int ret = read_proc_file(PROC_STAT, buffer, sizeof(buffer));
+    if (ret != S_EXIT_SUCCESS) {
+        return ret;
+    }
+
+    /* Old kernels have fewer columns, the missing ones stay 0 */
+    memset(stats, 0, sizeof(*stats));
+    if (sscanf(buffer, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+               &stats->user, &stats->nice, &stats->system, &stats->idle,
+               &stats->iowait, &stats->irq, &stats->softirq, &stats->steal) < 4) {
+        fprintf(stderr, "Failed to parse /proc/stat data\n");
+        return S_EXIT_READ_FILE_FAIL;
+    }
+    return S_EXIT_SUCCESS;
+}
+
+int proc_read_processes(ProcessSnapshot *snapshot)
+{
+    static char dirents[PROC_DIRENTS_BUFFER_SIZE];
+    static char stat_buffer[PROC_STATS_BUFFER_SIZE];
+    long bytes_read;
+    int sorted = 1;
+
+    if (proc_dir_fd < 0) {
+        proc_dir_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (proc_dir_fd < 0) {
+            perror("/proc");
+            return S_EXIT_OPEN_FILE_FAILED;
+        }
+    }
+    if (lseek(proc_dir_fd, 0, SEEK_SET) < 0) {
+        perror("/proc");
+        return S_EXIT_READ_FILE_FAIL;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &snapshot->time);
+    snapshot->count = 0;
+
+    while ((bytes_read = syscall(SYS_getdents64, proc_dir_fd, dirents, sizeof(dirents))) > 0) {
+        for (long offset = 0; offset < bytes_read; ) {
+            struct linux_dirent64 *entry = (struct linux_dirent64 *)(dirents + offset);
+            offset += entry->d_reclen;
+
+            /* Only the numeric directories are processes */
+            const char *p = entry->d_name;
+            pid_t pid = 0;
+            while (*p >= '0' && *p <= '9') {
+                pid = pid * 10 + (*p++ - '0');
+            }
+            if (p == entry->d_name || *p != '\0') {
+                continue;
+            }
+
+            if (snapshot->count == snapshot->capacity) {
+                size_t new_capacity = snapshot->capacity ? snapshot->capacity * 2 : 256;
+                ProcessStats *processes = realloc(snapshot->processes, new_capacity * sizeof(ProcessStats));
+                if (processes == NULL) {
+                    return S_EXIT_MEM_ALLOC;
+                }
+                snapshot->processes = processes;
+                snapshot->capacity = new_capacity;
+            }
+
+            ProcessStats *process = &snapshot->processes[snapshot->count];
+            if (read_process(pid, stat_buffer, sizeof(stat_buffer), process) == S_EXIT_SUCCESS) {
+                if (snapshot->count > 0 && process[-1].pid > pid) {
+                    sorted = 0;
+                }
+                snapshot->count++;
+            }
+        }
+    }
+
+    if (bytes_read < 0) {
+        perror("getdents64");
+        return S_EXIT_READ_FILE_FAIL;
+    }
+
+    /* procfs lists the pids in order, sorting is only a safety net */
+    if (!sorted) {
+        qsort(snapshot->processes, snapshot->count, sizeof(ProcessStats), compare_pids);
+    }
+    return S_EXIT_SUCCESS;
+}
+
+const ProcessStats *proc_find_process(const ProcessSnapshot *snapshot, pid_t pid)
+{
+    ProcessStats key;
+    key.pid = pid;
+    return bsearch(&key, snapshot->processes, snapshot->count, sizeof(ProcessStats), compare_pids);
+}
+
+void proc_free_processes(ProcessSnapshot *snapshot)
+{
+    free(snapshot->processes);
+    snapshot->processes = NULL;
+    snapshot->count = snapshot->capacity = 0;
+}
+
+char *proc_format_tty(char *buffer, size_t size, int tty)
+{
+    unsigned int major = (tty >> 8) & 0xfff;
+    unsigned int minor = (tty & 0xff) | ((tty >> 12) & 0xfff00);
+
+    if (major >= 136 && major <= 143) {
+        snprintf(buffer, size, "pts/%u", minor + (major - 136) * 256);
+    } else if (major == 4 && minor < 64) {
+        snprintf(buffer, size, "tty%u", minor);
+    } else if (major == 4) {
+        snprintf(buffer, size, "ttyS%u", minor - 64);
+    } else {
+        snprintf(buffer, size, "?");
+    }
+    return buffer;
+}
+
+unsigned long long proc_cpu_total(const CpuStats *stats)
+{
+    return stats->user + stats->nice + stats->system + stats->idle +
+           stats->iowait + stats->irq + stats->softirq + stats->steal;
+}
+
+char *proc_format_size(char *buffer, size_t size, double kilobytes, int show_sign)
+{
+    static const char *units[] = { "Ki", "Mi", "Gi", "Ti", "Pi" };
+    const char *sign = (kilobytes < 0) ? "-" : (show_sign && kilobytes > 0) ? "+" : "";
+    double value = (kilobytes < 0) ? -kilobytes : kilobytes;
+    size_t unit = 0;
+
+    if (value < 0.5) {
+        snprintf(buffer, size, "0B");
+        return buffer;
+    }
+
+    while (value >= 1024 && unit < sizeof(units) / sizeof(units[0]) - 1) {
+        value /= 1024;
+        unit++;
+    }
+
+    snprintf(buffer, size, (value < 10 && unit > 0) ? "%s%.1f%s" : "%s%.0f%s", sign, value, units[unit]);
+    return buffer;
+}
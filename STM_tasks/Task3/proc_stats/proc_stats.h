@@ -0,0 +1,142 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        proc_stats.h           *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef PROC_STATS_H
+#define PROC_STATS_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <time.h>
+
+/* Size of the buffer each procfs file is read into (the first line of /proc/stat is enough) */
+#define PROC_STATS_BUFFER_SIZE      4096
+
+/* Bytes of /proc entries returned by each getdents64() call */
+#define PROC_DIRENTS_BUFFER_SIZE    (32 * 1024)
+
+/* Longest process name kept from /proc/PID/stat (the kernel limits comm to 15 characters) */
+#define PROC_NAME_MAX               64
+
+/* Fields of /proc/meminfo, in kB */
+typedef struct {
+    unsigned long long total;
+    unsigned long long free;
+    unsigned long long available;
+    unsigned long long buffers;
+    unsigned long long cached;
+    unsigned long long reclaimable;     /* SReclaimable, counted in buff/cache like free(1) does */
+    unsigned long long shared;
+    unsigned long long swap_total;
+    unsigned long long swap_free;
+} MemoryStats;
+
+/* /proc/uptime, in seconds (idle is summed over all the CPUs) */
+typedef struct {
+    double uptime;
+    double idle;
+} UptimeStats;
+
+/* The "cpu" line of /proc/stat, in clock ticks since boot */
+typedef struct {
+    unsigned long long user;
+    unsigned long long nice;
+    unsigned long long system;
+    unsigned long long idle;
+    unsigned long long iowait;
+    unsigned long long irq;
+    unsigned long long softirq;
+    unsigned long long steal;
+} CpuStats;
+
+/* One process from /proc/PID/stat */
+typedef struct {
+    pid_t pid;
+    char state;                         /* R, S, D, Z, T... */
+    char name[PROC_NAME_MAX];
+    int tty;                            /* tty_nr, 0 if none */
+    unsigned long long cpu_ticks;       /* utime + stime */
+    unsigned long long rss_pages;
+} ProcessStats;
+
+/* Every process at one moment, sorted by pid */
+typedef struct {
+    ProcessStats *processes;
+    size_t count;
+    size_t capacity;
+    struct timespec time;               /* CLOCK_MONOTONIC when the scan started */
+} ProcessSnapshot;
+
+/**
+ * @brief Reads /proc/meminfo.
+ *
+ * The procfs files stay open after the first call and are read again from offset 0 with
+ * pread, so a periodic refresh costs one system call per file.
+ *
+ * @param stats Filled with the current values.
+ * @return int Returns S_EXIT_SUCCESS, S_EXIT_OPEN_FILE_FAILED or S_EXIT_READ_FILE_FAIL.
+ */
+int proc_read_memory(MemoryStats *stats);
+
+/**
+ * @brief Reads /proc/uptime (see proc_read_memory()).
+ */
+int proc_read_uptime(UptimeStats *stats);
+
+/**
+ * @brief Reads the total CPU times of /proc/stat (see proc_read_memory()).
+ */
+int proc_read_cpu(CpuStats *stats);
+
+/**
+ * @brief Reads the stat file of every process.
+ *
+ * /proc is listed with getdents64 on a descriptor that stays open, and each stat file is
+ * read with one pread into a reused buffer. Processes that exit during the scan are skipped.
+ *
+ * @param snapshot Filled with the processes (its array is reused between calls).
+ * @return int Returns S_EXIT_SUCCESS, S_EXIT_OPEN_FILE_FAILED, S_EXIT_READ_FILE_FAIL or S_EXIT_MEM_ALLOC.
+ */
+int proc_read_processes(ProcessSnapshot *snapshot);
+
+/**
+ * @brief Finds a process of a snapshot.
+ *
+ * @return const ProcessStats* The process, or NULL if it was not running.
+ */
+const ProcessStats *proc_find_process(const ProcessSnapshot *snapshot, pid_t pid);
+
+/**
+ * @brief Frees the array of a snapshot.
+ */
+void proc_free_processes(ProcessSnapshot *snapshot);
+
+/**
+ * @brief Writes the name of a tty_nr ("pts/3", "tty1", "?").
+ */
+char *proc_format_tty(char *buffer, size_t size, int tty);
+
+/**
+ * @brief Returns the sum of all the CPU times.
+ */
+unsigned long long proc_cpu_total(const CpuStats *stats);
+
+/**
+ * @brief Formats an amount of kB like free -h does ("512Ki", "3.2Gi", "0B").
+ *
+ * @param buffer Receives the text.
+ * @param size Size of buffer.
+ * @param kilobytes The amount, negative values get a '-'.
+ * @param show_sign 1 to print '+' before positive values.
+ * @return char* buffer.
+ */
+char *proc_format_size(char *buffer, size_t size, double kilobytes, int show_sign);
+
+#endif
@@ -0,0 +1,352 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        prompt.c               *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pwd.h>
+#include <sys/types.h>
+
+#include "prompt.h"
+#include "../helper_functions/helpers.h"
+#include "../variables/variables.h"
+#include "../exit_status.h"
+
+/*****************************            Types                  ********************************/
+
+typedef enum {
+    SEGMENT_TEXT,                   /* Literal text */
+    SEGMENT_COLOR,                  /* Escape sequence, only printed on a terminal */
+    SEGMENT_USER,                   /* \u */
+    SEGMENT_HOST,                   /* \h */
+    SEGMENT_FULL_HOST,              /* \H */
+    SEGMENT_CWD,                    /* \w */
+    SEGMENT_CWD_BASE,               /* \W */
+    SEGMENT_PROMPT_CHAR             /* \$ */
+} SegmentType;
+
+typedef struct {
+    SegmentType type;
+    char *text;                     /* SEGMENT_TEXT and SEGMENT_COLOR only */
+    size_t len;
+} PromptSegment;
+
+/* Growable string of the rendered prompt */
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} PromptBuffer;
+
+/*****************************        Global Variables           ********************************/
+
+static char *format = NULL;                 /* Source of the compiled segments */
+static PromptSegment *segments = NULL;
+static int num_segments = 0;
+static int needs_user = 0;                  /* What the segments use, nothing else is checked */
+static int needs_host = 0;
+static int needs_cwd = 0;
+
+static PromptBuffer rendered = { NULL, 0, 0 };
+static int dirty = 1;                       /* The rendered prompt is out of date */
+static int is_tty = -1;
+
+static uid_t user_id = (uid_t)-1;
+static char *user_name = NULL;
+static char host_name[HOST_NAME_MAX + 1] = "";
+static char *cwd = NULL;
+
+/*****************************        Static Functions           ********************************/
+
+static int buffer_append(PromptBuffer *buffer, const char *text, size_t len)
+{
+    if (buffer->len + len > buffer->cap) {
+        size_t new_cap = buffer->cap ? buffer->cap * 2 : 128;
+        while (new_cap < buffer->len + len) {
+            new_cap *= 2;
+        }
+        char *data = realloc(buffer->data, new_cap);
+        if (data == NULL) {
+            return S_EXIT_MEM_ALLOC;
+        }
+        buffer->data = data;
+        buffer->cap = new_cap;
+    }
+
+    memcpy(buffer->data + buffer->len, text, len);
+    buffer->len += len;
+    return S_EXIT_SUCCESS;
+}
+
+static void free_segments(void)
+{
+    for (int i = 0; i < num_segments; i++) {
+        free(segments[i].text);
+    }
+    free(segments);
+    segments = NULL;
+    num_segments = 0;
+}
+
+/* Appends a segment, text segments take ownership of the collected bytes */
+static int add_segment(SegmentType type, PromptBuffer *text)
+{
+    PromptSegment *new_segments = realloc(segments, (num_segments + 1) * sizeof(PromptSegment));
+    if (new_segments == NULL) {
+        return S_EXIT_MEM_ALLOC;
+    }
+    segments = new_segments;
+
+    PromptSegment *segment = &segments[num_segments++];
+    segment->type = type;
+    segment->text = NULL;
+    segment->len = 0;
+    if (text != NULL) {
+        segment->text = text->data;
+        segment->len = text->len;
+        text->data = NULL;
+        text->len = text->cap = 0;
+    }
+
+    needs_user |= (type == SEGMENT_USER || type == SEGMENT_PROMPT_CHAR);
+    needs_host |= (type == SEGMENT_HOST || type == SEGMENT_FULL_HOST);
+    needs_cwd |= (type == SEGMENT_CWD || type == SEGMENT_CWD_BASE);
+    return S_EXIT_SUCCESS;
+}
+
+/* Ends the pending literal text (if any) as a segment of the given type */
+static int flush_text(PromptBuffer *text, SegmentType type)
+{
+    return text->len ? add_segment(type, text) : S_EXIT_SUCCESS;
+}
+
+/* Compiles a format into segments, escape sequences ("\e[...m") become color segments */
+static int compile(const char *source)
+{
+    PromptBuffer text = { NULL, 0, 0 };
+    int ret = S_EXIT_SUCCESS;
+
+    free_segments();
+    needs_user = needs_host = needs_cwd = 0;
+
+    for (const char *p = source; *p != '\0' && ret == S_EXIT_SUCCESS; p++) {
+        if (*p != '\\' || p[1] == '\0') {
+            ret = buffer_append(&text, p, 1);
+            continue;
+        }
+
+        SegmentType type;
+        p++;
+        switch (*p) {
+        case 'u': type = SEGMENT_USER;        break;
+        case 'h': type = SEGMENT_HOST;        break;
+        case 'H': type = SEGMENT_FULL_HOST;   break;
+        case 'w': type = SEGMENT_CWD;         break;
+        case 'W': type = SEGMENT_CWD_BASE;    break;
+        case '$': type = SEGMENT_PROMPT_CHAR; break;
+        case 'n':
+            ret = buffer_append(&text, "\n", 1);
+            continue;
+        case '[':
+        case ']':
+            continue;                       /* Non-printing markers, not needed here */
+        case 'e':
+        case '0': {
+            if (*p == '0') {
+                if (strncmp(p, "033", 3) != 0) {
+                    ret = buffer_append(&text, "\\0", 2);
+                    continue;
+                }
+                p += 2;
+            }
+            /* ESC [ ... letter: keep the whole sequence as one color segment */
+            size_t len = 1;
+            if (p[1] == '[') {
+                len = 2 + strspn(p + 2, "0123456789;");
+                if (p[len] != '\0') {
+                    len++;
+                }
+            }
+            ret = flush_text(&text, SEGMENT_TEXT);
+            if (ret == S_EXIT_SUCCESS) {
+                ret = buffer_append(&text, "\033", 1);
+            }
+            if (ret == S_EXIT_SUCCESS) {
+                ret = buffer_append(&text, p + 1, len - 1);
+            }
+            if (ret == S_EXIT_SUCCESS) {
+                ret = flush_text(&text, SEGMENT_COLOR);
+            }
+            p += len - 1;
+            continue;
+        }
+        default:
+            ret = buffer_append(&text, p, 1);   /* \\ and unknown escapes give the character */
+            continue;
+        }
+
+        ret = flush_text(&text, SEGMENT_TEXT);
+        if (ret == S_EXIT_SUCCESS) {
+            ret = add_segment(type, NULL);
+        }
+    }
+
+    if (ret == S_EXIT_SUCCESS) {
+        ret = flush_text(&text, SEGMENT_TEXT);
+    }
+    free(text.data);
+    return ret;
+}
+
+/* Compiles the format again if $PS1 changed since the last prompt */
+static void update_format(void)
+{
+    const char *current = get_variable(PROMPT_VARIABLE);
+    if (current == NULL) {
+        current = PROMPT_DEFAULT_FORMAT;
+    }
+    if (format != NULL && strcmp(format, current) == 0) {
+        return;
+    }
+
+    free(format);
+    format = strdup(current);
+    if (format == NULL || compile(format) != S_EXIT_SUCCESS) {
+        perror("Failed to allocate memory");
+        free(format);
+        format = NULL;
+        free_segments();
+    }
+    dirty = 1;
+}
+
+/* Checks the values used by the segments, only the user name lookup is expensive */
+static void update_values(void)
+{
+    if (needs_user && getuid() != user_id) {
+        user_id = getuid();
+        struct passwd *pw = getpwuid(user_id);
+        free(user_name);
+        user_name = strdup(pw ? pw->pw_name : "?");
+        dirty = 1;
+    }
+
+    if (needs_host) {
+        char current[HOST_NAME_MAX + 1];
+        if (gethostname(current, sizeof(current)) == 0 && strcmp(current, host_name) != 0) {
+            strcpy(host_name, current);
+            dirty = 1;
+        }
+    }
+
+    if (needs_cwd && cwd == NULL) {
+        cwd = getcwd(NULL, 0);
+        dirty = 1;
+    }
+}
+
+static void render(void)
+{
+    if (is_tty < 0) {
+        is_tty = isatty(STDOUT);
+    }
+
+    rendered.len = 0;
+    dirty = 1;
+    for (int i = 0; i < num_segments; i++) {
+        const PromptSegment *segment = &segments[i];
+        const char *text = NULL;
+        size_t len;
+
+        switch (segment->type) {
+        case SEGMENT_TEXT:
+            text = segment->text;
+            break;
+        case SEGMENT_COLOR:
+            text = is_tty ? segment->text : NULL;
+            break;
+        case SEGMENT_USER:
+            text = user_name;
+            break;
+        case SEGMENT_HOST:
+            text = host_name;
+            break;
+        case SEGMENT_FULL_HOST:
+            text = host_name;
+            break;
+        case SEGMENT_CWD:
+            text = cwd;
+            break;
+        case SEGMENT_CWD_BASE:
+            text = cwd ? strrchr(cwd, '/') : NULL;
+            if (text != NULL && text[1] != '\0') {
+                text++;
+            }
+            break;
+        case SEGMENT_PROMPT_CHAR:
+            text = (user_id == 0) ? "#" : "$";
+            break;
+        }
+
+        if (text == NULL) {
+            continue;
+        }
+        len = (segment->type == SEGMENT_TEXT || segment->type == SEGMENT_COLOR) ? segment->len : strlen(text);
+        if (segment->type == SEGMENT_HOST) {
+            len = strcspn(text, ".");
+        }
+
+        /* readline must not count the escape sequences in the width of the prompt */
+        int ret = S_EXIT_SUCCESS;
+        if (segment->type == SEGMENT_COLOR) {
+            ret = buffer_append(&rendered, "\001", 1);
+        }
+        if (ret == S_EXIT_SUCCESS) {
+            ret = buffer_append(&rendered, text, len);
+        }
+        if (ret == S_EXIT_SUCCESS && segment->type == SEGMENT_COLOR) {
+            ret = buffer_append(&rendered, "\002", 1);
+        }
+        if (ret != S_EXIT_SUCCESS) {
+            perror("Failed to allocate memory");
+            rendered.len = 0;
+            break;
+        }
+    }
+
+    if (buffer_append(&rendered, "", 1) == S_EXIT_SUCCESS) {
+        dirty = 0;
+    }
+}
+
+/*****************************        Public Functions           ********************************/
+
+const char *prompt_get(void)
+{
+    update_format();
+    update_values();
+
+    if (dirty) {
+        render();
+    }
+
+    return (rendered.data != NULL && !dirty) ? rendered.data : "";
+}
+
+void prompt_directory_changed(void)
+{
+    free(cwd);
+    cwd = NULL;                         /* Read again by the next prompt */
+}
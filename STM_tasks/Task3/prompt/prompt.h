@@ -0,0 +1,43 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        prompt.h               *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef PROMPT_H
+#define PROMPT_H
+
+/* Shell variable holding the prompt format */
+#define PROMPT_VARIABLE             "PS1"
+
+/* user@host: in blue followed by the current directory in green, like the original prompt */
+#define PROMPT_DEFAULT_FORMAT       "\\e[1;34m\\u@\\h:\\e[1;32m\\w\\e[0m $ Go Ahead! > "
+
+/**
+ * @brief Returns the prompt given to readline.
+ *
+ * The format ($PS1, or PROMPT_DEFAULT_FORMAT when it is not set) is compiled once into
+ * segments, and the rendered prompt is cached (color sequences are wrapped in the
+ * \001 \002 markers of readline so they do not count in the width of the line).
+ * It is only rendered again when the format, the user, the host name or the current
+ * directory (see prompt_directory_changed()) changed. The user name is only looked up
+ * when the uid changes.
+ *
+ * Supported escapes: \u user, \h host name up to the first '.', \H host name, \w current
+ * directory, \W its last component, \$ '#' for root and '$' otherwise, \n new line,
+ * \\ backslash, \e or \033 escape (color sequences are dropped when stdout is not a
+ * terminal) and \[ \] which are ignored.
+ */
+const char *prompt_get(void);
+
+/**
+ * @brief Tells the prompt that the shell changed its current directory.
+ */
+void prompt_directory_changed(void);
+
+#endif
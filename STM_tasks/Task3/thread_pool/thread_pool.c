@@ -0,0 +1,134 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        thread_pool.c          *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "thread_pool.h"
+#include "../exit_status.h"
+
+/*****************************        Static Functions           ********************************/
+
+static void *worker(void *arg)
+{
+    ThreadPool *pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (pool->count == 0 && !pool->stopping) {
+            pthread_cond_wait(&pool->not_empty, &pool->lock);
+        }
+        if (pool->count == 0 && pool->stopping) {
+            break;
+        }
+
+        Task task = pool->queue[pool->head];
+        pool->head = (pool->head + 1) % pool->capacity;
+        pool->count--;
+        pool->active++;
+        pthread_cond_signal(&pool->not_full);
+
+        /* Run the task without holding the lock */
+        pthread_mutex_unlock(&pool->lock);
+        task.function(task.arg);
+        pthread_mutex_lock(&pool->lock);
+
+        pool->active--;
+        if (pool->count == 0 && pool->active == 0) {
+            pthread_cond_broadcast(&pool->idle);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/*****************************        Public Functions           ********************************/
+
+int thread_pool_init(ThreadPool *pool, int num_threads)
+{
+    if (num_threads < 1) {
+        num_threads = 1;
+    } else if (num_threads > THREAD_POOL_MAX_THREADS) {
+        num_threads = THREAD_POOL_MAX_THREADS;
+    }
+
+    pool->capacity = num_threads * THREAD_POOL_QUEUE_PER_THREAD;
+    pool->queue = malloc(pool->capacity * sizeof(Task));
+    if (pool->queue == NULL) {
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    pool->head = 0;
+    pool->count = 0;
+    pool->active = 0;
+    pool->stopping = 0;
+    pool->num_threads = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->not_empty, NULL);
+    pthread_cond_init(&pool->not_full, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+
+    for (int i = 0; i < num_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker, pool) != 0) {
+            break;
+        }
+        pool->num_threads++;
+    }
+
+    if (pool->num_threads == 0) {
+        thread_pool_destroy(pool);
+        return S_EXIT_FAILURE;
+    }
+    return S_EXIT_SUCCESS;
+}
+
+void thread_pool_submit(ThreadPool *pool, TaskFunction function, void *arg)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (pool->count == pool->capacity) {
+        pthread_cond_wait(&pool->not_full, &pool->lock);
+    }
+
+    pool->queue[(pool->head + pool->count) % pool->capacity] = (Task){ function, arg };
+    pool->count++;
+    pthread_cond_signal(&pool->not_empty);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_wait(ThreadPool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (pool->count > 0 || pool->active > 0) {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_destroy(ThreadPool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->not_empty);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->not_empty);
+    pthread_cond_destroy(&pool->not_full);
+    pthread_cond_destroy(&pool->idle);
+    free(pool->queue);
+    pool->queue = NULL;
+}
@@ -0,0 +1,72 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        thread_pool.h          *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <pthread.h>
+
+/* Maximum number of workers of a pool */
+#define THREAD_POOL_MAX_THREADS     64
+
+/* Number of queued tasks per worker before thread_pool_submit() blocks */
+#define THREAD_POOL_QUEUE_PER_THREAD 16
+
+typedef void (*TaskFunction)(void *arg);
+
+typedef struct {
+    TaskFunction function;
+    void *arg;
+} Task;
+
+/* Fixed set of workers consuming a bounded circular queue of tasks */
+typedef struct {
+    pthread_t threads[THREAD_POOL_MAX_THREADS];
+    int num_threads;
+
+    Task *queue;
+    int capacity;
+    int head;                       /* Next task to run */
+    int count;                      /* Number of queued tasks */
+    int active;                     /* Number of tasks being run */
+    int stopping;
+
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;       /* Signaled when a task is queued or the pool stops */
+    pthread_cond_t not_full;        /* Signaled when a task is taken from the queue */
+    pthread_cond_t idle;            /* Signaled when the queue is empty and no task runs */
+} ThreadPool;
+
+/**
+ * @brief Starts the workers of a pool.
+ *
+ * @param pool The pool to initialize.
+ * @param num_threads Number of workers (clamped to 1..THREAD_POOL_MAX_THREADS).
+ * @return int Returns S_EXIT_SUCCESS, or S_EXIT_MEM_ALLOC / S_EXIT_FAILURE.
+ */
+int thread_pool_init(ThreadPool *pool, int num_threads);
+
+/**
+ * @brief Queues a task, blocking while the queue is full so memory use stays bounded.
+ */
+void thread_pool_submit(ThreadPool *pool, TaskFunction function, void *arg);
+
+/**
+ * @brief Blocks until every submitted task has finished.
+ */
+void thread_pool_wait(ThreadPool *pool);
+
+/**
+ * @brief Finishes the queued tasks, stops the workers and frees the queue.
+ */
+void thread_pool_destroy(ThreadPool *pool);
+
+#endif
@@ -11,9 +11,13 @@
 
 /*****************************            Includes               ********************************/
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <libgen.h>
 #include <unistd.h>
@@ -26,366 +30,617 @@
 #include "../cmds_implementations/cmds.h"
 #include "../helper_functions/helpers.h"
 #include "../exit_status.h"
+#include "../variables/variables.h"
+#include "../console/console.h"
+#include "../history/history.h"
+#include "../jobs/jobs.h"
 
 char **Command_History; 
 int num_commands = 0;
 int History_index;
 
 
-int Execute_Command(char **Command_tokens, char *full_command)
+int Execute_Command(char **Command_tokens)
 {
-    int Exit_Status;
+    int Exit_Status = S_EXIT_SUCCESS;
 
     if(strcmp(Command_tokens[0], "shelp") == 0)
     {
         Help_Command();
-        add_to_history(full_command, S_EXIT_SUCCESS);
     }
 
     else if(strcmp(Command_tokens[0], "secho") == 0)
     {
         Exit_Status = Echo_Command(Command_tokens);
-        add_to_history(full_command, Exit_Status);
     }
 
     else if(strcmp(Command_tokens[0], "spwd") == 0)
     {
         Print_Current_Directory();
         Write_syscall(STDOUT, "\n", white);
-        add_to_history(full_command, S_EXIT_SUCCESS);
     }
 
     else if(strcmp(Command_tokens[0], "scp") == 0)
     {
         Exit_Status = Copy_Command(Command_tokens);
-        add_to_history(full_command, Exit_Status);
     }
 
     else if(strcmp(Command_tokens[0], "smv") == 0)
     {
         Exit_Status = Move_Command(Command_tokens);
-        add_to_history(full_command, Exit_Status);
     }
 
     else if(strcmp(Command_tokens[0], "senvir") == 0)
     {
         Print_Environmen_Variables(Command_tokens);
-        add_to_history(full_command, S_EXIT_SUCCESS);
     }
 
     else if(strcmp(Command_tokens[0], "stype") == 0)
     {
         Type_of_Command(Command_tokens);
-        add_to_history(full_command, S_EXIT_SUCCESS);
     }
 
     else if(strcmp(Command_tokens[0], "sphist") == 0)
     {
-        print_history();
-        add_to_history(full_command, S_EXIT_SUCCESS);
+        Exit_Status = History_Command(Command_tokens);
     }
 
     else if(strcmp(Command_tokens[0], "sfree") == 0)
     {
-        Exit_Status = Free_Command();
-        add_to_history(full_command, Exit_Status);
+        Exit_Status = Free_Command(Command_tokens);
+    }
+
+    else if(strcmp(Command_tokens[0], "suptime") == 0)
+    {
+        Exit_Status = Uptime_Command(Command_tokens);
     }
 
-    else if(strcmp(full_command, "suptime") == 0)
+    else if(strcmp(Command_tokens[0], "sps") == 0)
     {
-        Exit_Status = Uptime_Command();
-        add_to_history(full_command, Exit_Status);
+        Exit_Status = Process_Status_Command(Command_tokens);
     }
 
+    else if(strcmp(Command_tokens[0], "shash") == 0)
+    {
+        Exit_Status = Hash_Command(Command_tokens);
+    }
+
+    else if(strcmp(Command_tokens[0], "stime") == 0)
+    {
+        Exit_Status = Time_Command(Command_tokens);
+    }
+
+    else if(strcmp(Command_tokens[0], "sset") == 0)
+    {
+        Exit_Status = Set_Command(Command_tokens);
+    }
+
+    else if(strcmp(Command_tokens[0], "sjobs") == 0)
+    {
+        Exit_Status = Jobs_Command(Command_tokens);
+    }
+
+    else if(strcmp(Command_tokens[0], "sfg") == 0)
+    {
+        Exit_Status = Foreground_Command(Command_tokens);
+    }
+
+    else if(strcmp(Command_tokens[0], "sbg") == 0)
+    {
+        Exit_Status = Background_Command(Command_tokens);
+    }
 
-    else
+    else if(strcmp(Command_tokens[0], "swait") == 0)
     {
-        Execute_External_Command(Command_tokens);
+        Exit_Status = Wait_Command(Command_tokens);
     }
 
     return Exit_Status;
 }
 
-void Execute_Single_Command(char *full_command, char **Command_tokens, int redirections, char Target_files[NUM_OF_STREAMS][MAX_FILE_NAME_SIZE]) 
+/* Without job control a background job must not read the shell's input */
+static int open_background_stdin(int background)
 {
+    if (!background || jobs_control_enabled()) {
+        return -1;
+    }
+    return open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+/* Builtins that change the shell itself: in a pipeline they run in a child like other shells do */
+static int changes_shell_state(const char *command)
+{
+    static const char *state_commands[] = {"scd", "sexit", "shash", "stime", "sset", "sjobs", "sfg", "sbg", "swait"};
+
+    for (size_t i = 0; i < sizeof(state_commands) / sizeof(state_commands[0]); i++) {
+        if (strcmp(state_commands[i], command) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Saves a copy of fd in saved[2 * *count] so it can be restored after a redirection (-1 if it was closed) */
+static void save_fd(int *saved, int *count, int fd)
+{
+    saved[2 * *count] = fd;
+    saved[2 * *count + 1] = fcntl(fd, F_DUPFD_CLOEXEC, 10);
+    (*count)++;
+}
+
+/**
+ * Runs a builtin in the shell process instead of a forked child. The descriptors it
+ * redirects (and stdin when in_fd is given) are saved with dup before and put back
+ * with dup2 after the call, so the shell's own stdin/stdout/stderr are left untouched.
+ */
+static int run_builtin_in_shell(SimpleCommand *command, int in_fd)
+{
+    int num_fds = (in_fd >= 0) ? 1 : 0;
+    for (const Redirection *redirection = command->redirections; redirection != NULL; redirection = redirection->next) {
+        num_fds++;
+    }
+
+    int *saved = malloc((2 * num_fds + 1) * sizeof(int));
+    if (saved == NULL) {
+        perror("Failed to allocate memory");
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    int count = 0;
+    if (in_fd >= 0) {
+        save_fd(saved, &count, STDIN);
+    }
+    for (const Redirection *redirection = command->redirections; redirection != NULL; redirection = redirection->next) {
+        save_fd(saved, &count, redirection->fd);
+    }
+
+    /* Pending output belongs to the old descriptors */
+    console_flush_all();
+
     int Exit_Status;
-    
+    if (in_fd >= 0 && in_fd != STDIN && dup2(in_fd, STDIN) < 0) {
+        perror("dup2");
+        Exit_Status = S_EXIT_DUP_FILE_FAILED;
+    } else if (Redirect(command->redirections) != S_EXIT_SUCCESS) {
+        Exit_Status = S_EXIT_FAILURE;
+    } else {
+        Exit_Status = Execute_Command(command->argv);
+    }
+
+    console_flush_all();
+
+    /* Restore in reverse order, the first copy of a descriptor saved twice is the original */
+    for (int i = count - 1; i >= 0; i--) {
+        int fd = saved[2 * i];
+        int copy = saved[2 * i + 1];
+        if (copy >= 0) {
+            dup2(copy, fd);
+            close(copy);
+        } else {
+            close(fd);
+        }
+    }
+
+    free(saved);
+    return Exit_Status;
+}
+
+/* Starts one command of a job: programs are spawned directly, builtins run in a forked shell.
+ * When nothing is started, *failure_status tells why (see Spawn_External_Command()). */
+static pid_t launch_command(SimpleCommand *command, Job *job, int foreground,
+                            int in_fd, int out_fd, const int *close_fds, int num_close_fds, int *failure_status)
+{
+    if (is_internal_command(command->argv[0]) != S_EXIT_SUCCESS) {
+        return Spawn_External_Command(command->argv, command->redirections, in_fd, out_fd,
+                                      close_fds, num_close_fds, job_process_group(job), failure_status);
+    }
+
+    /* The child must not inherit (and print again) the pending output */
+    console_flush_all();
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        job_child_setup(job, foreground);
+
+        /* Connect the pipe ends (or /dev/null) to stdin and stdout */
+        if ((in_fd >= 0 && in_fd != STDIN && dup2(in_fd, STDIN) < 0) ||
+            (out_fd >= 0 && out_fd != STDOUT && dup2(out_fd, STDOUT) < 0)) {
+            perror("dup2");
+            exit(S_EXIT_DUP_FILE_FAILED);
+        }
+        for (int k = 0; k < num_close_fds; k++) {
+            close(close_fds[k]);
+        }
+
+        /* Explicit redirections take precedence over the pipes. */
+        if (Redirect(command->redirections) != S_EXIT_SUCCESS) {
+            exit(S_EXIT_FAILURE);
+        }
+
+        exit(Execute_Command(command->argv));
+    }
+
+    if (pid < 0) {
+        perror("fork");
+        *failure_status = S_EXIT_FAILURE;
+    }
+    return pid;
+}
+
+/* NAME=value as written: a value containing '=' (e.g. $X set to "A=1") is not an assignment */
+static int is_assignment_word(const char *word)
+{
+    return word[strcspn(word, "=$'\"\\")] == '=';
+}
+
+int Execute_Single_Command(SimpleCommand *command, int background) 
+{
+    int Exit_Status = S_EXIT_SUCCESS;
+    char **Command_tokens = command->argv;
+    char *variable_name; 
+    char *variable_value; 
+    HistoryTimer timer;
+
+    cmd_history_timer_start(&timer);
+
     /* If the command was scd => execute it here before forking */
     if(strcmp(Command_tokens[0], "scd") == 0)
     {
         Exit_Status = change_Directory_Command(Command_tokens);
-        add_to_history(full_command, Exit_Status);
-        return;
+        cmd_history_add(command->text, Exit_Status, &timer, NULL);
+        return Exit_Status;
+    }
+
+    /* shash inspects and resets the shell's own cache => execute it here before forking */
+    else if(strcmp(Command_tokens[0], "shash") == 0)
+    {
+        Exit_Status = Hash_Command(Command_tokens);
+        cmd_history_add(command->text, Exit_Status, &timer, NULL);
+        return Exit_Status;
+    }
+
+    /* stime -s changes a setting of the shell => execute it here before forking */
+    else if(strcmp(Command_tokens[0], "stime") == 0)
+    {
+        Exit_Status = Time_Command(Command_tokens);
+        cmd_history_add(command->text, Exit_Status, &timer, NULL);
+        return Exit_Status;
+    }
+
+    /* sset changes the shell options => execute it here before forking */
+    else if(strcmp(Command_tokens[0], "sset") == 0)
+    {
+        Exit_Status = Set_Command(Command_tokens);
+        cmd_history_add(command->text, Exit_Status, &timer, NULL);
+        return Exit_Status;
     }
 
     /* If the command was sexit => terminate the program before forking */
     else if(strcmp(Command_tokens[0], "sexit") == 0)
     {
         Write_syscall(STDOUT, "Good bye !\n", red);
-        add_to_history(full_command, S_EXIT_SUCCESS);
+        cmd_history_add(command->text, S_EXIT_SUCCESS, &timer, NULL);
         printLineSeparator();
         exit(S_EXIT_SUCCESS);
     }
-    
-    pid_t retPID = fork();
-    if(retPID > 0) 
+
+    /* If the command was a variable declaration (NAME=value) => store it in the shell */
+    else if(command->argc == 1 && command->redirections == NULL && is_assignment_word(command->words[0]) &&
+            contains_variable_declaration(Command_tokens[0], &variable_name, &variable_value) == S_EXIT_SUCCESS)
     {
-        /* Parent */
-        int status;
+        set_variable(variable_name, variable_value);
+        return S_EXIT_SUCCESS;
+    }
 
-        /* Wait fot the child process to end */
-        wait(&status);
-        printLineSeparator();
-    } 
-    
-    else if(retPID == 0) 
+    /* Job control builtins work on the shell's job table => execute them here before forking */
+    else if(strcmp(Command_tokens[0], "sjobs") == 0 || strcmp(Command_tokens[0], "sfg") == 0 ||
+            strcmp(Command_tokens[0], "sbg") == 0 || strcmp(Command_tokens[0], "swait") == 0)
     {
-        /* Child */
+        Exit_Status = Execute_Command(Command_tokens);
+        cmd_history_add(command->text, Exit_Status, &timer, NULL);
+        return Exit_Status;
+    }
 
-        /* Redirect streams if redirection is used */
-        if (redirections > 0) {
-            if (Redirect(redirections, Target_files) < 0) {
-                perror("Redirection failed");
-                exit(S_EXIT_FAILURE);
-            }
-        }
+    /* Other builtins in the foreground run in the shell with their redirections => no fork */
+    else if(!background && is_internal_command(Command_tokens[0]) == S_EXIT_SUCCESS)
+    {
+        Exit_Status = run_builtin_in_shell(command, -1);
+        cmd_history_add(command->text, Exit_Status, &timer, NULL);
+        printLineSeparator();
+        return Exit_Status;
+    }
 
+    Job *job = job_create(command->text);
+    if (job == NULL) {
+        perror("Failed to allocate memory");
+        return S_EXIT_MEM_ALLOC;
+    }
 
-        Exit_Status = Execute_Command(Command_tokens, full_command);
-        exit(Exit_Status);
-    } 
-    
-    else 
-    {
-        perror("fork");
-        exit(S_EXIT_FAILURE);
+    int background_stdin = open_background_stdin(background);
+    int failure_status = S_EXIT_FAILURE;
+    pid_t pid = launch_command(command, job, !background, background_stdin, -1, NULL, 0, &failure_status);
+    if (background_stdin >= 0) {
+        close(background_stdin);
+    }
+
+    if (pid < 0 || job_add_process(job, pid, command->text) != S_EXIT_SUCCESS) {
+        job_run_foreground(job);            /* Reaps the process if it was started, frees the job */
+        Exit_Status = (pid < 0) ? failure_status : S_EXIT_MEM_ALLOC;
+        cmd_history_add(command->text, Exit_Status, &timer, NULL);
+        return Exit_Status;
+    }
+
+    if (background) {
+        job_run_background(job);
+        return S_EXIT_SUCCESS;
     }
+
+    Exit_Status = job_run_foreground(job);
+    printLineSeparator();
+    return Exit_Status;
 }
 
-int Execute_Piped_Commands(char **commands, int num_pipes, int redirections, char Target_files[NUM_OF_STREAMS][MAX_FILE_NAME_SIZE]) 
+/* Status of a pipeline: its last stage, or with pipefail the last stage that failed */
+static int pipeline_status(const int *statuses, int count)
 {
-    /* Array to hold pipe file descriptors. */
-    int pipefds[2 * num_pipes];
+    if (get_shell_option(SHELL_OPTION_PIPEFAIL)) {
+        for (int i = count - 1; i >= 0; i--) {
+            if (statuses[i] != S_EXIT_SUCCESS) {
+                return statuses[i];
+            }
+        }
+    }
+    return statuses[count - 1];
+}
+
+int Execute_Piped_Commands(Pipeline *pipeline) 
+{
+    int num_pipes = pipeline->num_commands - 1;
+
+    /* Array to hold pipe file descriptors, sized for any number of stages */
+    int *pipefds = malloc(2 * num_pipes * sizeof(int));
+    if (pipefds == NULL) {
+        perror("Failed to allocate memory");
+        return S_EXIT_MEM_ALLOC;
+    }
 
     /* Create the necessary pipes */
     for (int i = 0; i < num_pipes; i++) {
         if (pipe(pipefds + i * 2) < 0) {
             perror("pipe"); /* Error creating pipe. */
+            for (int j = 0; j < 2 * i; j++) {
+                close(pipefds[j]);
+            }
+            free(pipefds);
             return S_EXIT_FAILURE;
         }
     }
 
     int j = 0; /* Index for accessing pipe file descriptors. */
-    
-    /* Iterate through each command, forking a new process for each. */
-    for (int i = 0; i <= num_pipes; i++) {
-        pid_t pid = fork(); /* Fork a new process. */
-        
-        if (pid == 0) {
-            /* In the child process. */
-
-            /* If not the last command, redirect stdout to the next pipe. */
-            if (i < num_pipes) {
-                if (dup2(pipefds[j + 1], STDOUT) < 0) {
-                    perror("dup2"); /* Error duplicating file descriptor. */
-                    return S_EXIT_FAILURE;
-                }
-            }
-
-            /* If not the first command, redirect stdin to the previous pipe. */
-            if (i > 0) {
-                if (dup2(pipefds[j - 2], STDIN) < 0) {
-                    perror("dup2"); /* Error duplicating file descriptor. */
-                    return S_EXIT_FAILURE;
-                }
-            }
-
-            /* Close all pipe file descriptors in the child process. */
-            for (int k = 0; k < 2 * num_pipes; k++) {
-                close(pipefds[k]);
-            }
-
-            /* Tokenize the current command. */
-            char *Command_tokens[MAX_TOKENS] = {NULL};
-            Parse_Commands(commands[i], Command_tokens);
-
-            /* Handle redirections if specified for the last command. */
-            if (redirections > 0 && i == num_pipes) {
-                if (Redirect(redirections, Target_files) < 0) {
-                    perror("Redirection failed"); /* Error during redirection. */
-                    return S_EXIT_FAILURE;
-                }
-            }
-
-            /* Execute the current command. */
-            int Exit_Status = Execute_Command(Command_tokens, commands[i]);
-            exit(Exit_Status); /* Exit the child process with the command's exit status. */
-        } 
-        
-        else if (pid < 0) {
-            perror("fork"); /* Error forking process. */
-            return S_EXIT_FAILURE;
+    int foreground = !pipeline->background;
+
+    /* A last stage that is a builtin only printing things runs in the shell, reading the last pipe */
+    SimpleCommand *last = &pipeline->commands[num_pipes];
+    int last_in_shell = foreground && is_internal_command(last->argv[0]) == S_EXIT_SUCCESS &&
+                        !changes_shell_state(last->argv[0]);
+    int num_forked = last_in_shell ? num_pipes : num_pipes + 1;
+
+    /* All the stages form one job, with its own process group when job control is on */
+    Job *job = job_create(pipeline->text);
+    int background_stdin = open_background_stdin(pipeline->background);
+
+    /* Iterate through each command, starting a new process for each. */
+    for (int i = 0; i < num_forked && job != NULL; i++) {
+        SimpleCommand *command = &pipeline->commands[i];
+
+        int failure_status = S_EXIT_FAILURE;
+        pid_t pid = launch_command(command, job, foreground,
+                                   (i > 0) ? pipefds[j - 2] : background_stdin,
+                                   (i < num_pipes) ? pipefds[j + 1] : -1,
+                                   pipefds, 2 * num_pipes, &failure_status);
+        int ret = (pid > 0) ? job_add_process(job, pid, command->text)
+                            : job_add_finished_process(job, command->text, failure_status);
+        if (ret != S_EXIT_SUCCESS) {
+            perror("Failed to allocate memory");
         }
 
-
         /* Move to the next set of pipe file descriptors. */
         j += 2; 
     }
 
-    /* Close all pipe file descriptors in the parent process. */
+    /* Close all pipe file descriptors in the parent process (but the one the builtin reads). */
+    int last_pipe_read = pipefds[2 * num_pipes - 2];
     for (int i = 0; i < 2 * num_pipes; i++) {
-        close(pipefds[i]);
+        if (!(last_in_shell && pipefds[i] == last_pipe_read)) {
+            close(pipefds[i]);
+        }
+    }
+    free(pipefds);
+    if (background_stdin >= 0) {
+        close(background_stdin);
     }
 
-    /* Wait for all child processes to complete. */
-    for (int i = 0; i <= num_pipes; i++) {
-        wait(NULL);
+    if (job == NULL) {
+        if (last_in_shell) {
+            close(last_pipe_read);
+        }
+        perror("Failed to allocate memory");
+        return S_EXIT_MEM_ALLOC;
     }
 
-    return S_EXIT_SUCCESS; /* Return success status. */
-}
+    if (last_in_shell) {
+        int status = run_builtin_in_shell(last, last_pipe_read);
+        close(last_pipe_read);
+        if (job_add_finished_process(job, last->text, status) != S_EXIT_SUCCESS) {
+            perror("Failed to allocate memory");
+        }
+    }
+
+    if (pipeline->background && job->num_processes > 0) {
+        int Exit_Status = S_EXIT_SUCCESS;
+        job_run_background(job);
+        set_pipe_status(&Exit_Status, 1);
+        return Exit_Status;
+    }
+
+    /* Wait for all the stages, each one is added to the history when it finishes */
+    int Exit_Status = job_run_foreground(job);
 
+    const int *statuses;
+    int count = jobs_last_statuses(&statuses);
+    if (count == 0) {
+        statuses = &Exit_Status;
+        count = 1;
+    }
+
+    set_pipe_status(statuses, count);
+    return pipeline_status(statuses, count);
+}
 
-int Parse_Pipes(char *command, char **commands) 
+int Execute_Command_List(CommandList *list)
 {
-    /* Initialize the count of commands. */
-    int count = 0;               
+    int Exit_Status = get_last_exit_status();
 
-    /* Tokenize the command string using '|' as a delimiter. */       
-    char *token = strtok(command, "|"); 
+    for (int i = 0; i < list->count; i++) {
+        ListItem *item = &list->items[i];
 
-    /* Iterate through all tokens, storing each command in the commands array. */
-    while (token != NULL && count < MAX_PIPES) {
+        /* && and || only run the pipeline depending on the previous status */
+        if ((item->op == LIST_AND && Exit_Status != S_EXIT_SUCCESS) ||
+            (item->op == LIST_OR && Exit_Status == S_EXIT_SUCCESS)) {
+            continue;
+        }
 
-        /* Store the current token (command) in the commands array. */
-        commands[count++] = token; 
+        /* The words are expanded now, so they see the variables set by the pipelines before */
+        if (Expand_Pipeline(list->arena, &item->pipeline) != S_EXIT_SUCCESS) {
+            perror("Failed to allocate memory");
+            Exit_Status = S_EXIT_MEM_ALLOC;
+        } else if (item->pipeline.num_commands == 1 && item->pipeline.commands[0].argc == 0) {
+            Exit_Status = S_EXIT_SUCCESS;       /* Every word expanded to nothing */
+            set_pipe_status(&Exit_Status, 1);
+        } else if (item->pipeline.num_commands == 1) {
+            Exit_Status = Execute_Single_Command(&item->pipeline.commands[0], item->pipeline.background);
+            set_pipe_status(&Exit_Status, 1);
+        } else {
+            /* Also sets $PIPESTATUS to the status of every stage */
+            Exit_Status = Execute_Piped_Commands(&item->pipeline);
+        }
 
-        /* Get the next token (command). */     
-        token = strtok(NULL, "|");      
-    }
+        /* Make the status available as $? */
+        set_last_exit_status(Exit_Status);
+        console_flush_all();
 
-    /* Null-terminate the commands array. */
-    commands[count] = NULL;    
+        /* errexit (-e): a failure ends the shell, unless && or || tests it */
+        int tested = (i + 1 < list->count && list->items[i + 1].op != LIST_SEQUENCE);
+        if (Exit_Status != S_EXIT_SUCCESS && !tested && get_shell_option(SHELL_OPTION_ERREXIT)) {
+            exit(Exit_Status);
+        }
+    }
 
-    /* Return the number of pipes (number of commands - 1). */   
-    return count - 1;                   
+    return Exit_Status;
 }
 
+/* Writes the whole buffer, -1 on failure */
+static int write_all(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += written;
+        len -= written;
+    }
+    return 0;
+}
 
+int Open_Here_Document(const char *body)
+{
+    size_t len = strlen(body);
+
+    int fd = memfd_create("here-document", MFD_CLOEXEC);
+    if (fd >= 0) {
+        if (write_all(fd, body, len) < 0 || lseek(fd, 0, SEEK_SET) < 0) {
+            int saved_errno = errno;
+            close(fd);
+            errno = saved_errno;
+            return -1;
+        }
+        return fd;
+    }
 
-int SearchForRedirections(char* command, char target_files[NUM_OF_STREAMS][MAX_FILE_NAME_SIZE]) {
-    const char *input_redirect  =   "<";
-    const char *output_redirect =   ">";
-    const char *error_redirect  =   "2>";
-
-    int redirections = 0;                   /* Bitmask to store redirection types. */
-    char *pos;
-    char *command_copy = strdup(command);   /* Create a copy of the command to avoid modifying the original. */
-    char *temp_command = command_copy;      /* Temporary pointer for modifying the copy. */
-    
-    /* Initialize target_files to empty strings. */
-    for (int i = 0; i < NUM_OF_STREAMS; i++) {
-        target_files[i][0] = '\0';
-    }
-
-    /* Search for error redirection first to avoid confusion with output redirection. */
-    if ((pos = strstr(temp_command, error_redirect)) != NULL) {
-        redirections |= STDERR_REDIRECT;   /* Set the error redirection flag. */
-        /* Extract the file name for error redirection. */
-        pos += strlen(error_redirect);
-        sscanf(pos, "%99s", target_files[2]);
-        trim_spaces(target_files[2]);
-        /* Remove the error redirection from the temporary command. */
-        pos -= strlen(error_redirect);
-        *pos = '\0';
-    }
-
-    /* Search for output redirection. */
-    if ((pos = strstr(temp_command, output_redirect)) != NULL) {
-        redirections |= STDOUT_REDIRECT;   /* Set the output redirection flag. */
-        /* Extract the file name for output redirection. */
-        pos += strlen(output_redirect);
-        sscanf(pos, "%99s", target_files[1]);
-        trim_spaces(target_files[1]);
-        /* Remove the output redirection from the temporary command. */
-        pos -= strlen(output_redirect);
-        *pos = '\0';
-    }
-
-    /* Search for input redirection. */
-    if ((pos = strstr(temp_command, input_redirect)) != NULL) {
-        redirections |= STDIN_REDIRECT;    /* Set the input redirection flag. */
-        /* Extract the file name for input redirection. */
-        pos += strlen(input_redirect);
-        sscanf(pos, "%99s", target_files[0]);
-        trim_spaces(target_files[0]);
-        /* Remove the input redirection from the temporary command. */
-        pos -= strlen(input_redirect);
-        *pos = '\0';
-    }
-
-    /* Copy the modified command back to the original command string. */
-    strncpy(command, temp_command, strlen(temp_command));
-    command[strlen(temp_command)] = '\0';  /* Ensure null termination. */
-
-    /* Remove any trailing spaces from the command after redirection removal. */
-    trim_spaces(command);
-
-    free(command_copy);  /* Free the copied command. */
-    return redirections; /* Return the bitmask of redirections. */
+    /* No memfd: a pipe, the writer must not block as nobody reads it yet */
+    int pipefd[2];
+    if (pipe2(pipefd, O_CLOEXEC) < 0) {
+        return -1;
+    }
+    if (len > PIPE_BUF) {
+        fcntl(pipefd[1], F_SETPIPE_SZ, (int)len);
+    }
+    fcntl(pipefd[1], F_SETFL, O_NONBLOCK);
+    if (write_all(pipefd[1], body, len) < 0) {
+        int saved_errno = errno;
+        close(pipefd[0]);
+        close(pipefd[1]);
+        errno = saved_errno;
+        return -1;
+    }
+    close(pipefd[1]);
+    return pipefd[0];
 }
 
-int Redirect(int redirections, char target_files[NUM_OF_STREAMS][MAX_FILE_NAME_SIZE])
+int Redirect(const Redirection *redirections)
 {
     int oldFD;
     int ret;
 
-    /* Handle input redirection if specified. */
-    if (redirections & STDIN_REDIRECT) {
-        oldFD = open(target_files[STDIN], O_RDONLY);
-        if (oldFD < 0) {
-            perror("open"); /* Error opening file for input redirection. */
-            return S_EXIT_OPEN_FILE_FAILED;
-        }
-        ret = dup2(oldFD, STDIN);
-        if (ret < 0) {
-            perror("dup2"); /* Error duplicating file descriptor for input redirection. */
-            close(oldFD);
-            return S_EXIT_DUP_FILE_FAILED;
+    for (const Redirection *redirection = redirections; redirection != NULL; redirection = redirection->next) {
+        const char *name = redirection->target;
+
+        switch (redirection->type) {
+        case REDIR_INPUT:
+            oldFD = open(name, O_RDONLY);
+            break;
+        case REDIR_OUTPUT:
+            oldFD = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            break;
+        case REDIR_APPEND:
+            oldFD = open(name, O_WRONLY | O_CREAT | O_APPEND, 0644);
+            break;
+        case REDIR_HERE_DOCUMENT:
+        case REDIR_HERE_STRING:
+            name = "here-document";
+            oldFD = Open_Here_Document(redirection->body ? redirection->body : "");
+            break;
+        case REDIR_CLOSE:
+            close(redirection->fd);
+            continue;
+        case REDIR_DUP:
+            /* n>&m: the descriptor stays open, only n is replaced */
+            if (redirection->target_fd != redirection->fd && dup2(redirection->target_fd, redirection->fd) < 0) {
+                console_printf(STDERR, red, "%d: bad file descriptor\n", redirection->target_fd);
+                return S_EXIT_DUP_FILE_FAILED;
+            }
+            continue;
         }
-        close(oldFD);
-    }
 
-    /* Handle output redirection if specified. */
-    if (redirections & STDOUT_REDIRECT) {
-        oldFD = open(target_files[STDOUT], O_WRONLY | O_CREAT | O_TRUNC, 0644);
         if (oldFD < 0) {
-            perror("open"); /* Error opening file for output redirection. */
+            perror(name); /* Error opening file for redirection. */
             return S_EXIT_OPEN_FILE_FAILED;
         }
-        ret = dup2(oldFD, STDOUT);
-        if (ret < 0) {
-            perror("dup2"); /* Error duplicating file descriptor for output redirection. */
-            close(oldFD);
-            return S_EXIT_DUP_FILE_FAILED;
-        }
-        close(oldFD);
-    }
 
-    /* Handle error redirection if specified. */
-    if (redirections & STDERR_REDIRECT) {
-        oldFD = open(target_files[STDERR], O_WRONLY | O_CREAT | O_TRUNC, 0644);
-        if (oldFD < 0) {
-            perror("open"); /* Error opening file for error redirection. */
-            return S_EXIT_OPEN_FILE_FAILED;
-        }
-        ret = dup2(oldFD, STDERR);
-        if (ret < 0) {
-            perror("dup2"); /* Error duplicating file descriptor for error redirection. */
+        if (oldFD != redirection->fd) {
+            ret = dup2(oldFD, redirection->fd);
             close(oldFD);
-            return S_EXIT_DUP_FILE_FAILED;
+            if (ret < 0) {
+                perror("dup2"); /* Error duplicating file descriptor for redirection. */
+                return S_EXIT_DUP_FILE_FAILED;
+            }
+        } else {
+            fcntl(oldFD, F_SETFD, 0);   /* Here-documents are opened with O_CLOEXEC */
         }
-        close(oldFD);
     }
 
     return S_EXIT_SUCCESS; /* Return success status. */
@@ -13,83 +13,86 @@
 #ifndef UTILS_H
 #define UTILS_H
 
-#define MAX_PIPES           10
-#define MAX_COMMANDS        100
-
-#define NUM_OF_STREAMS      3
-#define MAX_FILE_NAME_SIZE  100
+#include "../parser/parser.h"
 
 /**
  * @brief Executes a command based on the provided tokens.
  * 
  * This function checks the first token to determine which command to execute.
- * It handles built-in commands and external commands, and updates the command history.
+ * Only built-in commands get here, programs are spawned by the callers. The command
+ * history is updated by the callers, in the shell process.
  * 
  * @param Command_tokens Array of strings containing the command and its arguments.
- * @param full_command The full command string as input by the user.
  * @return int Status code indicating success or failure of the command execution.
  */
-int Execute_Command(char **Command_tokens, char *full_command);
+int Execute_Command(char **Command_tokens);
 
 /**
  * @brief Executes a single command, handling redirections and command execution.
  * 
- * This function forks a new process to execute the command. It handles redirections 
- * if specified and exits the process with the appropriate status code.
+ * Builtins in the foreground run in the shell itself, with the command's redirections
+ * applied around the call (the shell's descriptors are saved and restored). Background
+ * builtins run in a forked process and programs are spawned directly. The command is added to the history with
+ * its exit status and duration.
  * 
- * @param full_command The full command string as input by the user.
- * @param Command_tokens Array of strings containing the command and its arguments.
- * @param redirections Bitmask indicating the types of redirections to apply.
- * @param Target_files Array of strings containing filenames for redirection.
+ * @param command The parsed command with its arguments and redirections.
+ * @param background 1 to start the command as a background job without waiting for it.
+ * @return int Exit status of the command (S_EXIT_SUCCESS for a background job).
  */
-void Execute_Single_Command(char *full_command, char **Command_tokens, int redirections, char Target_files[NUM_OF_STREAMS][MAX_FILE_NAME_SIZE]);
+int Execute_Single_Command(SimpleCommand *command, int background);
 
 /**
  * @brief Executes a sequence of commands connected by pipes.
  * 
  * This function sets up pipes between commands and forks processes to execute them.
- * It handles redirections for the final command in the sequence if specified.
+ * Redirections of each stage are applied after the pipes, so they take precedence.
+ * A last stage that is a builtin not changing the shell (secho, sfree, ...) runs in the
+ * shell reading the last pipe. All the stages form one job, waited for unless the pipeline ends with '&'.
+ * The status of every stage is kept in $PIPESTATUS.
  * 
- * @param commands Array of strings containing commands separated by pipes.
- * @param num_pipes Number of pipes connecting the commands.
- * @param redirections Bitmask indicating the types of redirections to apply.
- * @param Target_files Array of strings containing filenames for redirection.
+ * @param pipeline The parsed pipeline.
+ * @return int Exit status of the last stage, or with pipefail (sset -o pipefail) of the last
+ *         stage that failed (S_EXIT_SUCCESS for a background job).
  */
-int Execute_Piped_Commands(char **commands, int num_pipes, int redirections, char Target_files[NUM_OF_STREAMS][MAX_FILE_NAME_SIZE]);
+int Execute_Piped_Commands(Pipeline *pipeline);
 
 /**
- * @brief Parses a command string into individual commands separated by pipes.
+ * @brief Executes all the pipelines of a parsed command line.
  * 
- * This function splits the command string into separate commands based on the pipe character.
+ * Pipelines separated by ';' always run, '&&' runs the next pipeline only if the previous
+ * one succeeded and '||' only if it failed. The words of a pipeline are expanded right
+ * before it runs (see Expand_Pipeline()), and its status is stored as $?.
+ * With errexit (-e or sset -o errexit) the shell exits when a pipeline fails and its
+ * status is not tested by a following '&&' or '||'.
  * 
- * @param command The command string containing multiple commands separated by pipes.
- * @param commands Array of strings to store the parsed commands.
- * @return int Number of commands parsed.
+ * @param list The parsed command line.
+ * @return int Exit status of the last executed pipeline.
  */
-int Parse_Pipes(char *command, char **commands);
+int Execute_Command_List(CommandList *list);
 
 /**
- * @brief Searches for and handles redirection operators in the command string.
+ * @brief Applies the redirections of a command in order.
  * 
- * This function identifies input, output, and error redirection operators in the command string
- * and updates the command string and target files accordingly.
+ * Each target file is opened (truncated, or appended to with >>) and duplicated onto the
+ * redirected file descriptor, n>&m copies m, n>&- closes n, and here-documents and
+ * here-strings are read from an in-memory file (see Open_Here_Document()).
  * 
- * @param command The command string to be checked for redirection operators.
- * @param target_files Array of strings to store filenames for redirection.
- * @return int Bitmask indicating the types of redirections found.
+ * @param redirections Linked list of redirections (may be NULL).
+ * @return int Status code indicating success or failure of the redirection.
  */
-int SearchForRedirections(char* command, char target_files[NUM_OF_STREAMS][MAX_FILE_NAME_SIZE]);
+int Redirect(const Redirection *redirections);
 
 /**
- * @brief Redirects standard input, output, and error streams as specified.
+ * @brief Opens a descriptor from which the text of a here-document or here-string is read.
  * 
- * This function applies redirection based on the specified redirections and target files.
+ * The text is written to a memfd (no temporary file is created) and the descriptor is
+ * rewound. Without memfd support a pipe is used, which only works for text that fits
+ * in the pipe buffer. The descriptor has O_CLOEXEC set.
  * 
- * @param redirections Bitmask indicating the types of redirections to apply.
- * @param target_files Array of strings containing filenames for redirection.
- * @return int Status code indicating success or failure of the redirection.
+ * @param body The text.
+ * @return int The descriptor, or -1 on failure (errno is set).
  */
-int Redirect(int redirections, char target_files[NUM_OF_STREAMS][MAX_FILE_NAME_SIZE]);
+int Open_Here_Document(const char *body);
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,351 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        variables.c            *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+/*****************************            Includes               ********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "variables.h"
+#include "../helper_functions/helpers.h"
+#include "../exit_status.h"
+#include "../path_cache/path_cache.h"
+
+/*****************************            Types                  ********************************/
+
+/* One slot of the open-addressing table. An empty slot has name == NULL. */
+typedef struct {
+    char *name;
+    char *value;
+    size_t name_len;
+    uint32_t hash;
+} VariableEntry;
+
+/*****************************        Global Variables           ********************************/
+
+static VariableEntry *table = NULL;
+static size_t table_size = 0;           /* Number of slots (power of 2) */
+static size_t table_count = 0;          /* Number of used slots */
+
+static int pending_changes = 0;         /* Updates not yet written to the file */
+static pid_t owner_pid = 0;             /* Only the shell process persists the table, not its children */
+static char var_file_path[PATH_MAX + sizeof(VAR_FILE)] = VAR_FILE;   /* cwd + "/" + VAR_FILE */
+static int last_exit_status = 0;        /* Value of $? */
+static char *pipe_status = NULL;        /* Value of $PIPESTATUS */
+static size_t pipe_status_size = 0;
+static int shell_options = 0;
+
+/*****************************        Static Functions           ********************************/
+
+/* FNV-1a hash of the first len characters of name */
+static uint32_t hash_name(const char *name, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* Returns the slot holding name, or the empty slot where it should be inserted */
+static VariableEntry *find_slot(VariableEntry *slots, size_t size, const char *name, size_t len, uint32_t hash)
+{
+    size_t mask = size - 1;
+    size_t i = hash & mask;
+
+    while (slots[i].name != NULL) {
+        if (slots[i].hash == hash && slots[i].name_len == len && memcmp(slots[i].name, name, len) == 0) {
+            return &slots[i];
+        }
+        i = (i + 1) & mask;             /* Linear probing */
+    }
+    return &slots[i];
+}
+
+static int grow_table(void)
+{
+    size_t new_size = table_size ? table_size * 2 : VAR_TABLE_INITIAL_SIZE;
+    VariableEntry *new_table = calloc(new_size, sizeof(VariableEntry));
+    if (new_table == NULL) {
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    /* Re-insert the existing entries, the hashes are cached so no string is re-read */
+    for (size_t i = 0; i < table_size; i++) {
+        if (table[i].name != NULL) {
+            *find_slot(new_table, new_size, table[i].name, table[i].name_len, table[i].hash) = table[i];
+        }
+    }
+
+    free(table);
+    table = new_table;
+    table_size = new_size;
+    return S_EXIT_SUCCESS;
+}
+
+/* Inserts or updates a variable without touching the pending changes counter */
+static int store_variable(const char *name, size_t name_len, const char *value)
+{
+    /* Keep the load factor under 1/2 so probe sequences stay short */
+    if ((table_count + 1) * 2 > table_size && grow_table() != S_EXIT_SUCCESS) {
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    uint32_t hash = hash_name(name, name_len);
+    VariableEntry *slot = find_slot(table, table_size, name, name_len, hash);
+
+    char *new_value = strdup(value);
+    if (new_value == NULL) {
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    if (slot->name == NULL) {
+        slot->name = strndup(name, name_len);
+        if (slot->name == NULL) {
+            free(new_value);
+            return S_EXIT_MEM_ALLOC;
+        }
+        slot->name_len = name_len;
+        slot->hash = hash;
+        table_count++;
+    } else {
+        free(slot->value);
+    }
+
+    slot->value = new_value;
+    return S_EXIT_SUCCESS;
+}
+
+static void flush_variables_at_exit(void)
+{
+    flush_variables();
+}
+
+/*****************************        Public Functions           ********************************/
+
+int load_variables(void)
+{
+    owner_pid = getpid();
+
+    /* Remember the absolute path, the working directory changes with scd */
+    char cwd[PATH_MAX];
+    if (getcwd(cwd, sizeof(cwd)) != NULL) {
+        snprintf(var_file_path, sizeof(var_file_path), "%s/%s", cwd, VAR_FILE);
+    }
+
+    if (table == NULL && grow_table() != S_EXIT_SUCCESS) {
+        perror("Failed to allocate memory");
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    atexit(flush_variables_at_exit);
+
+    int fd = open(var_file_path, O_RDONLY);
+    if (fd < 0) {
+        return S_EXIT_SUCCESS;          /* No variables saved yet */
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) < 0) {
+        perror("Failed to read file");
+        close(fd);
+        return S_EXIT_READ_FILE_FAIL;
+    }
+
+    char *file_content = malloc(file_stat.st_size + 1);
+    if (!file_content) {
+        perror("Failed to allocate memory");
+        close(fd);
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    ssize_t bytes_read = read(fd, file_content, file_stat.st_size);
+    close(fd);
+    if (bytes_read < 0) {
+        perror("Failed to read file");
+        free(file_content);
+        return S_EXIT_READ_FILE_FAIL;
+    }
+    file_content[bytes_read] = '\0';
+
+    /* Each line has the form NAME=value */
+    char *line_start = file_content;
+    while (*line_start != '\0') {
+        char *line_end = strchr(line_start, '\n');
+        if (line_end) {
+            *line_end = '\0';
+        }
+
+        char *eq_pos = strchr(line_start, '=');
+        if (eq_pos && eq_pos != line_start) {
+            *eq_pos = '\0';
+            store_variable(line_start, eq_pos - line_start, eq_pos + 1);
+        }
+
+        if (!line_end) {
+            break;
+        }
+        line_start = line_end + 1;
+    }
+
+    free(file_content);
+    return S_EXIT_SUCCESS;
+}
+
+int flush_variables(void)
+{
+    if (pending_changes == 0 || getpid() != owner_pid) {
+        return S_EXIT_SUCCESS;
+    }
+
+    /* Build the whole snapshot in memory so it is written with a single write() */
+    size_t total = 0;
+    for (size_t i = 0; i < table_size; i++) {
+        if (table[i].name != NULL) {
+            total += table[i].name_len + strlen(table[i].value) + 2;   /* '=' and '\n' */
+        }
+    }
+
+    char *snapshot = malloc(total + 1);
+    if (snapshot == NULL) {
+        perror("Failed to allocate memory");
+        return S_EXIT_MEM_ALLOC;
+    }
+
+    size_t offset = 0;
+    for (size_t i = 0; i < table_size; i++) {
+        if (table[i].name != NULL) {
+            offset += sprintf(snapshot + offset, "%s=%s\n", table[i].name, table[i].value);
+        }
+    }
+
+    char temp_path[sizeof(var_file_path) + sizeof(".tmp")];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", var_file_path);
+
+    int temp_fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (temp_fd < 0) {
+        perror("Failed to open temp file");
+        free(snapshot);
+        return S_EXIT_OPEN_FILE_FAILED;
+    }
+
+    ssize_t written = write(temp_fd, snapshot, offset);
+    free(snapshot);
+    close(temp_fd);
+
+    /* Replace the original file atomically */
+    if (written != (ssize_t)offset || rename(temp_path, var_file_path) < 0) {
+        perror("Failed to save variables");
+        unlink(temp_path);
+        return S_EXIT_OPEN_FILE_FAILED;
+    }
+
+    pending_changes = 0;
+    return S_EXIT_SUCCESS;
+}
+
+void set_variable(const char *name, const char *value)
+{
+    if (table == NULL && grow_table() != S_EXIT_SUCCESS) {
+        perror("Failed to allocate memory");
+        return;
+    }
+
+    if (store_variable(name, strlen(name), value) != S_EXIT_SUCCESS) {
+        perror("Failed to allocate memory");
+        return;
+    }
+
+    /* Programs are searched in the environment's PATH => export it, the cached locations are stale */
+    if (strcmp(name, "PATH") == 0) {
+        if (setenv("PATH", value, 1) < 0) {
+            perror("setenv");
+        }
+        path_cache_clear();
+    }
+
+    if (++pending_changes >= VAR_FLUSH_THRESHOLD) {
+        flush_variables();
+    }
+}
+
+const char *lookup_variable(const char *name, size_t name_len)
+{
+    if (table == NULL) {
+        return NULL;
+    }
+
+    VariableEntry *slot = find_slot(table, table_size, name, name_len, hash_name(name, name_len));
+    return slot->name ? slot->value : NULL;
+}
+
+const char *get_variable(const char *name)
+{
+    return lookup_variable(name, strlen(name));
+}
+
+void set_last_exit_status(int status)
+{
+    last_exit_status = status;
+}
+
+int get_last_exit_status(void)
+{
+    return last_exit_status;
+}
+
+void set_pipe_status(const int *statuses, int count)
+{
+    /* Exit statuses are at most 3 digits, plus a separator */
+    size_t needed = (size_t)count * 4 + 1;
+    if (needed > pipe_status_size) {
+        char *new_status = realloc(pipe_status, needed);
+        if (new_status == NULL) {
+            perror("Failed to allocate memory");
+            return;
+        }
+        pipe_status = new_status;
+        pipe_status_size = needed;
+    }
+
+    size_t offset = 0;
+    pipe_status[0] = '\0';
+    for (int i = 0; i < count; i++) {
+        offset += snprintf(pipe_status + offset, pipe_status_size - offset, i ? " %d" : "%d", statuses[i] & 0xFF);
+    }
+}
+
+const char *get_pipe_status(void)
+{
+    return pipe_status ? pipe_status : "0";
+}
+
+void set_shell_option(int option, int enabled)
+{
+    if (enabled) {
+        shell_options |= option;
+    } else {
+        shell_options &= ~option;
+    }
+}
+
+int get_shell_option(int option)
+{
+    return (shell_options & option) != 0;
+}
@@ -0,0 +1,117 @@
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/**************************      SWC:        variables.h            *****************************/
+/**************************      Author:     Abdelrahman Sabry      *****************************/
+/**************************      Date:       17 Oct                 *****************************/
+/**************************      Version:    1                      *****************************/
+/************************************************************************************************/
+/************************************************************************************************/
+/************************************************************************************************/
+
+#ifndef VARIABLES_H
+#define VARIABLES_H
+
+#include <stddef.h>
+
+/* File used to persist the shell variables between sessions */
+#define VAR_FILE                "variables.txt"
+
+/* Initial number of slots in the variables table (must be a power of 2) */
+#define VAR_TABLE_INITIAL_SIZE  64
+
+/* Number of set_variable() calls batched before the table is written back to VAR_FILE */
+#define VAR_FLUSH_THRESHOLD     16
+
+/* Shell options, changed with `sset -o name` / `sset +o name` */
+#define SHELL_OPTION_PIPEFAIL   0x01    /* A pipeline fails if any of its stages fails */
+#define SHELL_OPTION_ERREXIT    0x02    /* Exit when a command fails (-e) */
+#define SHELL_OPTION_INTERACTIVE 0x04   /* Commands are typed at a prompt, not read from a script */
+
+/**
+ * @brief Loads the variables file into the in-memory variables table.
+ *
+ * The file is read once at startup; after that every lookup and update is served from
+ * an open-addressing hash table. The absolute path of VAR_FILE is remembered so that
+ * later `scd` calls do not change where the variables are persisted, and a snapshot is
+ * registered to be written when the shell exits.
+ *
+ * @return int Returns S_EXIT_SUCCESS on success, or S_EXIT_MEM_ALLOC / S_EXIT_READ_FILE_FAIL.
+ */
+int load_variables(void);
+
+/**
+ * @brief Writes all the variables to VAR_FILE if any of them changed since the last flush.
+ *
+ * The snapshot is written to a temporary file and renamed over VAR_FILE, so a crash
+ * leaves either the old or the new content but never a partial file.
+ *
+ * @return int Returns S_EXIT_SUCCESS on success, otherwise S_EXIT_OPEN_FILE_FAILED.
+ */
+int flush_variables(void);
+
+/**
+ * @brief Adds or updates a variable in the variables table.
+ *
+ * The change is persisted lazily: the file is rewritten every VAR_FLUSH_THRESHOLD updates
+ * and when the shell exits. PATH is also exported to the environment, where programs are
+ * looked up, and the command path cache is cleared.
+ *
+ * @param name The variable name.
+ * @param value The variable value.
+ */
+void set_variable(const char *name, const char *value);
+
+/**
+ * @brief Retrieves the value of a variable.
+ *
+ * @param name The variable name.
+ * @return const char* The value (owned by the table, valid until the variable changes),
+ *         or NULL if the variable does not exist.
+ */
+const char *get_variable(const char *name);
+
+/**
+ * @brief Looks up a variable without copying its value.
+ *
+ * @param name The variable name (does not need to be null-terminated).
+ * @param name_len Number of characters of the name.
+ * @return const char* The value stored in the table, or NULL if the variable does not exist.
+ *         The pointer stays valid until the variable is set again.
+ */
+const char *lookup_variable(const char *name, size_t name_len);
+
+/**
+ * @brief Records the exit status of the last executed command (the value of `$?`).
+ */
+void set_last_exit_status(int status);
+
+/**
+ * @brief Returns the exit status of the last executed command.
+ */
+int get_last_exit_status(void);
+
+/**
+ * @brief Records the exit status of every stage of the last pipeline (the value of `$PIPESTATUS`).
+ *
+ * @param statuses Exit status of each stage, in pipeline order.
+ * @param count Number of stages.
+ */
+void set_pipe_status(const int *statuses, int count);
+
+/**
+ * @brief Returns the exit statuses of the last pipeline separated by spaces (e.g. "0 1 0").
+ */
+const char *get_pipe_status(void);
+
+/**
+ * @brief Enables or disables a shell option (SHELL_OPTION_*).
+ */
+void set_shell_option(int option, int enabled);
+
+/**
+ * @brief Returns 1 if the shell option is enabled, 0 otherwise.
+ */
+int get_shell_option(int option);
+
+#endif